@@ -143,7 +143,8 @@ namespace vmod::bindings::ffi
 			vscript::variant &arg_var{sargs[i]};
 			arg_var.free();
 
-			vmod::ffi::ptr_to_script_var(args[i], arg_type, arg_var);
+			//args outlive every script call made below so vectors dont need copies
+			vmod::ffi::ptr_to_script_var(args[i], arg_type, arg_var, true);
 		}
 
 		if(has_ret) {
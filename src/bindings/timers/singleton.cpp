@@ -0,0 +1,169 @@
+#include "singleton.hpp"
+#include "../../main.hpp"
+#include <cmath>
+
+namespace vmod::bindings::timers
+{
+	vscript::singleton_class_desc<singleton> singleton::desc{"timers"};
+
+	static singleton timers_;
+
+	singleton &singleton::instance() noexcept
+	{ return timers_; }
+
+	singleton::~singleton() noexcept {}
+
+	bool singleton::bindings() noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		desc.func(&singleton::script_once, "script_once"sv, "once"sv)
+		.desc("[timer](delay, timer_callback|callback)"sv);
+
+		desc.func(&singleton::script_every, "script_every"sv, "every"sv)
+		.desc("[timer](interval, timer_callback|callback)"sv);
+
+		if(!singleton_base::bindings(&desc)) {
+			return false;
+		}
+
+		return true;
+	}
+
+	void singleton::unbindings() noexcept
+	{
+		singleton_base::unbindings();
+	}
+
+	std::uint64_t singleton::to_ticks(float seconds) const noexcept
+	{
+		float interval{sv_globals->interval_per_tick};
+		if(interval <= 0.0f || seconds <= interval) {
+			return 1;
+		}
+
+		//clamp before the cast, anything past max_ticks is out of range for it
+		double ticks{std::ceil(static_cast<double>(seconds) / static_cast<double>(interval))};
+		if(!(ticks < static_cast<double>(max_ticks))) {
+			return max_ticks;
+		}
+
+		return static_cast<std::uint64_t>(ticks);
+	}
+
+	float singleton::to_seconds(std::uint64_t ticks) const noexcept
+	{ return static_cast<float>(ticks) * sv_globals->interval_per_tick; }
+
+	void singleton::schedule(timer &tmr) noexcept
+	{
+		tmr.node.unlink();
+
+		std::uint64_t expires{tmr.expires > now ? tmr.expires : now};
+		std::uint64_t delta{expires - now};
+
+		if(delta < near_size) {
+			tmr.node.link_back(near_slots[expires & near_mask]);
+			return;
+		}
+
+		for(std::size_t i{0}; i < far_levels; ++i) {
+			std::size_t shift{near_bits + (far_bits * i)};
+			if(delta < (std::uint64_t{1} << (shift + far_bits)) || i == (far_levels-1)) {
+				//past the last level it parks at the furthest slot and gets rechecked when that cascades
+				if(i == (far_levels-1) && delta >= (std::uint64_t{1} << (shift + far_bits))) {
+					expires = now + (std::uint64_t{1} << (shift + far_bits)) - 1;
+				}
+
+				tmr.node.link_back(far_slots[i][(expires >> shift) & far_mask]);
+				return;
+			}
+		}
+	}
+
+	void singleton::cascade(detail::wheel_node &slot) noexcept
+	{
+		detail::wheel_node pending;
+		pending.splice(slot);
+
+		while(pending.linked()) {
+			schedule(*pending.next->owner);
+		}
+	}
+
+	void singleton::frame() noexcept
+	{
+		std::uint64_t tick{now};
+
+		if((tick & near_mask) == 0) {
+			for(std::size_t i{0}; i < far_levels; ++i) {
+				std::size_t shift{near_bits + (far_bits * i)};
+				std::size_t idx{static_cast<std::size_t>((tick >> shift) & far_mask)};
+
+				cascade(far_slots[i][idx]);
+
+				if(idx != 0) {
+					break;
+				}
+			}
+		}
+
+		detail::wheel_node expired;
+		expired.splice(near_slots[tick & near_mask]);
+
+		++now;
+
+		//callbacks can free, cancel or restart any timer, all of those just unlink from this list
+		while(expired.linked()) {
+			timer *tmr{expired.next->owner};
+			tmr->node.unlink();
+
+			if(tmr->repeat) {
+				tmr->expires = tick + tmr->interval;
+				schedule(*tmr);
+			}
+
+			tmr->firing = true;
+			tmr->callback(tmr->instance_);
+			tmr->firing = false;
+
+			if(tmr->free_pending) {
+				tmr->free_pending = false;
+				tmr->free();
+			}
+		}
+	}
+
+	vscript::instance_handle_ref singleton::create_timer(float delay, vscript::func_handle_ref callback, bool repeat) noexcept
+	{
+		gsdk::IScriptVM *vm{vscript::vm()};
+
+		if(!callback) {
+			vm->RaiseException("vmod: invalid callback");
+			return nullptr;
+		}
+
+		plugin::typed_function<void(vscript::instance_handle_ref)> callback_func;
+		if(!plugin::read_function(callback, callback_func)) {
+			vm->RaiseException("vmod: invalid callback");
+			return nullptr;
+		}
+
+		if(!std::isfinite(delay) || delay < 0.0f) {
+			vm->RaiseException("vmod: invalid delay");
+			return nullptr;
+		}
+
+		timer *tmr{new timer{to_ticks(delay), repeat, std::move(callback_func)}};
+
+		if(!tmr->initialize()) {
+			delete tmr;
+			vm->RaiseException("vmod: failed to register timer instance");
+			return nullptr;
+		}
+
+		tmr->expires = now + tmr->interval - 1;
+		schedule(*tmr);
+
+		return tmr->instance_;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../../vscript/vscript.hpp"
+#include "../../vscript/variant.hpp"
+#include "../../vscript/singleton_class_desc.hpp"
+#include "../singleton.hpp"
+
+#include <array>
+#include <cstdint>
+#include "timer.hpp"
+
+namespace vmod::bindings::timers
+{
+	class singleton final : public singleton_base
+	{
+		friend class vmod::main;
+		friend class timer;
+		friend void write_docs(const std::filesystem::path &) noexcept;
+
+	public:
+		inline singleton() noexcept
+			: singleton_base{"timers"}
+		{
+		}
+
+		~singleton() noexcept override;
+
+		bool bindings() noexcept;
+		void unbindings() noexcept;
+
+		static singleton &instance() noexcept;
+
+	private:
+		static vscript::singleton_class_desc<singleton> desc;
+
+		static constexpr const std::size_t near_bits{8};
+		static constexpr const std::size_t near_size{1 << near_bits};
+		static constexpr const std::uint64_t near_mask{near_size-1};
+		static constexpr const std::size_t far_bits{6};
+		static constexpr const std::size_t far_size{1 << far_bits};
+		static constexpr const std::uint64_t far_mask{far_size-1};
+		static constexpr const std::size_t far_levels{3};
+
+		//keeps now + interval far from wrapping no matter how long the server runs
+		static constexpr const std::uint64_t max_ticks{std::uint64_t{1} << 48};
+
+		//turns the wheel one tick, only the expiring slot and the occasional cascade are touched
+		void frame() noexcept;
+
+		void schedule(timer &tmr) noexcept;
+		void cascade(detail::wheel_node &slot) noexcept;
+
+		std::uint64_t to_ticks(float seconds) const noexcept;
+		float to_seconds(std::uint64_t ticks) const noexcept;
+
+		vscript::instance_handle_ref create_timer(float delay, vscript::func_handle_ref callback, bool repeat) noexcept;
+
+		inline vscript::instance_handle_ref script_once(float delay, vscript::func_handle_ref callback) noexcept
+		{ return create_timer(delay, callback, false); }
+		inline vscript::instance_handle_ref script_every(float interval, vscript::func_handle_ref callback) noexcept
+		{ return create_timer(interval, callback, true); }
+
+		std::array<detail::wheel_node, near_size> near_slots;
+		std::array<std::array<detail::wheel_node, far_size>, far_levels> far_slots;
+
+		//the next tick frame will process
+		std::uint64_t now{0};
+	};
+}
@@ -0,0 +1,96 @@
+#include "timer.hpp"
+#include "singleton.hpp"
+
+namespace vmod::bindings::timers
+{
+	vscript::class_desc<timer> timer::desc{"timers::timer"};
+
+	timer::timer(std::uint64_t interval_, bool repeat_, plugin::typed_function<void(vscript::instance_handle_ref)> &&callback_) noexcept
+		: interval{interval_}, repeat{repeat_}, callback{std::move(callback_)}
+	{
+		node.owner = this;
+	}
+
+	timer::~timer() noexcept
+	{
+		node.unlink();
+	}
+
+	void timer::free() noexcept
+	{
+		node.unlink();
+
+		//the callback is still running, the wheel frees it once it returns
+		if(firing) {
+			free_pending = true;
+			return;
+		}
+
+		delete this;
+	}
+
+	void timer::plugin_unloaded() noexcept
+	{
+		node.unlink();
+
+		if(!firing) {
+			callback.free();
+		}
+
+		plugin::owned_instance::plugin_unloaded();
+	}
+
+	bool timer::bindings() noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		desc.func(&timer::script_cancel, "script_cancel"sv, "cancel"sv)
+		.desc("stops the timer without freeing it"sv);
+
+		desc.func(&timer::script_restart, "script_restart"sv, "restart"sv)
+		.desc("schedules the timer again a full interval from now"sv);
+
+		desc.func(&timer::script_active, "script_active"sv, "active"sv);
+
+		desc.func(&timer::script_remaining, "script_remaining"sv, "remaining"sv)
+		.desc("seconds until the timer fires, zero when inactive"sv);
+
+		desc.func(&timer::script_repeating, "script_repeating"sv, "repeating"sv);
+
+		desc.dtor();
+
+		if(!plugin::owned_instance::register_class(&desc)) {
+			error("vmod: failed to register timers timer script class\n"sv);
+			return false;
+		}
+
+		return true;
+	}
+
+	void timer::unbindings() noexcept
+	{
+
+	}
+
+	void timer::script_cancel() noexcept
+	{ node.unlink(); }
+
+	void timer::script_restart() noexcept
+	{
+		singleton &wheel{singleton::instance()};
+
+		expires = wheel.now + interval - 1;
+		wheel.schedule(*this);
+	}
+
+	float timer::script_remaining() const noexcept
+	{
+		if(!node.linked()) {
+			return 0.0f;
+		}
+
+		singleton &wheel{singleton::instance()};
+
+		return wheel.to_seconds((expires + 1) - wheel.now);
+	}
+}
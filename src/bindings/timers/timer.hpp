@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../../plugin.hpp"
+#include <cstdint>
+
+namespace vmod::bindings::timers
+{
+	class timer;
+
+	namespace detail
+	{
+		//intrusive circular list so linking and unlinking never allocate or search
+		struct wheel_node final
+		{
+			inline wheel_node() noexcept
+				: prev{this}, next{this}
+			{
+			}
+
+			inline bool linked() const noexcept
+			{ return next != this; }
+
+			inline void link_back(wheel_node &head) noexcept
+			{
+				prev = head.prev;
+				next = &head;
+				head.prev->next = this;
+				head.prev = this;
+			}
+
+			inline void unlink() noexcept
+			{
+				prev->next = next;
+				next->prev = prev;
+				prev = this;
+				next = this;
+			}
+
+			//moves every node of other to the back of this
+			inline void splice(wheel_node &other) noexcept
+			{
+				if(!other.linked()) {
+					return;
+				}
+
+				other.next->prev = prev;
+				prev->next = other.next;
+				other.prev->next = this;
+				prev = other.prev;
+
+				other.prev = &other;
+				other.next = &other;
+			}
+
+			wheel_node *prev;
+			wheel_node *next;
+			timer *owner{nullptr};
+
+		private:
+			wheel_node(const wheel_node &) = delete;
+			wheel_node &operator=(const wheel_node &) = delete;
+			wheel_node(wheel_node &&) = delete;
+			wheel_node &operator=(wheel_node &&) = delete;
+		};
+	}
+
+	class timer final : public plugin::owned_instance
+	{
+		friend class singleton;
+		friend void write_docs(const std::filesystem::path &) noexcept;
+
+	public:
+		timer(std::uint64_t interval_, bool repeat_, plugin::typed_function<void(vscript::instance_handle_ref)> &&callback_) noexcept;
+		~timer() noexcept override;
+
+		static bool bindings() noexcept;
+		static void unbindings() noexcept;
+
+	private:
+		static vscript::class_desc<timer> desc;
+
+		void free() noexcept override final;
+
+		void plugin_unloaded() noexcept override final;
+
+		inline bool initialize() noexcept
+		{ return register_instance(&desc, this); }
+
+		void script_cancel() noexcept;
+		void script_restart() noexcept;
+		inline bool script_active() const noexcept
+		{ return node.linked(); }
+		float script_remaining() const noexcept;
+		inline bool script_repeating() const noexcept
+		{ return repeat; }
+
+		detail::wheel_node node;
+
+		std::uint64_t interval;
+		std::uint64_t expires{0};
+		bool repeat;
+
+		bool firing{false};
+		bool free_pending{false};
+
+		plugin::typed_function<void(vscript::instance_handle_ref)> callback;
+
+	private:
+		timer() = delete;
+		timer(const timer &) = delete;
+		timer &operator=(const timer &) = delete;
+		timer(timer &&) = delete;
+		timer &operator=(timer &&) = delete;
+	};
+}
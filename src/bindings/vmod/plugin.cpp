@@ -19,6 +19,18 @@ namespace vmod
 		desc.func(&plugin::script_lookup_value, "script_lookup_value"sv, "lookup_value"sv)
 		.desc("(name)"sv);
 
+		desc.func(&plugin::script_exec_time, "script_exec_time"sv, "exec_time"sv)
+		.desc("total milliseconds spent running this plugin's script code"sv);
+
+		desc.func(&plugin::script_frame_exec_time, "script_frame_exec_time"sv, "frame_exec_time"sv)
+		.desc("milliseconds spent running this plugin's script code in the last frame"sv);
+
+		desc.func(&plugin::script_max_frame_exec_time, "script_max_frame_exec_time"sv, "max_frame_exec_time"sv)
+		.desc("most milliseconds this plugin's script code has taken in a single frame"sv);
+
+		desc.func(&plugin::script_exec_calls, "script_exec_calls"sv, "exec_calls"sv)
+		.desc("number of script calls made into this plugin"sv);
+
 		if(!vm->RegisterClass(&desc)) {
 			error("vmod: failed to register plugin script class\n"sv);
 			return false;
@@ -156,4 +168,16 @@ namespace vmod
 
 	void plugin::shared_instance::script_delete() noexcept
 	{ remove_plugin(); }
+
+	float plugin::script_exec_time() const noexcept
+	{ return std::chrono::duration<float, std::milli>{exec_stats_.total}.count(); }
+
+	float plugin::script_frame_exec_time() const noexcept
+	{ return std::chrono::duration<float, std::milli>{last_frame_exec_time()}.count(); }
+
+	float plugin::script_max_frame_exec_time() const noexcept
+	{ return std::chrono::duration<float, std::milli>{exec_stats_.max_frame}.count(); }
+
+	std::size_t plugin::script_exec_calls() const noexcept
+	{ return exec_stats_.calls; }
 }
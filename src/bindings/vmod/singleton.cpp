@@ -12,6 +12,7 @@
 #include "../ffi/bindings.hpp"
 #include "../ent/bindings.hpp"
 #include "../net/bindings.hpp"
+#include "../timers/bindings.hpp"
 
 namespace vmod
 {
@@ -267,6 +268,10 @@ namespace vmod
 			return false;
 		}
 
+		if(!bindings::timers::bindings()) {
+			return false;
+		}
+
 		if(!bindings::strtables::bindings()) {
 			return false;
 		}
@@ -333,6 +338,10 @@ namespace vmod
 			return false;
 		}
 
+		if(!bindings::timers::create_get()) {
+			return false;
+		}
+
 		if(!create_get()) {
 			return false;
 		}
@@ -414,6 +423,10 @@ namespace vmod
 		file += "namespace net;\n"sv;
 		bindings::net::write_docs(dir);
 
+		bindings::docs::ident(file, 1);
+		file += "namespace timers;\n"sv;
+		bindings::timers::write_docs(dir);
+
 		file += '}';
 
 		std::filesystem::path doc_path{dir};
@@ -459,6 +472,8 @@ namespace vmod
 
 		bindings::net::unbindings();
 
+		bindings::timers::unbindings();
+
 		plugin::unbindings();
 
 		mod::unbindings();
@@ -149,7 +149,18 @@ namespace vmod::ffi
 		}
 	}
 
-	void ptr_to_script_var(void *ptr, ffi_type *type, gsdk::ScriptVariant_t &var) noexcept
+	template <typename T>
+	static void vector_to_script_var(T *vec, T *&dst, gsdk::ScriptVariant_t &var, bool borrow) noexcept
+	{
+		if(borrow) {
+			dst = vec;
+		} else {
+			dst = new T{*vec};
+			var.m_flags |= gsdk::SV_FREE;
+		}
+	}
+
+	void ptr_to_script_var(void *ptr, ffi_type *type, gsdk::ScriptVariant_t &var, bool borrow) noexcept
 	{
 		var.reset();
 
@@ -157,21 +168,17 @@ namespace vmod::ffi
 			var.m_object = (*static_cast<gsdk::CBaseEntity **>(ptr))->GetScriptInstance();
 			var.m_type = gsdk::FIELD_HSCRIPT;
 		} else if(type == &ffi_type_vector_ptr) {
-			var.m_vector = new gsdk::Vector{**static_cast<gsdk::Vector **>(ptr)};
+			vector_to_script_var(*static_cast<gsdk::Vector **>(ptr), var.m_vector, var, borrow);
 			var.m_type = gsdk::FIELD_VECTOR;
-			var.m_flags |= gsdk::SV_FREE;
 		} else if(type == &ffi_type_qangle_ptr) {
-			var.m_qangle = new gsdk::QAngle{**static_cast<gsdk::QAngle **>(ptr)};
+			vector_to_script_var(*static_cast<gsdk::QAngle **>(ptr), var.m_qangle, var, borrow);
 			var.m_type = gsdk::FIELD_QANGLE;
-			var.m_flags |= gsdk::SV_FREE;
 		} else if(type == &ffi_type_vector) {
-			var.m_vector = new gsdk::Vector{*static_cast<gsdk::Vector *>(ptr)};
+			vector_to_script_var(static_cast<gsdk::Vector *>(ptr), var.m_vector, var, borrow);
 			var.m_type = gsdk::FIELD_VECTOR;
-			var.m_flags |= gsdk::SV_FREE;
 		} else if(type == &ffi_type_qangle) {
-			var.m_qangle = new gsdk::QAngle{*static_cast<gsdk::QAngle *>(ptr)};
+			vector_to_script_var(static_cast<gsdk::QAngle *>(ptr), var.m_qangle, var, borrow);
 			var.m_type = gsdk::FIELD_QANGLE;
-			var.m_flags |= gsdk::SV_FREE;
 		} else if(type == &ffi_type_cstr) {
 			var.m_ccstr = *static_cast<const char **>(ptr);
 			var.m_type = gsdk::FIELD_CSTRING;
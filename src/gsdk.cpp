@@ -65,6 +65,8 @@ namespace vmod
 				GetGlobalLoggingSystem = reinterpret_cast<decltype(GetGlobalLoggingSystem)>(base() + offset);
 				#pragma GCC diagnostic pop
 			}
+
+			symbol_cache::drop_mangled_index(path);
 		} else {
 	#endif
 			warning("vmod: missing GetGlobalLoggingSystem func\n"sv);
@@ -325,6 +327,8 @@ namespace vmod
 				mfp_internal_t<bool, gsdk::IFileSystem, const char *, const char *> internal{reinterpret_cast<uintptr_t>(base() + offset)};
 				gsdk::IFileSystem::RemoveVPKFile_ptr = internal.func;
 			}
+
+			symbol_cache::drop_mangled_index(path);
 		}
 	#endif
 
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include "utlmemory.hpp"
+
+namespace gsdk
+{
+	class CUtlBuffer;
+
+	using UtlBufferOverflowFunc_t = bool(CUtlBuffer::*)(int);
+
+	class CByteswap
+	{
+	public:
+		unsigned int m_bSwapBytes : 1;
+		unsigned int m_bBigEndian : 1;
+	};
+
+	class CUtlBuffer
+	{
+	public:
+		enum SeekType_t : int
+		{
+			SEEK_HEAD,
+			SEEK_CURRENT,
+			SEEK_TAIL
+		};
+
+		enum BufferFlags_t : unsigned char
+		{
+			TEXT_BUFFER =           (1 << 0),
+			EXTERNAL_GROWABLE =     (1 << 1),
+			CONTAINS_CRLF =         (1 << 2),
+			READ_ONLY =             (1 << 3),
+			AUTO_TABS_DISABLED =    (1 << 4)
+		};
+
+		enum ErrorFlags_t : unsigned char
+		{
+			PUT_OVERFLOW = (1 << 0),
+			GET_OVERFLOW = (1 << 1),
+			MAX_ERROR_FLAG = GET_OVERFLOW
+		};
+
+		~CUtlBuffer() noexcept = default;
+
+		inline bool is_valid() const noexcept
+		{ return m_Error == 0; }
+
+		inline std::size_t tell_put() const noexcept
+		{ return static_cast<std::size_t>(m_Put); }
+		inline std::size_t tell_get() const noexcept
+		{ return static_cast<std::size_t>(m_Get); }
+		inline std::size_t get_bytes_remaining() const noexcept
+		{ return static_cast<std::size_t>(m_nMaxPut - m_Get); }
+
+		//only buffers owning their memory grow, external memory is never reallocated
+		bool put(const void *data, std::size_t size) noexcept
+		{
+			if((m_Flags & READ_ONLY) || m_nOffset != 0) {
+				m_Error |= PUT_OVERFLOW;
+				return false;
+			}
+
+			std::size_t needed{static_cast<std::size_t>(m_Put) + size};
+			if(needed > m_Memory.size()) {
+				if(m_Memory.m_nGrowSize < 0) {
+					m_Error |= PUT_OVERFLOW;
+					return false;
+				}
+
+				std::size_t new_size{m_Memory.size() * 2};
+				if(new_size < needed) {
+					new_size = needed;
+				}
+
+				m_Memory.resize(new_size);
+			}
+
+			std::memcpy(m_Memory.data() + m_Put, data, size);
+
+			m_Put += static_cast<int>(size);
+			if(m_Put > m_nMaxPut) {
+				m_nMaxPut = m_Put;
+			}
+
+			return true;
+		}
+
+		bool get(void *data, std::size_t size) noexcept
+		{
+			if(m_nOffset != 0 || size > get_bytes_remaining()) {
+				m_Error |= GET_OVERFLOW;
+				return false;
+			}
+
+			std::memcpy(data, m_Memory.data() + m_Get, size);
+			m_Get += static_cast<int>(size);
+
+			return true;
+		}
+
+		template <typename T>
+		inline bool put(const T &value) noexcept
+		{ return put(&value, sizeof(T)); }
+		template <typename T>
+		inline bool get(T &value) noexcept
+		{ return get(&value, sizeof(T)); }
+
+		CUtlMemory<unsigned char> m_Memory;
+		int m_Get;
+		int m_Put;
+
+		unsigned char m_Error;
+		unsigned char m_Flags;
+		unsigned char m_Reserved;
+		int m_nTab;
+		int m_nMaxPut;
+		int m_nOffset;
+
+		UtlBufferOverflowFunc_t m_GetOverflowFunc;
+		UtlBufferOverflowFunc_t m_PutOverflowFunc;
+
+		CByteswap m_Byteswap;
+
+	private:
+		CUtlBuffer() = delete;
+		CUtlBuffer(const CUtlBuffer &) = delete;
+		CUtlBuffer &operator=(const CUtlBuffer &) = delete;
+		CUtlBuffer(CUtlBuffer &&) = delete;
+		CUtlBuffer &operator=(CUtlBuffer &&) = delete;
+	};
+}
@@ -10,7 +10,7 @@ namespace vmod
 		using namespace std::literals::string_literals;
 
 		dl = dlopen(path.c_str(),
-		#ifndef __VMOD_COMPILING_VTABLE_DUMPER
+		#if !defined __VMOD_COMPILING_VTABLE_DUMPER && !defined __VMOD_COMPILING_SYMBOL_BENCH
 			RTLD_LAZY|RTLD_LOCAL|RTLD_NODELETE|RTLD_NOLOAD
 		#else
 			RTLD_LAZY|RTLD_LOCAL
@@ -92,7 +92,7 @@ namespace vmod
 		using namespace std::literals::string_literals;
 
 		dl = dlopen(path.c_str(),
-		#ifndef __VMOD_COMPILING_VTABLE_DUMPER
+		#if !defined __VMOD_COMPILING_VTABLE_DUMPER && !defined __VMOD_COMPILING_SYMBOL_BENCH
 			RTLD_LAZY|RTLD_LOCAL|RTLD_NODELETE|RTLD_NOLOAD
 		#else
 			RTLD_LAZY|RTLD_LOCAL
@@ -10,6 +10,7 @@
 #include "gsdk/tier1/utlstring.hpp"
 #include <cstring>
 #include <dlfcn.h>
+#include <charconv>
 
 #ifdef __VMOD_USING_CUSTOM_VM
 	#include "vm/squirrel/vm.hpp"
@@ -44,6 +45,7 @@
 #include "bindings/ent/bindings.hpp"
 #include "bindings/ent/sendtable.hpp"
 #include "bindings/net/singleton.hpp"
+#include "bindings/timers/singleton.hpp"
 
 namespace vmod
 {
@@ -2049,6 +2051,10 @@ namespace vmod
 		mods_dir_ = root_dir_;
 		mods_dir_ /= "mods"sv;
 
+		bytecode_cache_dir_ = root_dir_;
+		bytecode_cache_dir_ /= "cache"sv;
+		bytecode_cache_dir_ /= "bytecode"sv;
+
 		{
 			gsdk::ICVarIterator *varit{cvar->FactoryInternalIterator()};
 			for(varit->SetFirst(); varit->IsValid(); varit->Next()) {
@@ -2431,6 +2437,47 @@ namespace vmod
 			}
 		);
 
+		vmod_plugin_stats.initialize("vmod_plugin_stats"sv,
+			[this](const gsdk::CCommand &args) noexcept -> void {
+				if(args.m_nArgc > 2) {
+					error("vmod: usage: vmod_plugin_stats [reset]\n");
+					return;
+				}
+
+				const bool reset{args.m_nArgc == 2 && std::strcmp(args.m_ppArgv[1], "reset") == 0};
+
+				if(!reset) {
+					info("vmod: %-40s %10s %10s %10s %10s %6s\n", "plugin", "total ms", "frame ms", "max ms", "calls", "errors");
+				}
+
+				for(const auto &mod_it : mods) {
+					for(const auto &pl_it : mod_it.second->plugins) {
+						plugin &pl{*pl_it.second};
+
+						if(reset) {
+							pl.reset_exec_stats();
+							continue;
+						}
+
+						const plugin::exec_stats_t &stats{pl.exec_stats()};
+
+						info("vmod: %-40s %10.3f %10.3f %10.3f %10zu %6zu\n",
+							pl.path().filename().c_str(),
+							static_cast<double>(std::chrono::duration<float, std::milli>{stats.total}.count()),
+							static_cast<double>(std::chrono::duration<float, std::milli>{pl.last_frame_exec_time()}.count()),
+							static_cast<double>(std::chrono::duration<float, std::milli>{stats.max_frame}.count()),
+							stats.calls, stats.errors);
+					}
+				}
+
+			#ifdef __VMOD_USING_CUSTOM_VM
+				if(!reset && vm_->GetLanguage() == gsdk::SL_SQUIRREL) {
+					info("vmod: watchdog aborts: %zu\n", static_cast<vm::squirrel *>(vm_)->watchdog_aborts());
+				}
+			#endif
+			}
+		);
+
 		vmod_refresh_mods.initialize("vmod_refresh_mods"sv,
 			[this](const gsdk::CCommand &) noexcept -> void {
 				vmod_unload_mods();
@@ -2451,6 +2498,184 @@ namespace vmod
 			}
 		);
 
+		vmod_purge_bytecode_cache.initialize("vmod_purge_bytecode_cache"sv,
+			[this](const gsdk::CCommand &args) noexcept -> void {
+				if(args.m_nArgc != 1) {
+					error("vmod: usage: vmod_purge_bytecode_cache\n");
+					return;
+				}
+
+				std::error_code ec;
+				std::uintmax_t removed{std::filesystem::remove_all(bytecode_cache_dir_, ec)};
+				if(ec) {
+					error("vmod: failed to purge bytecode cache '%s': '%s'\n"sv, bytecode_cache_dir_.c_str(), ec.message().c_str());
+					return;
+				}
+
+				info("vmod: purged %ju bytecode cache entries\n"sv, removed);
+			}
+		);
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		vmod_vm_gc_budget.initialize("vmod_vm_gc_budget"sv, 0);
+		vmod_vm_gc_interval.initialize("vmod_vm_gc_interval"sv, 5.0f);
+		vmod_vm_watchdog_ms.initialize("vmod_vm_watchdog_ms"sv, 0);
+
+		vmod_vm_gc_stats.initialize("vmod_vm_gc_stats"sv,
+			[this](const gsdk::CCommand &args) noexcept -> void {
+				if(args.m_nArgc != 1) {
+					error("vmod: usage: vmod_vm_gc_stats\n");
+					return;
+				}
+
+				if(vm_->GetLanguage() != gsdk::SL_SQUIRREL) {
+					error("vmod: gc stats are only available for squirrel\n"sv);
+					return;
+				}
+
+				const vm::squirrel &sq_vm{*static_cast<vm::squirrel *>(vm_)};
+				const vm::squirrel::gc_stats_t &stats{sq_vm.gc_stats()};
+
+				using usecs = std::chrono::duration<double, std::micro>;
+
+				info("vmod: gc stats:\n"sv);
+				info("vmod:   collections: %zu (%zu forced, %zu frames deferred)\n"sv, stats.collections, stats.forced, stats.deferred);
+				info("vmod:   objects freed: %zu (last %zu)\n"sv, stats.objects_freed, stats.last_freed);
+				info("vmod:   time: %.1fus total, %.1fus last, %.1fus max, %.1fus estimate\n"sv, usecs{stats.total_time}.count(), usecs{stats.last_time}.count(), usecs{stats.max_time}.count(), usecs{sq_vm.gc_estimate()}.count());
+				info("vmod:   script handles: %zu live, %zu capacity\n"sv, sq_vm.live_handles(), sq_vm.handle_capacity());
+				const vm::squirrel::key_stats_t &key_stats{sq_vm.key_cache_stats()};
+				info("vmod:   slot keys: %zu pointer hits, %zu content hits, %zu interned\n"sv, key_stats.pointer_hits, key_stats.content_hits, key_stats.misses);
+				std::size_t heap{vm::squirrel::heap_size()};
+				if(heap > 0) {
+					info("vmod:   vm heap: %zu bytes\n"sv, heap);
+				}
+			}
+		);
+
+		vmod_vm_profile_start.initialize("vmod_vm_profile_start"sv,
+			[this](const gsdk::CCommand &args) noexcept -> void {
+				if(args.m_nArgc > 2) {
+					error("vmod: usage: vmod_vm_profile_start [interval us]\n");
+					return;
+				}
+
+				if(vm_->GetLanguage() != gsdk::SL_SQUIRREL) {
+					error("vmod: profiling is only available for squirrel\n"sv);
+					return;
+				}
+
+				long long interval{1000};
+
+				if(args.m_nArgc == 2) {
+					std::string_view arg{args.m_ppArgv[1]};
+
+					std::from_chars_result fc_res{std::from_chars(arg.data(), arg.data() + arg.length(), interval)};
+					if(fc_res.ec != std::errc{} || interval <= 0) {
+						error("vmod: invalid interval '%s'\n"sv, args.m_ppArgv[1]);
+						return;
+					}
+				}
+
+				if(!static_cast<vm::squirrel *>(vm_)->start_profiling(std::chrono::microseconds{interval})) {
+					error("vmod: failed to start profiling\n"sv);
+					return;
+				}
+
+				info("vmod: profiling every %lldus\n"sv, interval);
+			}
+		);
+
+		vmod_vm_profile_stop.initialize("vmod_vm_profile_stop"sv,
+			[this](const gsdk::CCommand &args) noexcept -> void {
+				if(args.m_nArgc != 1) {
+					error("vmod: usage: vmod_vm_profile_stop\n");
+					return;
+				}
+
+				if(vm_->GetLanguage() != gsdk::SL_SQUIRREL) {
+					error("vmod: profiling is only available for squirrel\n"sv);
+					return;
+				}
+
+				vm::squirrel *sq_vm{static_cast<vm::squirrel *>(vm_)};
+				if(!sq_vm->profiling()) {
+					error("vmod: not profiling\n"sv);
+					return;
+				}
+
+				sq_vm->stop_profiling();
+
+				std::filesystem::path dump_dir{root_dir_/"dumps"sv};
+
+				std::error_code ec;
+				std::filesystem::create_directories(dump_dir, ec);
+
+				std::filesystem::path dump_path{dump_dir/"profile.folded"sv};
+				if(sq_vm->write_profile_collapsed(dump_path)) {
+					info("vmod: wrote collapsed stacks to '%s'\n"sv, dump_path.c_str());
+				}
+
+				sq_vm->print_profile_top(20);
+			}
+		);
+
+		vmod_vm_profile_top.initialize("vmod_vm_profile_top"sv,
+			[this](const gsdk::CCommand &args) noexcept -> void {
+				if(args.m_nArgc > 2) {
+					error("vmod: usage: vmod_vm_profile_top [count]\n");
+					return;
+				}
+
+				if(vm_->GetLanguage() != gsdk::SL_SQUIRREL) {
+					error("vmod: profiling is only available for squirrel\n"sv);
+					return;
+				}
+
+				std::size_t num{20};
+
+				if(args.m_nArgc == 2) {
+					std::string_view arg{args.m_ppArgv[1]};
+
+					std::from_chars_result fc_res{std::from_chars(arg.data(), arg.data() + arg.length(), num)};
+					if(fc_res.ec != std::errc{} || num == 0) {
+						error("vmod: invalid count '%s'\n"sv, args.m_ppArgv[1]);
+						return;
+					}
+				}
+
+				static_cast<vm::squirrel *>(vm_)->print_profile_top(num);
+			}
+		);
+
+		vmod_vm_bench_bindings.initialize("vmod_vm_bench_bindings"sv,
+			[this](const gsdk::CCommand &args) noexcept -> void {
+				if(args.m_nArgc > 2) {
+					error("vmod: usage: vmod_vm_bench_bindings [iterations]\n");
+					return;
+				}
+
+				if(vm_->GetLanguage() != gsdk::SL_SQUIRREL) {
+					error("vmod: binding benchmark is only available for squirrel\n"sv);
+					return;
+				}
+
+				std::size_t iterations{1000000};
+
+				if(args.m_nArgc == 2) {
+					std::string_view arg{args.m_ppArgv[1]};
+
+					std::from_chars_result fc_res{std::from_chars(arg.data(), arg.data() + arg.length(), iterations)};
+					if(fc_res.ec != std::errc{} || iterations == 0) {
+						error("vmod: invalid iterations '%s'\n"sv, args.m_ppArgv[1]);
+						return;
+					}
+				}
+
+				static_cast<vm::squirrel *>(vm_)->benchmark_bindings(iterations);
+			}
+		);
+	#endif
+
 		vmod_auto_dump_squirrel_ver.initialize("vmod_auto_dump_squirrel_ver"sv, false);
 
 		vmod_dump_squirrel_ver.initialize("vmod_dump_squirrel_ver"sv,
@@ -3460,6 +3685,12 @@ namespace vmod
 
 		std::filesystem::path dir_name{dir.filename()};
 
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm_->GetLanguage() == gsdk::SL_SQUIRREL) {
+			static_cast<vm::squirrel *>(vm_)->reset_bytecode_cache_stats();
+		}
+	#endif
+
 		std::error_code ec;
 		for(const auto &file : std::filesystem::directory_iterator{dir, ec}) {
 			std::filesystem::path path{file.path()};
@@ -3484,6 +3715,13 @@ namespace vmod
 
 			mods.emplace(std::move(path), std::move(md));
 		}
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm_->GetLanguage() == gsdk::SL_SQUIRREL) {
+			const vm::squirrel::bytecode_stats_t &stats{static_cast<vm::squirrel *>(vm_)->bytecode_cache_stats()};
+			info("vmod: bytecode cache: %zu hits, %zu misses\n"sv, stats.hits, stats.misses);
+		}
+	#endif
 	}
 
 	namespace detail
@@ -4440,7 +4678,10 @@ namespace vmod
 			vmod_gen_docs();
 		}
 
+		//mods loaded with the server compile right away, later loads go through the compile worker
+		is_starting_up = true;
 		vmod_refresh_mods();
+		is_starting_up = false;
 
 		if(vmod_auto_dump_netprops.get<bool>()) {
 			vmod_dump_netprops();
@@ -4513,8 +4754,27 @@ namespace vmod
 		vm_->Frame(sv_globals->frametime);
 	#endif
 
+		plugin::advance_exec_frame();
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm_->GetLanguage() == gsdk::SL_SQUIRREL) {
+			static_cast<vm::squirrel *>(vm_)->set_gc_budget(std::chrono::microseconds{vmod_vm_gc_budget.get<int>()}, vmod_vm_gc_interval.get<float>());
+			static_cast<vm::squirrel *>(vm_)->set_watchdog(std::chrono::milliseconds{vmod_vm_watchdog_ms.get<int>()});
+		}
+	#endif
+
 		bindings::net::singleton::instance().runner();
 
+		if(simulating) {
+			bindings::timers::singleton::instance().frame();
+		}
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm_->GetLanguage() == gsdk::SL_SQUIRREL) {
+			static_cast<vm::squirrel *>(vm_)->run_coroutines(sv_globals->curtime);
+		}
+	#endif
+
 		for(const auto &it : mods) {
 			it.second->game_frame(simulating);
 		}
@@ -4616,8 +4876,23 @@ namespace vmod
 		vmod_unload_mod.unregister();
 		vmod_load_mod.unregister();
 		vmod_list_mods.unregister();
+		vmod_plugin_stats.unregister();
 		vmod_refresh_mods.unregister();
 
+		vmod_purge_bytecode_cache.unregister();
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		vmod_vm_gc_budget.unregister();
+		vmod_vm_gc_interval.unregister();
+		vmod_vm_watchdog_ms.unregister();
+		vmod_vm_gc_stats.unregister();
+
+		vmod_vm_profile_start.unregister();
+		vmod_vm_profile_stop.unregister();
+		vmod_vm_profile_top.unregister();
+		vmod_vm_bench_bindings.unregister();
+	#endif
+
 		vmod_dump_internal_scripts.unregister();
 		vmod_auto_dump_internal_scripts.unregister();
 
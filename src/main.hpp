@@ -76,6 +76,10 @@ namespace vmod
 		{ return is_map_active; }
 		inline bool string_tables_created() const noexcept
 		{ return are_string_tables_created; }
+		inline bool starting_up() const noexcept
+		{ return is_starting_up; }
+		inline bool all_mods_loaded() const noexcept
+		{ return mods_loaded; }
 
 		std::string_view to_string(vscript::handle_ref value) const noexcept;
 		int to_int(vscript::handle_ref value) const noexcept;
@@ -95,6 +99,8 @@ namespace vmod
 		{ return root_dir_; }
 		inline const std::filesystem::path &mods_dir() const noexcept
 		{ return mods_dir_; }
+		inline const std::filesystem::path &bytecode_cache_dir() const noexcept
+		{ return bytecode_cache_dir_; }
 		inline std::string_view scripts_extension() const noexcept
 		{ return scripts_extension_; }
 
@@ -191,12 +197,14 @@ namespace vmod
 		bool is_map_loaded{false};
 		bool is_map_active{false};
 		bool are_string_tables_created{false};
+		bool is_starting_up{false};
 
 		bool internal_docs_built{false};
 
 		std::filesystem::path game_dir_;
 		std::filesystem::path addons_dir_;
 		std::filesystem::path mods_dir_;
+		std::filesystem::path bytecode_cache_dir_;
 		std::filesystem::path root_dir_;
 	#if GSDK_ENGINE == GSDK_ENGINE_L4D2
 		std::filesystem::path mount_dir_;
@@ -402,6 +410,22 @@ namespace vmod
 		ConCommand vmod_load_mod;
 		ConCommand vmod_list_mods;
 		ConCommand vmod_refresh_mods;
+		ConCommand vmod_plugin_stats;
+
+		ConCommand vmod_purge_bytecode_cache;
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		ConVar vmod_vm_gc_budget;
+		ConVar vmod_vm_gc_interval;
+		ConVar vmod_vm_watchdog_ms;
+		ConCommand vmod_vm_gc_stats;
+
+		ConCommand vmod_vm_profile_start;
+		ConCommand vmod_vm_profile_stop;
+		ConCommand vmod_vm_profile_top;
+
+		ConCommand vmod_vm_bench_bindings;
+	#endif
 
 		ConCommand vmod_dump_internal_scripts;
 		ConVar vmod_auto_dump_internal_scripts;
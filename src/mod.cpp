@@ -4,6 +4,9 @@
 
 namespace vmod
 {
+	gsdk::IScriptVM *mod::script_vm() noexcept
+	{ return main::instance().vm(); }
+
 	void mod::init() noexcept
 	{
 		using namespace std::literals::string_view_literals;
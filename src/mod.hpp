@@ -7,6 +7,7 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <array>
 
 namespace vmod
 {
@@ -55,9 +56,15 @@ namespace vmod
 
 		void game_frame(bool simulating) noexcept;
 
+		static gsdk::IScriptVM *script_vm() noexcept;
+
+		//every plugin gets the same arguments so they are converted once for the whole fanout
 		template <typename T, typename ...Args>
 		void call_func_on_plugins(plugin::typed_function<T> plugin::*func, Args &&...args) noexcept
 		{
+			std::array<vscript::variant, sizeof...(Args)> args_var{vscript::variant{std::forward<Args>(args)}...};
+			fanout_call fanout{script_vm(), args_var.data(), args_var.size()};
+
 			for(auto &it : plugins) {
 				if(!*it.second) {
 					continue;
@@ -66,7 +73,7 @@ namespace vmod
 				auto ptr{it.second.get()};
 				auto &var{ptr->*func};
 
-				var(std::forward<Args>(args)...);
+				var.execute_fanout(fanout, nullptr);
 			}
 		}
 
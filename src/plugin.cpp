@@ -1,26 +1,32 @@
 #include "plugin.hpp"
 #include "main.hpp"
 #include "filesystem.hpp"
+#include "vm/vm_shared.hpp"
 #include <cctype>
 #include <charconv>
+#include <optional>
 #include <sys/inotify.h>
 #include "bindings/docs.hpp"
 #include "bindings/instance.hpp"
 
+#ifdef __VMOD_USING_CUSTOM_VM
+	#include "vm/squirrel/vm.hpp"
+#endif
+
 namespace vmod
 {
 	plugin *plugin::assumed_currently_running_;
-	plugin *plugin::scope_assume_current::old_running;
 
 	std::unordered_map<std::filesystem::path, plugin *> plugin::path_plugin_map;
 
+	plugin::scope_exec_timer *plugin::scope_exec_timer::current{nullptr};
+	std::size_t plugin::exec_frame{0};
+
 	plugin *plugin::assumed_currently_running() noexcept
 	{ return assumed_currently_running_; }
 
 	plugin::load_status plugin::load() noexcept
 	{
-		using namespace std::literals::string_view_literals;
-
 		if(script) {
 			if(running) {
 				return load_status::success;
@@ -33,26 +39,68 @@ namespace vmod
 			}
 		}
 
-		gsdk::IScriptVM *vm{main::instance().vm()};
+		if(compile_job != 0) {
+			return load_status::pending;
+		}
 
-		{
-		#ifdef __VMOD_USING_PREPROCESSOR
-			std::string script_data;
+		std::string script_data;
+		std::vector<std::filesystem::path> includes;
+		if(!read_source(script_data, includes)) {
+			return load_status::error;
+		}
 
-			squirrel_preprocessor &pp{main::instance().preprocessor()};
-			if(!pp.preprocess(script_data, path_, incs)) {
-				error("vmod: plugin '%s' failed to preprocess\n"sv, path_.c_str());
-				return load_status::error;
+		main &main_{main::instance()};
+
+		//only the server start waits for the compiler, later loads finish in game_frame
+		if(!main_.starting_up()) {
+			//a job id of 0 leaves script_data untouched so it can still be compiled here
+			compile_job = compile_script_async(main_.vm(), std::move(script_data), path_.c_str(), main_.bytecode_cache_dir());
+			if(compile_job != 0) {
+				compile_incs = std::move(includes);
+				compile_initial = true;
+				return load_status::pending;
 			}
+		}
+
+		incs = std::move(includes);
+
+		script = compile_cached_script(main_.vm(), script_data.c_str(), script_data.length(), path_.c_str(), main_.bytecode_cache_dir());
 
-			script = vm->CompileScript(script_data.c_str(), path_.c_str());
-		#else
-			std::unique_ptr<unsigned char[]> script_data{read_file(path_)};
+		return load_compiled();
+	}
+
+	bool plugin::read_source(std::string &script_data, std::vector<std::filesystem::path> &includes) noexcept
+	{
+		using namespace std::literals::string_view_literals;
 
-			script = vm->CompileScript(reinterpret_cast<const char *>(script_data.get()), path_.c_str());
-		#endif
+	#ifdef __VMOD_USING_PREPROCESSOR
+		squirrel_preprocessor &pp{main::instance().preprocessor()};
+		if(!pp.preprocess(script_data, path_, includes)) {
+			error("vmod: plugin '%s' failed to preprocess\n"sv, path_.c_str());
+			return false;
+		}
+	#else
+		(void)includes;
+
+		std::size_t script_size{0};
+		std::unique_ptr<unsigned char[]> data{read_file(path_, script_size)};
+		if(!data) {
+			error("vmod: plugin '%s' failed to read\n"sv, path_.c_str());
+			return false;
 		}
 
+		script_data.assign(reinterpret_cast<const char *>(data.get()), script_size);
+	#endif
+
+		return true;
+	}
+
+	plugin::load_status plugin::load_compiled() noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		gsdk::IScriptVM *vm{main::instance().vm()};
+
 		if(!script) {
 			error("vmod: plugin '%s' failed to compile\n"sv, path_.c_str());
 			return load_status::error;
@@ -248,9 +296,57 @@ namespace vmod
 			path_plugin_map.erase(it);
 		}
 
+		for(scope_exec_timer *timer{scope_exec_timer::current}; timer; timer = timer->parent) {
+			if(timer->pl == this) {
+				timer->pl = nullptr;
+			}
+		}
+
 		unload();
 	}
 
+	void plugin::record_exec(std::chrono::nanoseconds self, bool failed) noexcept
+	{
+		if(exec_stats_.frame_index != exec_frame) {
+			if(exec_stats_.frame_index+1 == exec_frame) {
+				exec_stats_.last_frame = exec_stats_.frame;
+			} else {
+				exec_stats_.last_frame = std::chrono::nanoseconds{0};
+			}
+
+			exec_stats_.frame = std::chrono::nanoseconds{0};
+			exec_stats_.frame_index = exec_frame;
+		}
+
+		exec_stats_.total += self;
+		exec_stats_.frame += self;
+		if(exec_stats_.frame > exec_stats_.max_frame) {
+			exec_stats_.max_frame = exec_stats_.frame;
+		}
+
+		++exec_stats_.calls;
+		if(failed) {
+			++exec_stats_.errors;
+		}
+	}
+
+	std::chrono::nanoseconds plugin::last_frame_exec_time() const noexcept
+	{
+		if(exec_stats_.frame_index == exec_frame) {
+			return exec_stats_.last_frame;
+		} else if(exec_stats_.frame_index+1 == exec_frame) {
+			return exec_stats_.frame;
+		} else {
+			return std::chrono::nanoseconds{0};
+		}
+	}
+
+	void plugin::reset_exec_stats() noexcept
+	{
+		exec_stats_ = exec_stats_t{};
+		exec_stats_.frame_index = exec_frame;
+	}
+
 	plugin::callback_instance::callback_instance(callable *caller_, vscript::func_handle_wrapper &&callback_, bool post_) noexcept
 		: callback{std::move(callback_)}, post{post_}, caller{caller_}, enabled{true}
 	{
@@ -341,13 +437,14 @@ namespace vmod
 		args = argsblock;
 	#endif
 
-		unsigned char execflags{gsdk::SCRIPT_EXEC_WAIT};
-		if(copyback) {
-			execflags |= gsdk::SCRIPT_EXEC_COPYBACK;
-		}
-
 		return_value retval{return_value::call_orig};
 
+		//without copyback every callback sees the same arguments so they only get converted once
+		std::optional<fanout_call> fanout;
+		if(!copyback) {
+			fanout.emplace(vm, args, num_args);
+		}
+
 		for(auto &it : callbacks) {
 			if(!it.second->enabled) {
 				continue;
@@ -355,8 +452,26 @@ namespace vmod
 
 			vscript::scope_handle_ref pl_scope{it.second->owner_scope()};
 
+			prepared_call &prep{it.second->call};
+			if(!prep.prepared_for(*it.first, *pl_scope)) {
+				if(!prep.prepare(vm, *it.first, *pl_scope)) {
+					continue;
+				}
+			}
+
 			vscript::variant ret_var;
-			if(vm->ExecuteFunction(*it.first, args, static_cast<int>(num_args), &ret_var, *pl_scope, static_cast<gsdk::ScriptExecuteFlags_t>(execflags)) == gsdk::SCRIPT_ERROR) {
+			gsdk::ScriptStatus_t status{gsdk::SCRIPT_ERROR};
+			{
+				scope_exec_timer set{it.second->owner()};
+				if(fanout) {
+					status = fanout->execute(prep, &ret_var);
+				} else {
+					status = prep.execute(vm, args, num_args, &ret_var, copyback);
+				}
+				set.failed = (status == gsdk::SCRIPT_ERROR);
+			}
+
+			if(status == gsdk::SCRIPT_ERROR) {
 				continue;
 			}
 
@@ -544,10 +659,84 @@ namespace vmod
 		return load();
 	}
 
+	bool plugin::reload_async() noexcept
+	{
+		gsdk::IScriptVM *vm{main::instance().vm()};
+
+		cancel_async_script(vm, compile_job);
+		compile_job = 0;
+
+		std::string script_data;
+		std::vector<std::filesystem::path> includes;
+		if(!read_source(script_data, includes)) {
+			return true;
+		}
+
+		compile_job = compile_script_async(vm, std::move(script_data), path_.c_str(), main::instance().bytecode_cache_dir());
+		if(compile_job == 0) {
+			return false;
+		}
+
+		compile_incs = std::move(includes);
+		return true;
+	}
+
+	plugin::load_status plugin::finish_reload() noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		gsdk::ScriptHandleWrapper_t compiled{};
+
+		switch(take_async_script(main::instance().vm(), compile_job, compiled)) {
+			case async_compile_status::pending:
+			return load_status::success;
+			case async_compile_status::failed:
+			compile_job = 0;
+			compile_incs.clear();
+			if(compile_initial) {
+				compile_initial = false;
+				error("vmod: plugin '%s' failed to compile\n"sv, path_.c_str());
+				return load_status::error;
+			}
+			error("vmod: plugin '%s' failed to compile, keeping the loaded version\n"sv, path_.c_str());
+			return load_status::success;
+			case async_compile_status::done:
+			break;
+		}
+
+		compile_job = 0;
+
+		bool initial{compile_initial};
+		compile_initial = false;
+
+		std::vector<std::filesystem::path> includes{std::move(compile_incs)};
+
+		unload();
+
+		incs = std::move(includes);
+		script = std::move(compiled);
+
+		load_status ret{load_compiled()};
+
+		//the rest of the mods already got all_mods_loaded while this one was compiling
+		if(initial && ret == load_status::success && main::instance().all_mods_loaded()) {
+			all_mods_loaded();
+		}
+
+		return ret;
+	}
+
 	void plugin::unload() noexcept
 	{
 		unwatch();
 
+		if(compile_job != 0) {
+			cancel_async_script(main::instance().vm(), compile_job);
+			compile_job = 0;
+			compile_incs.clear();
+			compile_initial = false;
+		}
+
 		plugin_unloaded();
 
 		if(!owned_instances.empty()) {
@@ -570,6 +759,13 @@ namespace vmod
 
 		gsdk::IScriptVM *vm{main::instance().vm()};
 
+	#ifdef __VMOD_USING_CUSTOM_VM
+		//only a plugin that ran can have started any
+		if(private_scope_ && vm->GetLanguage() == gsdk::SL_SQUIRREL) {
+			static_cast<vm::squirrel *>(vm)->cancel_coroutines(this);
+		}
+	#endif
+
 		if(!function_cache.empty()) {
 			for(auto &it : function_cache) {
 				if(vm->ValueExists(*functions_table, it.first.c_str())) {
@@ -623,6 +819,8 @@ namespace vmod
 
 	bool plugin::lookup_function(std::string_view func_name, function &func) noexcept
 	{
+		func.call.reset();
+
 		auto func_obj{main::instance().vm()->LookupFunction(func_name.data(), *private_scope_)};
 		if(!func_obj.object || func_obj.object == gsdk::INVALID_HSCRIPT) {
 			func.owner = nullptr;
@@ -641,6 +839,8 @@ namespace vmod
 	{
 		gsdk::IScriptVM *vm{main::instance().vm()};
 
+		func_obj.call.reset();
+
 		if(!func_hndl) {
 			func_obj.owner = nullptr;
 			func_obj.scope = nullptr;
@@ -698,48 +898,63 @@ namespace vmod
 		}
 	}
 
-	gsdk::ScriptStatus_t plugin::function::execute_internal(gsdk::ScriptVariant_t &ret, const gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept
+	gsdk::ScriptStatus_t plugin::function::execute_prepared(gsdk::ScriptVariant_t *ret, const gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept
 	{
 		if(!valid()) {
 			return gsdk::SCRIPT_ERROR;
 		}
 
-		scope_assume_current sac{owner};
-		return main::instance().vm()->ExecuteFunction(*func, args, static_cast<int>(num_args), &ret, scope ? *scope : nullptr, true);
-	}
+		gsdk::IScriptVM *vm{main::instance().vm()};
 
-	gsdk::ScriptStatus_t plugin::function::execute_internal(gsdk::ScriptVariant_t &ret) noexcept
-	{
-		if(!valid()) {
-			return gsdk::SCRIPT_ERROR;
+		gsdk::HSCRIPT scope_hndl{scope ? *scope : nullptr};
+		if(!call.prepared_for(*func, scope_hndl)) {
+			if(!call.prepare(vm, *func, scope_hndl)) {
+				return gsdk::SCRIPT_ERROR;
+			}
 		}
 
 		scope_assume_current sac{owner};
-		return main::instance().vm()->ExecuteFunction(*func, nullptr, 0, &ret, scope ? *scope : nullptr, true);
+		scope_exec_timer set{owner};
+		gsdk::ScriptStatus_t status{call.execute(vm, const_cast<gsdk::ScriptVariant_t *>(args), num_args, ret)};
+		set.failed = (status == gsdk::SCRIPT_ERROR);
+		return status;
 	}
 
-	gsdk::ScriptStatus_t plugin::function::execute_internal(const gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept
+	gsdk::ScriptStatus_t plugin::function::execute_fanout(fanout_call &fanout, gsdk::ScriptVariant_t *ret) noexcept
 	{
 		if(!valid()) {
 			return gsdk::SCRIPT_ERROR;
 		}
 
-		scope_assume_current sac{owner};
-		return main::instance().vm()->ExecuteFunction(*func, args, static_cast<int>(num_args), nullptr, scope ? *scope : nullptr, true);
-	}
-
-	gsdk::ScriptStatus_t plugin::function::execute_internal() noexcept
-	{
-		if(!valid()) {
-			return gsdk::SCRIPT_ERROR;
+		gsdk::HSCRIPT scope_hndl{scope ? *scope : nullptr};
+		if(!call.prepared_for(*func, scope_hndl)) {
+			if(!call.prepare(main::instance().vm(), *func, scope_hndl)) {
+				return gsdk::SCRIPT_ERROR;
+			}
 		}
 
 		scope_assume_current sac{owner};
-		return main::instance().vm()->ExecuteFunction(*func, nullptr, 0, nullptr, scope ? *scope : nullptr, true);
+		scope_exec_timer set{owner};
+		gsdk::ScriptStatus_t status{fanout.execute(call, ret)};
+		set.failed = (status == gsdk::SCRIPT_ERROR);
+		return status;
 	}
 
+	gsdk::ScriptStatus_t plugin::function::execute_internal(gsdk::ScriptVariant_t &ret, const gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept
+	{ return execute_prepared(&ret, args, num_args); }
+
+	gsdk::ScriptStatus_t plugin::function::execute_internal(gsdk::ScriptVariant_t &ret) noexcept
+	{ return execute_prepared(&ret, nullptr, 0); }
+
+	gsdk::ScriptStatus_t plugin::function::execute_internal(const gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept
+	{ return execute_prepared(nullptr, args, num_args); }
+
+	gsdk::ScriptStatus_t plugin::function::execute_internal() noexcept
+	{ return execute_prepared(nullptr, nullptr, 0); }
+
 	void plugin::function::free() noexcept
 	{
+		call.reset();
 		func.free();
 	}
 
@@ -750,6 +965,12 @@ namespace vmod
 
 	void plugin::game_frame(bool simulating) noexcept
 	{
+		if(compile_job != 0) {
+			if(finish_reload() != load_status::success) {
+				return;
+			}
+		}
+
 		if(inotify_fd != -1) {
 			unsigned char event_bytes[sizeof(inotify_event)+NAME_MAX+1]{};
 			ssize_t evbytes{read(inotify_fd, event_bytes, sizeof(event_bytes))};
@@ -758,8 +979,11 @@ namespace vmod
 			auto event{reinterpret_cast<inotify_event *>(event_bytes)};
 			#pragma GCC diagnostic pop
 			if((evbytes > 0) && (static_cast<size_t>(evbytes) >= sizeof(inotify_event)) && (event->mask & IN_MODIFY)) {
-				if(reload() != load_status::success) {
-					return;
+				//the loaded version keeps running until the new one is compiled
+				if(!reload_async()) {
+					if(reload() != load_status::success) {
+						return;
+					}
 				}
 			}
 		}
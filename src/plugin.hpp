@@ -7,7 +7,15 @@
 #include <vector>
 #include <utility>
 #include <unordered_map>
+#include <chrono>
+#include <array>
 #include "bindings/instance.hpp"
+#include "vm/vm_shared.hpp"
+
+namespace vmod::vm
+{
+	class squirrel;
+}
 
 namespace vmod
 {
@@ -18,6 +26,7 @@ namespace vmod
 	{
 		friend class main;
 		friend class mod;
+		friend class vm::squirrel;
 
 	public:
 		static bool bindings() noexcept;
@@ -31,7 +40,8 @@ namespace vmod
 		{
 			error,
 			disabled,
-			success
+			success,
+			pending
 		};
 
 		load_status load() noexcept;
@@ -53,6 +63,26 @@ namespace vmod
 
 		static plugin *assumed_currently_running() noexcept;
 
+		//self time spent in script calls made on behalf of this plugin, nested calls into other plugins are excluded
+		struct exec_stats_t final
+		{
+			std::chrono::nanoseconds total{0};
+			std::chrono::nanoseconds frame{0};
+			std::chrono::nanoseconds last_frame{0};
+			std::chrono::nanoseconds max_frame{0};
+			std::size_t calls{0};
+			std::size_t errors{0};
+			std::size_t frame_index{0};
+		};
+
+		inline const exec_stats_t &exec_stats() const noexcept
+		{ return exec_stats_; }
+		std::chrono::nanoseconds last_frame_exec_time() const noexcept;
+		void reset_exec_stats() noexcept;
+
+		static inline void advance_exec_frame() noexcept
+		{ ++exec_frame; }
+
 		class function
 		{
 			friend class plugin;
@@ -72,6 +102,9 @@ namespace vmod
 
 			void free() noexcept;
 
+			//one call out of a fanout sharing its already converted arguments
+			gsdk::ScriptStatus_t execute_fanout(fanout_call &fanout, gsdk::ScriptVariant_t *ret) noexcept;
+
 		private:
 			function() noexcept = default;
 			function(function &&) noexcept = default;
@@ -82,12 +115,15 @@ namespace vmod
 			gsdk::ScriptStatus_t execute_internal(gsdk::ScriptVariant_t &ret) noexcept;
 			gsdk::ScriptStatus_t execute_internal(const gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept;
 
+			gsdk::ScriptStatus_t execute_prepared(gsdk::ScriptVariant_t *ret, const gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept;
+
 			inline bool valid() const noexcept
 			{ return static_cast<bool>(func); }
 
 			vscript::scope_handle_ref scope{};
 			vscript::func_handle_wrapper func{};
 			plugin *owner{nullptr};
+			prepared_call call;
 
 		private:
 			function(const function &) = delete;
@@ -259,6 +295,7 @@ namespace vmod
 			void callable_destroyed() noexcept;
 
 			vscript::func_handle_wrapper callback;
+			prepared_call call;
 			bool post;
 			callable *caller;
 			bool enabled;
@@ -352,22 +389,58 @@ namespace vmod
 
 		struct scope_assume_current final
 		{
-			static plugin *old_running;
-
 			inline scope_assume_current(plugin *pl_) noexcept
+				: old_running{assumed_currently_running()}
 			{
-				old_running = assumed_currently_running();
 				if(pl_) {
 					assumed_currently_running_ = pl_;
 				}
 			}
 			inline ~scope_assume_current() noexcept
 			{ assumed_currently_running_ = old_running; }
+
+			//per scope so coroutines resumed from inside another plugin's call restore the right one
+			plugin *old_running;
+		};
+
+		struct scope_exec_timer final
+		{
+			static scope_exec_timer *current;
+
+			inline scope_exec_timer(plugin *pl_) noexcept
+				: pl{pl_}, parent{current}, start{std::chrono::steady_clock::now()}
+			{ current = this; }
+			inline ~scope_exec_timer() noexcept
+			{
+				std::chrono::nanoseconds elapsed{std::chrono::steady_clock::now() - start};
+				current = parent;
+				if(parent) {
+					parent->children += elapsed;
+				}
+				if(pl) {
+					pl->record_exec(elapsed - children, failed);
+				}
+			}
+
+			plugin *pl;
+			scope_exec_timer *parent;
+			std::chrono::steady_clock::time_point start;
+			std::chrono::nanoseconds children{0};
+			bool failed{false};
 		};
 
 		static plugin *assumed_currently_running_;
 		static std::unordered_map<std::filesystem::path, plugin *> path_plugin_map;
 
+		static std::size_t exec_frame;
+
+		void record_exec(std::chrono::nanoseconds self, bool failed) noexcept;
+
+		float script_exec_time() const noexcept;
+		float script_frame_exec_time() const noexcept;
+		float script_max_frame_exec_time() const noexcept;
+		std::size_t script_exec_calls() const noexcept;
+
 		vscript::func_handle_ref script_lookup_function(std::string_view func_name) noexcept;
 		vscript::variant script_lookup_value(std::string_view val_name) noexcept;
 
@@ -376,8 +449,20 @@ namespace vmod
 		void watch() noexcept;
 		void unwatch() noexcept;
 
+		bool read_source(std::string &script_data, std::vector<std::filesystem::path> &includes) noexcept;
+		load_status load_compiled() noexcept;
+
+		//hot reloads compile off the main thread and keep the loaded version on errors
+		//false means the vm can't compile asynchronously and reload has to be used
+		bool reload_async() noexcept;
+		//also finishes loads that returned pending, those have no loaded version to keep
+		load_status finish_reload() noexcept;
+
 		std::filesystem::path path_;
 		std::vector<std::filesystem::path> incs;
+		std::size_t compile_job{0};
+		std::vector<std::filesystem::path> compile_incs;
+		bool compile_initial{false};
 		int inotify_fd{-1};
 		std::vector<int> watch_fds;
 
@@ -392,6 +477,8 @@ namespace vmod
 
 		std::unordered_map<std::string, vscript::func_handle_wrapper> function_cache;
 
+		exec_stats_t exec_stats_;
+
 		std::vector<owned_instance *> owned_instances;
 		std::vector<shared_instance *> shared_instances;
 		bool clearing_instances{false};
@@ -7,9 +7,7 @@ namespace vmod
 			if constexpr(sizeof...(Args) == 0) {
 				execute_internal();
 			} else {
-				std::vector<vscript::variant> args_var;
-				args_var.reserve(sizeof...(Args));
-				(args_var.emplace_back(std::forward<Args>(args)), ...);
+				std::array<vscript::variant, sizeof...(Args)> args_var{vscript::variant{std::forward<Args>(args)}...};
 				execute_internal(args_var.data(), args_var.size());
 			}
 		} else {
@@ -18,9 +16,7 @@ namespace vmod
 				execute_internal(ret_var);
 				return to_value<R>(ret_var);
 			} else {
-				std::vector<vscript::variant> args_var;
-				args_var.reserve(sizeof...(Args));
-				(args_var.emplace_back(std::forward<Args>(args)), ...);
+				std::array<vscript::variant, sizeof...(Args)> args_var{vscript::variant{std::forward<Args>(args)}...};
 				gsdk::ScriptVariant_t ret_var;
 				execute_internal(ret_var, args_var.data(), args_var.size());
 				return to_value<R>(ret_var);
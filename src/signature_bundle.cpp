@@ -0,0 +1,689 @@
+#include "signature_bundle.hpp"
+#include "filesystem.hpp"
+#include <cstring>
+#include <charconv>
+#include <memory>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <yaml.h>
+
+namespace vmod
+{
+	namespace detail
+	{
+		struct yaml_stream_t final
+		{
+			inline yaml_stream_t() noexcept = default;
+			inline ~yaml_stream_t() noexcept
+			{
+				if(has_event) {
+					yaml_event_delete(&event);
+				}
+				if(initialized) {
+					yaml_parser_delete(&parser);
+				}
+			}
+
+			bool initialize(const unsigned char *data, std::size_t size) noexcept
+			{
+				if(yaml_parser_initialize(&parser) != 1) {
+					return false;
+				}
+
+				initialized = true;
+
+				yaml_parser_set_input_string(&parser, data, size);
+				return true;
+			}
+
+			bool next(std::string &err_str) noexcept
+			{
+				using namespace std::literals::string_literals;
+
+				if(has_event) {
+					yaml_event_delete(&event);
+					has_event = false;
+				}
+
+				if(yaml_parser_parse(&parser, &event) != 1) {
+					if(parser.problem) {
+						err_str = parser.problem;
+					} else {
+						err_str = "parser error"s;
+					}
+					return false;
+				}
+
+				has_event = true;
+				return true;
+			}
+
+			inline yaml_event_type_t type() const noexcept
+			{ return event.type; }
+
+			inline std::string_view scalar() const noexcept
+			{ return {reinterpret_cast<const char *>(event.data.scalar.value), event.data.scalar.length}; }
+
+			bool is_null() const noexcept
+			{
+				using namespace std::literals::string_view_literals;
+
+				if(event.type != YAML_SCALAR_EVENT) {
+					return false;
+				}
+
+				if(event.data.scalar.tag) {
+					return (std::strcmp(reinterpret_cast<const char *>(event.data.scalar.tag), YAML_NULL_TAG) == 0);
+				}
+
+				if(event.data.scalar.style != YAML_PLAIN_SCALAR_STYLE) {
+					return false;
+				}
+
+				std::string_view str{scalar()};
+				return (str == "null"sv || str == "~"sv);
+			}
+
+			//leaves the last event of the current node as the current event
+			bool skip(std::string &err_str) noexcept
+			{
+				std::size_t depth{0};
+
+				do {
+					switch(event.type) {
+						case YAML_SEQUENCE_START_EVENT:
+						case YAML_MAPPING_START_EVENT:
+						++depth;
+						break;
+						case YAML_SEQUENCE_END_EVENT:
+						case YAML_MAPPING_END_EVENT:
+						--depth;
+						break;
+						default: break;
+					}
+
+					if(depth == 0) {
+						break;
+					}
+
+					if(!next(err_str)) {
+						return false;
+					}
+				} while(true);
+
+				return true;
+			}
+
+			yaml_parser_t parser{};
+			yaml_event_t event{};
+			bool initialized{false};
+			bool has_event{false};
+
+		private:
+			yaml_stream_t(const yaml_stream_t &) = delete;
+			yaml_stream_t &operator=(const yaml_stream_t &) = delete;
+			yaml_stream_t(yaml_stream_t &&) = delete;
+			yaml_stream_t &operator=(yaml_stream_t &&) = delete;
+		};
+
+		template <typename T>
+		static bool read_hex(std::string_view str, T &value) noexcept
+		{
+			if(str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+				str.remove_prefix(2);
+			}
+
+			const char *begin{str.data()};
+			const char *end{begin + str.size()};
+
+			std::from_chars_result fc_res{std::from_chars(begin, end, value, 16)};
+			if(fc_res.ec != std::errc{} || fc_res.ptr != end) {
+				return false;
+			}
+
+			return true;
+		}
+
+		static bool read_final_map(yaml_stream_t &stream, std::string_view qual, std::string &&name, std::vector<signature_t> &sigs, std::string &err_str) noexcept
+		{
+			using namespace std::literals::string_view_literals;
+			using namespace std::literals::string_literals;
+
+			auto build_err_str{
+				[&err_str,qual,&name](std::string_view pre, std::string_view post) noexcept -> void {
+					err_str.clear();
+					if(!pre.empty()) {
+						err_str += pre;
+						err_str += ' ';
+					}
+					err_str += '\'';
+					if(!qual.empty()) {
+						err_str += qual;
+						err_str += "::"sv;
+					}
+					err_str += name;
+					err_str += "' "sv;
+					err_str += post;
+				}
+			};
+
+			signature_t sig;
+
+			std::string method;
+			bool has_bytes{false};
+
+			while(true) {
+				if(!stream.next(err_str)) {
+					return false;
+				}
+
+				if(stream.type() == YAML_MAPPING_END_EVENT) {
+					break;
+				}
+
+				if(stream.type() != YAML_SCALAR_EVENT) {
+					build_err_str("key in"sv, "is not a string"sv);
+					return false;
+				}
+
+				std::string key{stream.scalar()};
+
+				if(!stream.next(err_str)) {
+					return false;
+				}
+
+				if(key == "method"sv) {
+					if(stream.type() != YAML_SCALAR_EVENT) {
+						build_err_str({}, "method is not a string"sv);
+						return false;
+					}
+
+					method = stream.scalar();
+				} else if(key == "bytes"sv) {
+					if(stream.type() != YAML_SEQUENCE_START_EVENT) {
+						build_err_str({}, "bytes is not a array"sv);
+						return false;
+					}
+
+					while(true) {
+						if(!stream.next(err_str)) {
+							return false;
+						}
+
+						if(stream.type() == YAML_SEQUENCE_END_EVENT) {
+							break;
+						}
+
+						if(stream.is_null()) {
+							sig.bytes.emplace_back(0);
+							sig.mask.emplace_back(0);
+							continue;
+						}
+
+						unsigned char byte;
+						if(stream.type() != YAML_SCALAR_EVENT || !read_hex<unsigned char>(stream.scalar(), byte)) {
+							build_err_str({}, "bytes has a non byte value"sv);
+							return false;
+						}
+
+						sig.bytes.emplace_back(byte);
+						sig.mask.emplace_back(0xFF);
+					}
+
+					has_bytes = true;
+				} else if(key == "offset"sv) {
+					if(stream.is_null()) {
+						sig.offset = static_cast<std::uint64_t>(-1);
+					} else if(stream.type() != YAML_SCALAR_EVENT || !read_hex<std::uint64_t>(stream.scalar(), sig.offset)) {
+						build_err_str({}, "invalid offset"sv);
+						return false;
+					}
+				} else {
+					if(!stream.skip(err_str)) {
+						return false;
+					}
+				}
+			}
+
+			if(method.empty()) {
+				build_err_str({}, "is missing method"sv);
+				return false;
+			}
+
+			std::string_view methodstr{method};
+
+			if(methodstr.compare(0, 9, "byte_scan"sv) != 0) {
+				build_err_str({}, "unknown method '"sv);
+				err_str += methodstr;
+				err_str += '\'';
+				return false;
+			}
+
+			if(!has_bytes) {
+				build_err_str({}, "is missing bytes"sv);
+				return false;
+			}
+
+			if(methodstr.ends_with("_mem"sv)) {
+				sig.data = false;
+			} else if(methodstr.ends_with("_data"sv)) {
+				sig.data = true;
+			} else {
+				build_err_str({}, "unknown method '"sv);
+				err_str += methodstr;
+				err_str += '\'';
+				return false;
+			}
+
+			sig.qual = qual;
+			sig.name = std::move(name);
+
+			sigs.emplace_back(std::move(sig));
+
+			return true;
+		}
+
+		static bool read_map(yaml_stream_t &stream, std::string_view name, std::vector<signature_t> &sigs, std::string &err_str) noexcept;
+
+		static bool read_array(yaml_stream_t &stream, std::string_view name, std::vector<signature_t> &sigs, std::string &err_str) noexcept
+		{
+			using namespace std::literals::string_view_literals;
+			using namespace std::literals::string_literals;
+
+			while(true) {
+				if(!stream.next(err_str)) {
+					return false;
+				}
+
+				switch(stream.type()) {
+					case YAML_SEQUENCE_END_EVENT:
+					return true;
+					case YAML_MAPPING_START_EVENT: {
+						if(!read_map(stream, name, sigs, err_str)) {
+							return false;
+						}
+					} break;
+					default: {
+						err_str = "value in '"s;
+						err_str += name;
+						err_str += "' is not a map"sv;
+						return false;
+					}
+				}
+			}
+		}
+
+		static bool read_map(yaml_stream_t &stream, std::string_view name, std::vector<signature_t> &sigs, std::string &err_str) noexcept
+		{
+			using namespace std::literals::string_view_literals;
+			using namespace std::literals::string_literals;
+
+			while(true) {
+				if(!stream.next(err_str)) {
+					return false;
+				}
+
+				if(stream.type() == YAML_MAPPING_END_EVENT) {
+					return true;
+				}
+
+				if(stream.type() != YAML_SCALAR_EVENT) {
+					err_str = "value in '"s;
+					err_str += name.empty() ? "root"sv : name;
+					err_str += "' is not a string"sv;
+					return false;
+				}
+
+				std::string keystr{stream.scalar()};
+
+				if(!stream.next(err_str)) {
+					return false;
+				}
+
+				switch(stream.type()) {
+					case YAML_MAPPING_START_EVENT: {
+						if(!read_final_map(stream, name, std::move(keystr), sigs, err_str)) {
+							return false;
+						}
+					} break;
+					case YAML_SEQUENCE_START_EVENT: {
+						if(!read_array(stream, keystr, sigs, err_str)) {
+							return false;
+						}
+					} break;
+					default: {
+						err_str = "'"s;
+						err_str += keystr;
+						err_str += "' in '"sv;
+						err_str += name.empty() ? "root"sv : name;
+						err_str += "' is not a array or map"sv;
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	bool read_signature_yaml(const unsigned char *data, std::size_t size, std::vector<signature_t> &sigs, std::string &err_str) noexcept
+	{
+		using namespace std::literals::string_literals;
+
+		detail::yaml_stream_t stream;
+		if(!stream.initialize(data, size)) {
+			err_str = "failed to initialize parser"s;
+			return false;
+		}
+
+		while(true) {
+			if(!stream.next(err_str)) {
+				return false;
+			}
+
+			switch(stream.type()) {
+				case YAML_STREAM_START_EVENT:
+				case YAML_DOCUMENT_END_EVENT:
+				break;
+				case YAML_STREAM_END_EVENT:
+				return true;
+				case YAML_DOCUMENT_START_EVENT: {
+					if(!stream.next(err_str)) {
+						return false;
+					}
+
+					if(stream.type() == YAML_DOCUMENT_END_EVENT) {
+						break;
+					}
+
+					if(stream.type() != YAML_MAPPING_START_EVENT) {
+						err_str = "root is not a map"s;
+						return false;
+					}
+
+					if(!detail::read_map(stream, {}, sigs, err_str)) {
+						return false;
+					}
+				} break;
+				default: {
+					err_str = "root is not a map"s;
+					return false;
+				}
+			}
+		}
+	}
+
+	namespace detail
+	{
+		static constexpr std::string_view bundle_magic{"VMODSIGB"};
+		static constexpr std::uint32_t bundle_version{1};
+
+		struct bundle_header_t final
+		{
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t num_files;
+			std::uint32_t num_entries;
+			std::uint32_t pad;
+		};
+
+		struct bundle_file_t final
+		{
+			std::uint32_t dir_off;
+			std::uint32_t dir_len;
+			std::uint32_t name_off;
+			std::uint32_t name_len;
+			std::uint64_t hash;
+			std::uint32_t first;
+			std::uint32_t count;
+		};
+
+		struct bundle_entry_t final
+		{
+			std::uint32_t qual_off;
+			std::uint32_t qual_len;
+			std::uint32_t name_off;
+			std::uint32_t name_len;
+			//followed by as many mask bytes
+			std::uint32_t bytes_off;
+			std::uint32_t size;
+			std::uint64_t offset;
+			std::uint32_t flags;
+			std::uint32_t pad;
+		};
+
+		static constexpr std::uint32_t bundle_entry_data{1 << 0};
+
+		static_assert(sizeof(bundle_header_t) % alignof(std::uint64_t) == 0);
+		static_assert(sizeof(bundle_file_t) % alignof(std::uint64_t) == 0);
+		static_assert(sizeof(bundle_entry_t) % alignof(std::uint64_t) == 0);
+
+		static inline std::size_t bundle_files_begin() noexcept
+		{ return sizeof(bundle_header_t); }
+		static inline std::size_t bundle_entries_begin(std::size_t num_files) noexcept
+		{ return sizeof(bundle_header_t) + (num_files * sizeof(bundle_file_t)); }
+	}
+
+	bool write_signature_bundle(const std::filesystem::path &path, const std::vector<signature_file_t> &files) noexcept
+	{
+		std::size_t num_entries{0};
+		for(const signature_file_t &file : files) {
+			num_entries += file.sigs.size();
+		}
+
+		std::vector<unsigned char> blob;
+		std::unordered_map<std::string_view, std::uint32_t> strings;
+
+		const std::size_t blob_begin{detail::bundle_entries_begin(files.size()) + (num_entries * sizeof(detail::bundle_entry_t))};
+
+		bool overflow{false};
+
+		auto add_blob{
+			[&blob,blob_begin,&overflow](const unsigned char *data, std::size_t size) noexcept -> std::uint32_t {
+				std::size_t off{blob_begin + blob.size()};
+				if(off + size > static_cast<std::size_t>(static_cast<std::uint32_t>(-1))) {
+					overflow = true;
+					return 0;
+				}
+				blob.insert(blob.end(), data, data + size);
+				return static_cast<std::uint32_t>(off);
+			}
+		};
+
+		auto add_string{
+			[&strings,&add_blob](std::string_view str) noexcept -> std::uint32_t {
+				auto it{strings.find(str)};
+				if(it != strings.end()) {
+					return it->second;
+				}
+
+				std::uint32_t off{add_blob(reinterpret_cast<const unsigned char *>(str.data()), str.size())};
+				strings.emplace(str, off);
+				return off;
+			}
+		};
+
+		std::vector<detail::bundle_file_t> file_table;
+		file_table.reserve(files.size());
+
+		std::vector<detail::bundle_entry_t> entry_table;
+		entry_table.reserve(num_entries);
+
+		for(const signature_file_t &file : files) {
+			detail::bundle_file_t &bfile{file_table.emplace_back()};
+			bfile.dir_off = add_string(file.dir);
+			bfile.dir_len = static_cast<std::uint32_t>(file.dir.size());
+			bfile.name_off = add_string(file.name);
+			bfile.name_len = static_cast<std::uint32_t>(file.name.size());
+			bfile.hash = file.hash;
+			bfile.first = static_cast<std::uint32_t>(entry_table.size());
+			bfile.count = static_cast<std::uint32_t>(file.sigs.size());
+
+			for(const signature_t &sig : file.sigs) {
+				detail::bundle_entry_t &bentry{entry_table.emplace_back()};
+				bentry.qual_off = add_string(sig.qual);
+				bentry.qual_len = static_cast<std::uint32_t>(sig.qual.size());
+				bentry.name_off = add_string(sig.name);
+				bentry.name_len = static_cast<std::uint32_t>(sig.name.size());
+				bentry.bytes_off = add_blob(sig.bytes.data(), sig.bytes.size());
+				add_blob(sig.mask.data(), sig.mask.size());
+				bentry.size = static_cast<std::uint32_t>(sig.bytes.size());
+				bentry.offset = sig.offset;
+				bentry.flags = (sig.data ? detail::bundle_entry_data : 0);
+				bentry.pad = 0;
+			}
+		}
+
+		if(overflow) {
+			return false;
+		}
+
+		detail::bundle_header_t header{};
+		std::memcpy(header.magic, detail::bundle_magic.data(), sizeof(header.magic));
+		header.version = detail::bundle_version;
+		header.num_files = static_cast<std::uint32_t>(files.size());
+		header.num_entries = static_cast<std::uint32_t>(num_entries);
+
+		std::size_t size{blob_begin + blob.size()};
+
+		std::unique_ptr<unsigned char[]> data{new unsigned char[size]};
+		std::memcpy(data.get(), &header, sizeof(detail::bundle_header_t));
+		std::memcpy(data.get() + detail::bundle_files_begin(), file_table.data(), file_table.size() * sizeof(detail::bundle_file_t));
+		std::memcpy(data.get() + detail::bundle_entries_begin(files.size()), entry_table.data(), entry_table.size() * sizeof(detail::bundle_entry_t));
+		std::memcpy(data.get() + blob_begin, blob.data(), blob.size());
+
+		write_file(path, data.get(), size);
+
+		return true;
+	}
+
+	signature_bundle::~signature_bundle() noexcept
+	{
+		close();
+	}
+
+	bool signature_bundle::open(const std::filesystem::path &path) noexcept
+	{
+		close();
+
+		int fd{::open(path.c_str(), O_RDONLY)};
+		if(fd < 0) {
+			return false;
+		}
+
+		struct stat stat;
+		if(fstat(fd, &stat) != 0 || static_cast<std::size_t>(stat.st_size) < sizeof(detail::bundle_header_t)) {
+			::close(fd);
+			return false;
+		}
+
+		size = static_cast<std::size_t>(stat.st_size);
+
+		void *map{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+		::close(fd);
+		if(map == MAP_FAILED) {
+			size = 0;
+			return false;
+		}
+
+		data = static_cast<unsigned char *>(map);
+
+		detail::bundle_header_t header;
+		std::memcpy(&header, data, sizeof(detail::bundle_header_t));
+
+		if(std::string_view{header.magic, sizeof(header.magic)} != detail::bundle_magic ||
+			header.version != detail::bundle_version ||
+			detail::bundle_entries_begin(header.num_files) + (static_cast<std::size_t>(header.num_entries) * sizeof(detail::bundle_entry_t)) > size) {
+			close();
+			return false;
+		}
+
+		//validate everything once so lookups can trust the offsets
+		auto in_bounds{
+			[this](std::uint32_t off, std::size_t len) noexcept -> bool {
+				return (static_cast<std::size_t>(off) + len <= size);
+			}
+		};
+
+		for(std::size_t i{0}; i < header.num_files; ++i) {
+			detail::bundle_file_t bfile;
+			std::memcpy(&bfile, data + detail::bundle_files_begin() + (i * sizeof(detail::bundle_file_t)), sizeof(detail::bundle_file_t));
+
+			if(!in_bounds(bfile.dir_off, bfile.dir_len) ||
+				!in_bounds(bfile.name_off, bfile.name_len) ||
+				static_cast<std::size_t>(bfile.first) + bfile.count > header.num_entries) {
+				close();
+				return false;
+			}
+		}
+
+		for(std::size_t i{0}; i < header.num_entries; ++i) {
+			detail::bundle_entry_t bentry;
+			std::memcpy(&bentry, data + detail::bundle_entries_begin(header.num_files) + (i * sizeof(detail::bundle_entry_t)), sizeof(detail::bundle_entry_t));
+
+			if(!in_bounds(bentry.qual_off, bentry.qual_len) ||
+				!in_bounds(bentry.name_off, bentry.name_len) ||
+				!in_bounds(bentry.bytes_off, static_cast<std::size_t>(bentry.size) * 2)) {
+				close();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void signature_bundle::close() noexcept
+	{
+		if(data) {
+			munmap(data, size);
+			data = nullptr;
+			size = 0;
+		}
+	}
+
+	std::size_t signature_bundle::num_files() const noexcept
+	{
+		if(!data) {
+			return 0;
+		}
+
+		detail::bundle_header_t header;
+		std::memcpy(&header, data, sizeof(detail::bundle_header_t));
+
+		return header.num_files;
+	}
+
+	signature_bundle::file_view_t signature_bundle::file(std::size_t i) const noexcept
+	{
+		detail::bundle_file_t bfile;
+		std::memcpy(&bfile, data + detail::bundle_files_begin() + (i * sizeof(detail::bundle_file_t)), sizeof(detail::bundle_file_t));
+
+		return file_view_t{
+			{reinterpret_cast<const char *>(data + bfile.dir_off), bfile.dir_len},
+			{reinterpret_cast<const char *>(data + bfile.name_off), bfile.name_len},
+			bfile.hash,
+			bfile.first,
+			bfile.count
+		};
+	}
+
+	signature_bundle::entry_view_t signature_bundle::entry(std::size_t i) const noexcept
+	{
+		detail::bundle_header_t header;
+		std::memcpy(&header, data, sizeof(detail::bundle_header_t));
+
+		detail::bundle_entry_t bentry;
+		std::memcpy(&bentry, data + detail::bundle_entries_begin(header.num_files) + (i * sizeof(detail::bundle_entry_t)), sizeof(detail::bundle_entry_t));
+
+		return entry_view_t{
+			{reinterpret_cast<const char *>(data + bentry.qual_off), bentry.qual_len},
+			{reinterpret_cast<const char *>(data + bentry.name_off), bentry.name_len},
+			data + bentry.bytes_off,
+			data + bentry.bytes_off + bentry.size,
+			bentry.size,
+			bentry.offset,
+			(bentry.flags & detail::bundle_entry_data) != 0
+		};
+	}
+}
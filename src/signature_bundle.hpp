@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+namespace vmod
+{
+	struct signature_t final
+	{
+		std::string qual;
+		std::string name;
+		std::vector<unsigned char> bytes;
+		//0 for wildcards
+		std::vector<unsigned char> mask;
+		std::uint64_t offset{0};
+		bool data{false};
+	};
+
+	extern bool read_signature_yaml(const unsigned char *data, std::size_t size, std::vector<signature_t> &sigs, std::string &err_str) noexcept;
+
+	struct signature_file_t final
+	{
+		std::string dir;
+		std::string name;
+		std::uint64_t hash{0};
+		std::vector<signature_t> sigs;
+	};
+
+	extern bool write_signature_bundle(const std::filesystem::path &path, const std::vector<signature_file_t> &files) noexcept;
+
+	//precompiled signatures of whole yaml directories, mapped once and read in place
+	class signature_bundle final
+	{
+	public:
+		signature_bundle() noexcept = default;
+		~signature_bundle() noexcept;
+
+		bool open(const std::filesystem::path &path) noexcept;
+		void close() noexcept;
+
+		inline bool is_open() const noexcept
+		{ return data != nullptr; }
+
+		struct file_view_t final
+		{
+			std::string_view dir;
+			std::string_view name;
+			std::uint64_t hash;
+			std::size_t first;
+			std::size_t count;
+		};
+
+		struct entry_view_t final
+		{
+			std::string_view qual;
+			std::string_view name;
+			const unsigned char *bytes;
+			const unsigned char *mask;
+			std::size_t size;
+			std::uint64_t offset;
+			bool data;
+		};
+
+		std::size_t num_files() const noexcept;
+		file_view_t file(std::size_t i) const noexcept;
+		entry_view_t entry(std::size_t i) const noexcept;
+
+	private:
+		unsigned char *data{nullptr};
+		std::size_t size{0};
+
+	private:
+		signature_bundle(const signature_bundle &) = delete;
+		signature_bundle &operator=(const signature_bundle &) = delete;
+		signature_bundle(signature_bundle &&) = delete;
+		signature_bundle &operator=(signature_bundle &&) = delete;
+	};
+}
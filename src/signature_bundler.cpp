@@ -0,0 +1,51 @@
+#include "signature_bundle.hpp"
+#include "filesystem.hpp"
+#include "xxhash.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+int main(int argc, char *argv[], [[maybe_unused]] char *[])
+{
+	using namespace std::literals::string_view_literals;
+
+	if(argc < 3) {
+		std::cout << "vmod: usage: <output> <yaml>...\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	std::filesystem::path out_path{argv[1]};
+
+	std::vector<vmod::signature_file_t> files;
+	files.reserve(static_cast<std::size_t>(argc - 2));
+
+	for(int i{2}; i < argc; ++i) {
+		std::filesystem::path path{argv[i]};
+
+		std::size_t size{0};
+		std::unique_ptr<unsigned char[]> data{vmod::read_file(path, size)};
+		if(size == 0) {
+			std::cout << "vmod: failed to read '"sv << path << "'\n"sv;
+			return EXIT_FAILURE;
+		}
+
+		//the directory name is what symbol_cache looks yamls up by
+		vmod::signature_file_t &file{files.emplace_back()};
+		file.dir = path.parent_path().filename().native();
+		file.name = path.filename().native();
+		file.hash = XXH3_64bits(data.get(), size);
+
+		std::string err_str;
+		if(!vmod::read_signature_yaml(data.get(), size, file.sigs, err_str)) {
+			std::cout << "vmod: failed to parse '"sv << path << "': '"sv << err_str << "'\n"sv;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if(!vmod::write_signature_bundle(out_path, files)) {
+		std::cout << "vmod: failed to write '"sv << out_path << "'\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
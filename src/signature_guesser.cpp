@@ -1,51 +1,953 @@
-#include "gsdk_library.hpp"
 #include "symbol_cache.hpp"
 #include "filesystem.hpp"
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
 #include <charconv>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
 
-int main(int argc, [[maybe_unused]] char *argv[], [[maybe_unused]] char *[])
+namespace
 {
 	using namespace std::literals::string_view_literals;
 
-	if(argc != 2) {
-		std::cout << "vmod: usage: <dir>\n"sv;
-		return EXIT_FAILURE;
+	struct insn_t final
+	{
+		std::size_t length{0};
+		std::size_t mask_offset{0};
+		std::size_t mask_length{0};
+	};
+
+	//just enough of a x86/x86_64 length decoder to walk compiler output
+	//masks operands that change between builds: rel32 branches, rip-relative/absolute displacements
+	//and the GOT relative accesses of 32bit PIC code
+	//got_regs carries the registers known to hold _GLOBAL_OFFSET_TABLE_ from one instruction of a function to the next
+	static bool decode_insn(const unsigned char *code, std::size_t size, bool x64, insn_t &insn, unsigned char &got_regs) noexcept
+	{
+		std::size_t len{0};
+
+		bool opsize16{false};
+		bool addrsize{false};
+		bool rex_w{false};
+
+		for(;; ++len) {
+			if(len >= size) {
+				return false;
+			}
+
+			unsigned char b{code[len]};
+			switch(b) {
+				case 0x66: opsize16 = true; continue;
+				case 0x67: addrsize = true; continue;
+				case 0xF0: case 0xF2: case 0xF3:
+				case 0x2E: case 0x36: case 0x3E: case 0x26: case 0x64: case 0x65:
+				continue;
+			}
+
+			if(x64 && (b & 0xF0) == 0x40) {
+				rex_w = ((b & 0x08) != 0);
+				continue;
+			}
+
+			break;
+		}
+
+		//16bit addressing is never emitted by the compilers we care about
+		if(addrsize && !x64) {
+			return false;
+		}
+
+		const std::size_t immz{opsize16 ? 2u : 4u};
+
+		bool has_modrm{false};
+		std::size_t imm{0};
+		bool mask_imm{false};
+
+		unsigned char op{code[len++]};
+		bool twobyte{false};
+
+		if(op == 0x0F) {
+			if(len >= size) {
+				return false;
+			}
+
+			twobyte = true;
+			op = code[len++];
+
+			if(op == 0x38) {
+				if(len >= size) {
+					return false;
+				}
+				++len;
+				has_modrm = true;
+			} else if(op == 0x3A) {
+				if(len >= size) {
+					return false;
+				}
+				++len;
+				has_modrm = true;
+				imm = 1;
+			} else if(op >= 0x80 && op <= 0x8F) {
+				imm = x64 ? 4 : immz;
+				mask_imm = true;
+			} else {
+				switch(op) {
+					case 0x05: case 0x06: case 0x07: case 0x08: case 0x09: case 0x0B: case 0x0E:
+					case 0x30: case 0x31: case 0x32: case 0x33: case 0x34: case 0x35: case 0x37:
+					case 0x77:
+					case 0xA0: case 0xA1: case 0xA2: case 0xA8: case 0xA9: case 0xAA:
+					case 0xC8: case 0xC9: case 0xCA: case 0xCB: case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+					break;
+					case 0x70: case 0x71: case 0x72: case 0x73:
+					case 0xA4: case 0xAC: case 0xBA:
+					case 0xC2: case 0xC4: case 0xC5: case 0xC6:
+					has_modrm = true;
+					imm = 1;
+					break;
+					default:
+					has_modrm = true;
+					break;
+				}
+			}
+		} else if((op == 0xC4 || op == 0xC5) && (x64 || (len < size && (code[len] & 0xC0) == 0xC0))) {
+			//vex
+			unsigned char map{1};
+			if(op == 0xC4) {
+				if(len + 1 >= size) {
+					return false;
+				}
+				map = (code[len] & 0x1F);
+				len += 2;
+			} else {
+				if(len >= size) {
+					return false;
+				}
+				++len;
+			}
+
+			if(len >= size) {
+				return false;
+			}
+
+			op = code[len++];
+			has_modrm = true;
+
+			if(map == 3) {
+				imm = 1;
+			} else if(map == 1) {
+				switch(op) {
+					case 0x70: case 0x71: case 0x72: case 0x73:
+					case 0xC2: case 0xC4: case 0xC5: case 0xC6:
+					imm = 1;
+					break;
+				}
+			}
+
+			twobyte = true;
+		} else if(op < 0x40 && (op & 0x07) < 0x04) {
+			has_modrm = true;
+		} else if(op < 0x40 && (op & 0x07) == 0x04) {
+			imm = 1;
+		} else if(op < 0x40 && (op & 0x07) == 0x05) {
+			imm = immz;
+		} else if(op >= 0x70 && op <= 0x7F) {
+			imm = 1;
+		} else if(op >= 0x84 && op <= 0x8F) {
+			has_modrm = true;
+		} else if(op >= 0xB0 && op <= 0xB7) {
+			imm = 1;
+		} else if(op >= 0xB8 && op <= 0xBF) {
+			imm = rex_w ? 8 : immz;
+		} else if(op >= 0xD8 && op <= 0xDF) {
+			has_modrm = true;
+		} else if(op >= 0xD0 && op <= 0xD3) {
+			has_modrm = true;
+		} else {
+			switch(op) {
+				case 0x62: case 0x63: case 0xFE: case 0xFF:
+				case 0xF6: case 0xF7:
+				case 0xC4: case 0xC5:
+				has_modrm = true;
+				break;
+				case 0x69: case 0x81: case 0xC7:
+				has_modrm = true;
+				imm = immz;
+				break;
+				case 0x6B: case 0x80: case 0x82: case 0x83: case 0xC0: case 0xC1: case 0xC6:
+				has_modrm = true;
+				imm = 1;
+				break;
+				case 0x6A: case 0xA8: case 0xCD: case 0xD4: case 0xD5:
+				case 0xE0: case 0xE1: case 0xE2: case 0xE3:
+				case 0xE4: case 0xE5: case 0xE6: case 0xE7: case 0xEB:
+				imm = 1;
+				break;
+				case 0x68: case 0xA9:
+				imm = immz;
+				break;
+				case 0xE8: case 0xE9:
+				imm = x64 ? 4 : immz;
+				mask_imm = true;
+				break;
+				case 0xA0: case 0xA1: case 0xA2: case 0xA3:
+				imm = (x64 && !addrsize) ? 8 : 4;
+				mask_imm = true;
+				break;
+				case 0xC2: case 0xCA:
+				imm = 2;
+				break;
+				case 0xC8:
+				imm = 3;
+				break;
+				case 0x9A: case 0xEA:
+				if(x64) {
+					return false;
+				}
+				imm = 6;
+				break;
+			}
+		}
+
+		insn.mask_offset = 0;
+		insn.mask_length = 0;
+
+		if(has_modrm) {
+			if(len >= size) {
+				return false;
+			}
+
+			unsigned char modrm{code[len++]};
+			unsigned char mod{static_cast<unsigned char>(modrm >> 6)};
+			unsigned char reg{static_cast<unsigned char>((modrm >> 3) & 0x07)};
+			unsigned char rm{static_cast<unsigned char>(modrm & 0x07)};
+
+			if(mod != 3) {
+				unsigned char base{rm};
+				std::size_t disp{0};
+				bool mask_disp{false};
+
+				if(rm == 4) {
+					if(len >= size) {
+						return false;
+					}
+
+					base = (code[len++] & 0x07);
+					if(mod == 0 && base == 5) {
+						disp = 4;
+						mask_disp = true;
+					}
+				} else if(mod == 0 && rm == 5) {
+					disp = 4;
+					mask_disp = true;
+				}
+
+				if(mod == 1) {
+					disp = 1;
+				} else if(mod == 2) {
+					disp = 4;
+					//@GOTOFF, only off a register loaded with the got, plain struct offsets stay exact
+					mask_disp = (!x64 && (got_regs & (1u << base)) != 0);
+				}
+
+				if(mask_disp) {
+					insn.mask_offset = len;
+					insn.mask_length = disp;
+				}
+
+				len += disp;
+			} else if(!twobyte && !x64 && op == 0x81 && reg == 0) {
+				//add reg, _GLOBAL_OFFSET_TABLE_
+				mask_imm = true;
+				got_regs |= static_cast<unsigned char>(1u << rm);
+			} else if(!twobyte && !x64 && (op == 0x89 || op == 0x8B)) {
+				//the got pointer is often moved out of the register the thunk loaded it into
+				unsigned char src{(op == 0x89) ? reg : rm};
+				unsigned char dst{(op == 0x89) ? rm : reg};
+				if((got_regs & (1u << src)) != 0) {
+					got_regs |= static_cast<unsigned char>(1u << dst);
+				} else {
+					got_regs &= static_cast<unsigned char>(~(1u << dst));
+				}
+			}
+
+			if(!twobyte) {
+				if(op == 0xF6 && reg < 2) {
+					imm = 1;
+				} else if(op == 0xF7 && reg < 2) {
+					imm = immz;
+				}
+			}
+		}
+
+		if(mask_imm) {
+			insn.mask_offset = len;
+			insn.mask_length = imm;
+		}
+
+		len += imm;
+
+		if(len > size) {
+			return false;
+		}
+
+		insn.length = len;
+		return true;
 	}
 
-	std::filesystem::path game_root;
-	std::filesystem::path game_dir;
+	static void split_name(std::string_view full, std::string_view &qual, std::string_view &name) noexcept
+	{
+		constexpr std::string_view anon_ns{"(anonymous namespace)"sv};
+
+		std::size_t depth{0};
+		std::size_t last_sep{std::string_view::npos};
+
+		for(std::size_t i{0}; i < full.size(); ++i) {
+			char c{full[i]};
+			if(c == '(') {
+				if(full.substr(i).starts_with(anon_ns)) {
+					i += anon_ns.size() - 1;
+					continue;
+				}
+				if(depth == 0) {
+					break;
+				}
+				++depth;
+			} else if(c == '<') {
+				++depth;
+			} else if(c == '>' || c == ')') {
+				if(depth > 0) {
+					--depth;
+				}
+			} else if(c == ':' && depth == 0 && i + 1 < full.size() && full[i+1] == ':') {
+				last_sep = i;
+				++i;
+			}
+		}
 
+		if(last_sep == std::string_view::npos) {
+			qual = {};
+			name = full;
+		} else {
+			qual = full.substr(0, last_sep);
+			name = full.substr(last_sep + 2);
+		}
+	}
+
+	static void append_quoted(std::string &out, std::string_view str) noexcept
 	{
-		char exe[PATH_MAX];
-		ssize_t len{readlink("/proc/self/exe", exe, sizeof(exe))};
-		exe[len] = '\0';
+		out += '"';
+		for(char c : str) {
+			if(c == '"' || c == '\\') {
+				out += '\\';
+			}
+			out += c;
+		}
+		out += '"';
+	}
 
-		game_root = exe;
-		game_root = game_root.parent_path();
-		game_root = game_root.parent_path();
-		game_root = game_root.parent_path();
-		game_root = game_root.parent_path();
+	struct request_t final
+	{
+		std::string name;
+
+		bool found{false};
+		std::size_t offset{0};
+		std::size_t size{0};
 
-		game_dir = game_root;
+		bool done{false};
+		std::string err;
+		std::vector<unsigned char> bytes;
+		std::vector<bool> wild;
+	};
+}
+
+int main(int argc, char *argv[], [[maybe_unused]] char *[])
+{
+	using namespace std::literals::string_view_literals;
 
-		game_root = game_root.parent_path();
+	if(argc != 4) {
+		std::cout << "vmod: usage: <file> <names file> <output yaml>\n"sv;
+		return EXIT_FAILURE;
 	}
 
-	std::filesystem::path dir{argv[1]};
+	std::filesystem::path binary{argv[1]};
+	std::filesystem::path names_path{argv[2]};
+	std::filesystem::path out_path{argv[3]};
 
-#ifndef GSDK_NO_SYMBOLS
+	//this reads the symbols of the input itself so it also works in builds without symbol support
 	if(!vmod::symbol_cache::initialize()) {
 		return EXIT_FAILURE;
 	}
 
-	//TODO!!!
+	std::vector<request_t> requests;
+	std::unordered_map<std::string, std::size_t> requests_map;
+
+	{
+		std::size_t names_size{0};
+		std::unique_ptr<unsigned char[]> names_data{vmod::read_file(names_path, names_size)};
+		if(!names_data) {
+			std::cout << "vmod: failed to read '"sv << names_path << "'\n"sv;
+			return EXIT_FAILURE;
+		}
+
+		std::string_view names{reinterpret_cast<const char *>(names_data.get()), names_size};
+		while(!names.empty()) {
+			std::size_t nl{names.find('\n')};
+			std::string_view line{names.substr(0, nl)};
+			names.remove_prefix(nl == std::string_view::npos ? names.size() : nl + 1);
+
+			while(!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) {
+				line.remove_suffix(1);
+			}
+			while(!line.empty() && (line.front() == ' ' || line.front() == '\t')) {
+				line.remove_prefix(1);
+			}
+
+			if(line.empty() || line.front() == '#') {
+				continue;
+			}
+
+			std::string name{line};
+			if(requests_map.find(name) != requests_map.end()) {
+				continue;
+			}
+
+			requests_map.emplace(name, requests.size());
+			request_t &req{requests.emplace_back()};
+			req.name = std::move(name);
+		}
+	}
+
+	if(requests.empty()) {
+		std::cout << "vmod: no names in '"sv << names_path << "'\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	int fd{open(binary.c_str(), O_RDONLY)};
+	if(fd < 0) {
+		int err{errno};
+		std::cout << "vmod: failed to open '"sv << binary << "': '"sv << strerror(err) << "'\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	Elf *elf{elf_begin(fd, ELF_C_READ, nullptr)};
+	if(!elf) {
+		int err{elf_errno()};
+		std::cout << "vmod: failed to read '"sv << binary << "': '"sv << elf_errmsg(err) << "'\n"sv;
+		close(fd);
+		return EXIT_FAILURE;
+	}
+
+	struct scope_elf final {
+		inline scope_elf(Elf *elf_, int fd_) noexcept
+			: elf{elf_}, fd{fd_} {}
+		inline ~scope_elf() noexcept {
+			elf_end(elf);
+			close(fd);
+		}
+	private:
+		Elf *elf;
+		int fd;
+	};
+
+	scope_elf self{elf, fd};
+
+	GElf_Ehdr ehdr;
+	if(elf_kind(elf) != ELF_K_ELF || !gelf_getehdr(elf, &ehdr)) {
+		std::cout << "vmod: '"sv << binary << "' is not a elf file\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	if(ehdr.e_machine != EM_386 && ehdr.e_machine != EM_X86_64) {
+		std::cout << "vmod: '"sv << binary << "' is not a x86 binary\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	const bool x64{gelf_getclass(elf) == ELFCLASS64};
+	const bool relocatable{ehdr.e_type == ET_REL};
+
+	std::size_t strndx{0};
+	elf_getshdrstrndx(elf, &strndx);
+
+	GElf_Shdr scn_hdr;
+
+	std::size_t text_ndx{0};
+	std::uint64_t text_addr{0};
+	const unsigned char *text{nullptr};
+	std::size_t text_size{0};
+
+	Elf_Scn *scn{elf_nextscn(elf, nullptr)};
+	while(scn) {
+		struct scope_nextscn final {
+			inline scope_nextscn(Elf *elf_, Elf_Scn *&scn_) noexcept
+				: elf{elf_}, scn{scn_} {}
+			inline ~scope_nextscn() noexcept
+			{ scn = elf_nextscn(elf, scn); }
+		private:
+			Elf *elf;
+			Elf_Scn *&scn;
+		};
+
+		scope_nextscn snscn{elf, scn};
+
+		if(!gelf_getshdr(scn, &scn_hdr)) {
+			continue;
+		}
+
+		if(scn_hdr.sh_type != SHT_PROGBITS) {
+			continue;
+		}
+
+		std::string_view name{elf_strptr(elf, strndx, scn_hdr.sh_name)};
+		if(name != ".text"sv) {
+			continue;
+		}
+
+		Elf_Data *scn_data{elf_getdata(scn, nullptr)};
+		if(!scn_data || !scn_data->d_buf) {
+			break;
+		}
+
+		text_ndx = elf_ndxscn(scn);
+		text_addr = scn_hdr.sh_addr;
+		text = static_cast<const unsigned char *>(scn_data->d_buf);
+		text_size = scn_data->d_size;
+		break;
+	}
+
+	if(!text) {
+		std::cout << "vmod: '"sv << binary << "' has no .text section\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	struct region_t final
+	{
+		const unsigned char *data;
+		std::size_t size;
+	};
+
+	//the runtime scanner searches every executable segment, a guess only unique in .text can still be ambiguous at load
+	std::vector<region_t> regions;
+
+	if(!relocatable) {
+		std::size_t raw_size{0};
+		const unsigned char *raw{reinterpret_cast<const unsigned char *>(elf_rawfile(elf, &raw_size))};
+
+		std::size_t num_phdrs{0};
+		if(raw && elf_getphdrnum(elf, &num_phdrs) == 0) {
+			GElf_Shdr text_hdr;
+			Elf_Scn *text_scn{elf_getscn(elf, text_ndx)};
+
+			if(text_scn && gelf_getshdr(text_scn, &text_hdr) && text_hdr.sh_offset + text_size <= raw_size) {
+				//functions are read from the file image too so they can be told apart from the matches
+				text = raw + text_hdr.sh_offset;
+
+				GElf_Phdr phdr;
+				for(std::size_t i{0}; i < num_phdrs; ++i) {
+					if(!gelf_getphdr(elf, static_cast<int>(i), &phdr)) {
+						continue;
+					}
+
+					if(phdr.p_type != PT_LOAD || !(phdr.p_flags & PF_X)) {
+						continue;
+					}
+
+					if(phdr.p_offset + phdr.p_filesz > raw_size) {
+						continue;
+					}
+
+					regions.emplace_back(region_t{raw + phdr.p_offset, static_cast<std::size_t>(phdr.p_filesz)});
+				}
+			}
+		}
+	}
+
+	if(regions.empty()) {
+		regions.emplace_back(region_t{text, text_size});
+	}
+
+	//bytes touched by relocations are never stable
+	std::vector<bool> reloc_mask(text_size, false);
+
+	auto mark_reloc{
+		[&reloc_mask,text_size](std::uint64_t off, std::size_t len) noexcept -> void {
+			for(std::size_t i{0}; i < len; ++i) {
+				if(off + i < text_size) {
+					reloc_mask[static_cast<std::size_t>(off + i)] = true;
+				}
+			}
+		}
+	};
+
+	std::size_t num_syms_found{0};
+
+	GElf_Sym sym;
+	GElf_Rel rel;
+	GElf_Rela rela;
+
+	scn = elf_nextscn(elf, nullptr);
+	while(scn) {
+		struct scope_nextscn final {
+			inline scope_nextscn(Elf *elf_, Elf_Scn *&scn_) noexcept
+				: elf{elf_}, scn{scn_} {}
+			inline ~scope_nextscn() noexcept
+			{ scn = elf_nextscn(elf, scn); }
+		private:
+			Elf *elf;
+			Elf_Scn *&scn;
+		};
+
+		scope_nextscn snscn{elf, scn};
+
+		if(!gelf_getshdr(scn, &scn_hdr)) {
+			continue;
+		}
+
+		switch(scn_hdr.sh_type) {
+			case SHT_SYMTAB:
+			case SHT_DYNSYM:
+			case SHT_REL:
+			case SHT_RELA: break;
+			default: continue;
+		}
+
+		if(scn_hdr.sh_entsize == 0) {
+			continue;
+		}
+
+		Elf_Data *scn_data{elf_getdata(scn, nullptr)};
+		if(!scn_data) {
+			continue;
+		}
+
+		std::size_t count{static_cast<std::size_t>(scn_hdr.sh_size) / static_cast<std::size_t>(scn_hdr.sh_entsize)};
+
+		if(scn_hdr.sh_type == SHT_REL || scn_hdr.sh_type == SHT_RELA) {
+			if(relocatable && scn_hdr.sh_info != text_ndx) {
+				continue;
+			}
+
+			for(std::size_t i{0}; i < count; ++i) {
+				std::uint64_t off;
+				std::size_t type;
+
+				if(scn_hdr.sh_type == SHT_REL) {
+					if(!gelf_getrel(scn_data, static_cast<int>(i), &rel)) {
+						continue;
+					}
+					off = rel.r_offset;
+					type = static_cast<std::size_t>(GELF_R_TYPE(rel.r_info));
+				} else {
+					if(!gelf_getrela(scn_data, static_cast<int>(i), &rela)) {
+						continue;
+					}
+					off = rela.r_offset;
+					type = static_cast<std::size_t>(GELF_R_TYPE(rela.r_info));
+				}
+
+				if(!relocatable) {
+					if(off < text_addr) {
+						continue;
+					}
+					off -= text_addr;
+				}
+
+				mark_reloc(off, (x64 && (type == R_X86_64_64 || type == R_X86_64_RELATIVE)) ? 8 : 4);
+			}
+
+			continue;
+		}
+
+		for(std::size_t i{0}; i < count; ++i) {
+			if(!gelf_getsym(scn_data, static_cast<int>(i), &sym)) {
+				continue;
+			}
+
+			if(GELF_ST_TYPE(sym.st_info) != STT_FUNC) {
+				continue;
+			}
+
+			if(sym.st_shndx != text_ndx || sym.st_size == 0) {
+				continue;
+			}
+
+			const char *name_mangled{elf_strptr(elf, scn_hdr.sh_link, sym.st_name)};
+			if(!name_mangled || name_mangled[0] == '\0') {
+				continue;
+			}
+
+			std::string name;
+
+			char *name_unmangled{cplus_demangle_v3(name_mangled, DMGL_GNU_V3|DMGL_PARAMS|DMGL_VERBOSE|DMGL_TYPES|DMGL_ANSI)};
+			if(name_unmangled) {
+				name = name_unmangled;
+				std::free(name_unmangled);
+			} else {
+				name = name_mangled;
+			}
+
+			auto it{requests_map.find(name)};
+			if(it == requests_map.end()) {
+				continue;
+			}
+
+			request_t &req{requests[it->second]};
+			if(req.found) {
+				continue;
+			}
+
+			std::uint64_t off{sym.st_value};
+			if(!relocatable) {
+				if(off < text_addr) {
+					continue;
+				}
+				off -= text_addr;
+			}
+
+			if(off + sym.st_size > text_size) {
+				continue;
+			}
+
+			req.found = true;
+			req.offset = static_cast<std::size_t>(off);
+			req.size = static_cast<std::size_t>(sym.st_size);
+			++num_syms_found;
+		}
+	}
+
+	if(num_syms_found == 0) {
+		std::cout << "vmod: none of the names were found in '"sv << binary << "'\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	auto generate{
+		[text,x64,&reloc_mask,&regions](request_t &req) noexcept -> void {
+			using namespace std::literals::string_literals;
+
+			const unsigned char *func{text + req.offset};
+
+			struct candidate_t final
+			{
+				const unsigned char *at;
+				const unsigned char *end;
+			};
+
+			std::vector<candidate_t> candidates;
+			bool first{true};
+
+			unsigned char got_regs{0};
+
+			std::size_t pos{0};
+			while(pos < req.size) {
+				insn_t insn;
+				if(!decode_insn(func + pos, req.size - pos, x64, insn, got_regs)) {
+					req.err = "failed to decode instruction at +0x"s;
+					char buffer[2 * sizeof(std::size_t)];
+					auto res{std::to_chars(buffer, buffer + sizeof(buffer), pos, 16)};
+					req.err.append(buffer, res.ptr);
+					return;
+				}
+
+				const std::size_t begin{pos};
+
+				for(std::size_t i{0}; i < insn.length; ++i) {
+					req.bytes.emplace_back(func[pos + i]);
+					req.wild.emplace_back(reloc_mask[req.offset + pos + i] || (i >= insn.mask_offset && i < insn.mask_offset + insn.mask_length));
+				}
+
+				pos += insn.length;
+
+				auto matches{
+					[&req,begin,end = pos](const unsigned char *at) noexcept -> bool {
+						for(std::size_t i{begin}; i < end; ++i) {
+							if(!req.wild[i] && at[i] != req.bytes[i]) {
+								return false;
+							}
+						}
+						return true;
+					}
+				};
+
+				if(first) {
+					std::size_t fixed{0};
+					while(fixed < pos && req.wild[fixed]) {
+						++fixed;
+					}
+
+					if(fixed == pos) {
+						continue;
+					}
+
+					first = false;
+
+					const unsigned char needle{req.bytes[fixed]};
+
+					for(const region_t &region : regions) {
+						if(region.size < pos) {
+							continue;
+						}
+
+						const unsigned char *region_end{region.data + region.size};
+
+						const unsigned char *it{region.data + fixed};
+						const unsigned char *end{region.data + (region.size - pos) + fixed + 1};
+						while(it < end) {
+							it = static_cast<const unsigned char *>(std::memchr(it, needle, static_cast<std::size_t>(end - it)));
+							if(!it) {
+								break;
+							}
+
+							const unsigned char *at{it - fixed};
+							if(at != func && matches(at)) {
+								candidates.emplace_back(candidate_t{at, region_end});
+							}
+
+							++it;
+						}
+					}
+				} else {
+					std::erase_if(candidates,
+						[&matches,pos](const candidate_t &candidate) noexcept -> bool {
+							return (static_cast<std::size_t>(candidate.end - candidate.at) < pos || !matches(candidate.at));
+						}
+					);
+				}
+
+				if(candidates.empty()) {
+					while(!req.wild.empty() && req.wild.back()) {
+						req.wild.pop_back();
+						req.bytes.pop_back();
+					}
+
+					req.done = true;
+					return;
+				}
+			}
+
+			req.err = "function body is not unique"s;
+		}
+	};
+
+	{
+		std::atomic<std::size_t> next{0};
+
+		auto worker{
+			[&requests,&next,&generate]() noexcept -> void {
+				for(;;) {
+					std::size_t i{next.fetch_add(1, std::memory_order_relaxed)};
+					if(i >= requests.size()) {
+						break;
+					}
+
+					request_t &req{requests[i]};
+					if(!req.found) {
+						continue;
+					}
+
+					generate(req);
+				}
+			}
+		};
+
+		std::size_t num_threads{static_cast<std::size_t>(std::thread::hardware_concurrency())};
+		num_threads = std::clamp<std::size_t>(num_threads, 1, num_syms_found);
+
+		std::vector<std::thread> threads;
+		threads.reserve(num_threads - 1);
+		for(std::size_t i{1}; i < num_threads; ++i) {
+			threads.emplace_back(worker);
+		}
+
+		worker();
+
+		for(std::thread &thr : threads) {
+			thr.join();
+		}
+	}
+
+	auto append_sig{
+		[](std::string &out, const request_t &req, std::string_view indent) noexcept -> void {
+			constexpr std::string_view hex{"0123456789ABCDEF"sv};
+
+			out += indent;
+			out += "method: byte_scan_mem\n"sv;
+			out += indent;
+			out += "bytes: ["sv;
+			for(std::size_t i{0}; i < req.bytes.size(); ++i) {
+				if(i > 0) {
+					out += ", "sv;
+				}
+				if(req.wild[i]) {
+					out += "null"sv;
+				} else {
+					out += "0x"sv;
+					out += hex[req.bytes[i] >> 4];
+					out += hex[req.bytes[i] & 0x0F];
+				}
+			}
+			out += "]\n"sv;
+		}
+	};
+
+	std::string out;
+	std::size_t num_written{0};
+
+	std::vector<std::string_view> quals;
+
+	for(const request_t &req : requests) {
+		if(!req.found) {
+			std::cout << "vmod: '"sv << req.name << "' was not found\n"sv;
+			continue;
+		} else if(!req.done) {
+			std::cout << "vmod: failed to generate signature for '"sv << req.name << "': '"sv << req.err << "'\n"sv;
+			continue;
+		}
+
+		std::string_view qual;
+		std::string_view name;
+		split_name(req.name, qual, name);
+
+		if(qual.empty()) {
+			append_quoted(out, name);
+			out += ":\n"sv;
+			append_sig(out, req, "  "sv);
+			++num_written;
+		} else if(std::find(quals.begin(), quals.end(), qual) == quals.end()) {
+			quals.emplace_back(qual);
+		}
+	}
+
+	for(std::string_view qual : quals) {
+		append_quoted(out, qual);
+		out += ":\n"sv;
+
+		for(const request_t &req : requests) {
+			if(!req.done) {
+				continue;
+			}
+
+			std::string_view req_qual;
+			std::string_view name;
+			split_name(req.name, req_qual, name);
+
+			if(req_qual != qual) {
+				continue;
+			}
+
+			out += "  - "sv;
+			append_quoted(out, name);
+			out += ":\n"sv;
+			append_sig(out, req, "      "sv);
+			++num_written;
+		}
+	}
+
+	vmod::write_file(out_path, reinterpret_cast<const unsigned char *>(out.c_str()), out.length());
+
+	std::cout << "vmod: wrote "sv << num_written << " of "sv << requests.size() << " signatures to "sv << out_path << '\n';
 
-	return EXIT_SUCCESS;
-#else
-	std::cout << "vmod: no symbols available\n"sv;
-	return EXIT_FAILURE;
-#endif
+	return num_written > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,118 @@
+#include "gsdk_library.hpp"
+#include "symbol_cache.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <charconv>
+#include <chrono>
+#include <sys/resource.h>
+
+static double to_ms(std::chrono::steady_clock::duration dur) noexcept
+{ return std::chrono::duration<double, std::milli>{dur}.count(); }
+
+static long peak_rss_kb() noexcept
+{
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) {
+		return -1;
+	}
+
+	return usage.ru_maxrss;
+}
+
+int main(int argc, char *argv[], [[maybe_unused]] char *[])
+{
+	using namespace std::literals::string_view_literals;
+
+	if(argc < 2) {
+		std::cout << "vmod: usage: <file> [iterations] [compact] [lazy]\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	std::filesystem::path binary{argv[1]};
+
+	std::size_t iterations{1};
+	bool compact{false};
+	bool lazy{false};
+
+	for(int i{2}; i < argc; ++i) {
+		std::string_view arg{argv[i]};
+		if(arg == "compact"sv) {
+			compact = true;
+		} else if(arg == "lazy"sv) {
+			lazy = true;
+		} else {
+			auto res{std::from_chars(arg.data(), arg.data() + arg.size(), iterations)};
+			if(res.ec != std::errc{} || iterations == 0) {
+				std::cout << "vmod: invalid iteration count '"sv << arg << "'\n"sv;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	if(!vmod::symbol_cache::initialize()) {
+		return EXIT_FAILURE;
+	}
+
+	vmod::symbol_cache::set_compact_storage(compact);
+	vmod::symbol_cache::set_lazy_symbols(lazy);
+
+	vmod::library lib;
+	if(!lib.load(binary)) {
+		std::cout << "vmod: failed to load '"sv << binary << "': '"sv << lib.error_string() << "'\n"sv;
+		return EXIT_FAILURE;
+	}
+
+	unsigned char *base{lib.base()};
+
+	//one json object per line so runs can be appended and diffed
+	for(std::size_t i{0}; i < iterations; ++i) {
+		std::unique_ptr<vmod::symbol_cache> syms{new vmod::symbol_cache};
+
+		auto load_begin{std::chrono::steady_clock::now()};
+		if(!syms->load(binary, base)) {
+			std::cout << "vmod: failed to read '"sv << binary << "': '"sv << syms->error_string() << "'\n"sv;
+			return EXIT_FAILURE;
+		}
+		auto load_time{std::chrono::steady_clock::now() - load_begin};
+
+		std::size_t num_quals{0};
+		std::size_t num_names{0};
+		std::size_t num_vtables{0};
+
+		for(const auto &it : *syms) {
+			++num_quals;
+			num_names += static_cast<std::size_t>(std::distance(it.second->begin(), it.second->end()));
+
+			const vmod::symbol_cache::class_info *info{dynamic_cast<const vmod::symbol_cache::class_info *>(it.second.get())};
+			if(info && info->vtable().size() > 0) {
+				++num_vtables;
+			}
+		}
+
+		std::size_t num_globals{static_cast<std::size_t>(std::distance(syms->global().begin(), syms->global().end()))};
+
+		const vmod::symbol_cache::timings_t &timings{syms->timings()};
+
+		std::cout << "{\"binary\":"sv << binary
+			<< ",\"iteration\":"sv << i
+			<< ",\"compact\":"sv << (compact ? "true"sv : "false"sv)
+			<< ",\"lazy\":"sv << (lazy ? "true"sv : "false"sv)
+			<< ",\"load_ms\":"sv << to_ms(load_time)
+			<< ",\"collect_ms\":"sv << to_ms(timings.symbols_collect)
+			<< ",\"demangle_ms\":"sv << to_ms(timings.symbols_demangle)
+			<< ",\"merge_ms\":"sv << to_ms(timings.symbols_merge)
+			<< ",\"vtables_ms\":"sv << to_ms(timings.vtables)
+			<< ",\"threads\":"sv << timings.threads
+			<< ",\"symbols\":"sv << timings.symbols
+			<< ",\"qualifications\":"sv << num_quals
+			<< ",\"names\":"sv << num_names
+			<< ",\"globals\":"sv << num_globals
+			<< ",\"vtables\":"sv << num_vtables
+			<< ",\"storage_bytes\":"sv << syms->storage_size()
+			<< ",\"peak_rss_kb\":"sv << peak_rss_kb()
+			<< "}\n"sv;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -1,6 +1,6 @@
 #include "symbol_cache.hpp"
 
-#ifndef __VMOD_COMPILING_VTABLE_DUMPER
+#if !defined __VMOD_COMPILING_VTABLE_DUMPER && !defined __VMOD_COMPILING_SYMBOL_BENCH
 #include "gsdk/config.hpp"
 #endif
 
@@ -9,12 +9,24 @@
 #include <fcntl.h>
 #include <cstring>
 #include <iostream>
+#include <thread>
+#include <algorithm>
+#include <tuple>
+#include <charconv>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 #ifndef __VMOD_COMPILING_SYMBOL_TOOL
 #include "filesystem.hpp"
 #include "gsdk.hpp"
 #include "main.hpp"
+#include "gsdk/tier0/commandline.hpp"
+#include "xxhash.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <emmintrin.h>
 #include <smmintrin.h>
+#include <immintrin.h>
 #endif
 
 namespace vmod
@@ -25,10 +37,267 @@ namespace vmod
 
 #ifndef __VMOD_COMPILING_SYMBOL_TOOL
 	std::filesystem::path symbol_cache::yamls_dir;
+	std::filesystem::path symbol_cache::sigs_dir;
+	signature_bundle symbol_cache::bundle;
+	#ifndef GSDK_NO_SYMBOLS
+	std::filesystem::path symbol_cache::index_dir;
+	#endif
 #endif
 
 #ifndef GSDK_NO_SYMBOLS
 	int symbol_cache::demangle_flags{DMGL_GNU_V3|DMGL_PARAMS|DMGL_VERBOSE|DMGL_TYPES|DMGL_ANSI};
+	bool symbol_cache::lazy_symbols{false};
+#endif
+
+	bool symbol_cache::compact_storage{false};
+	thread_local symbol_cache::storage_arena *symbol_cache::current_arena{nullptr};
+
+	namespace detail
+	{
+		struct arena_chunks_t final
+		{
+			std::map<std::uintptr_t, std::uintptr_t> ranges;
+			std::shared_mutex mx;
+		};
+
+		//never destroyed, caches owned by other statics still unregister their chunks at exit
+		static arena_chunks_t &arena_chunks() noexcept
+		{
+			static arena_chunks_t *chunks{new arena_chunks_t};
+			return *chunks;
+		}
+	}
+
+	symbol_cache::storage_arena::~storage_arena() noexcept
+	{
+		if(chunks.empty()) {
+			return;
+		}
+
+		detail::arena_chunks_t &arena_chunks{detail::arena_chunks()};
+
+		std::lock_guard<std::shared_mutex> lock{arena_chunks.mx};
+		for(const auto &chunk : chunks) {
+			arena_chunks.ranges.erase(reinterpret_cast<std::uintptr_t>(chunk.get()));
+		}
+	}
+
+	unsigned char *symbol_cache::storage_arena::new_chunk(std::size_t size) noexcept
+	{
+		unsigned char *chunk{chunks.emplace_back(new unsigned char[size]).get()};
+		size_ += size;
+
+		{
+			detail::arena_chunks_t &arena_chunks{detail::arena_chunks()};
+
+			std::lock_guard<std::shared_mutex> lock{arena_chunks.mx};
+			arena_chunks.ranges.emplace(reinterpret_cast<std::uintptr_t>(chunk), reinterpret_cast<std::uintptr_t>(chunk + size));
+		}
+
+		return chunk;
+	}
+
+	bool symbol_cache::storage_arena::owns(const void *ptr) noexcept
+	{
+		std::uintptr_t addr{reinterpret_cast<std::uintptr_t>(ptr)};
+
+		detail::arena_chunks_t &arena_chunks{detail::arena_chunks()};
+
+		std::shared_lock<std::shared_mutex> lock{arena_chunks.mx};
+
+		auto it{arena_chunks.ranges.upper_bound(addr)};
+		if(it == arena_chunks.ranges.begin()) {
+			return false;
+		}
+
+		--it;
+		return (addr < it->second);
+	}
+
+	void *symbol_cache::storage_arena::allocate(std::size_t size, std::size_t align) noexcept
+	{
+		std::size_t pad{static_cast<std::size_t>(-reinterpret_cast<std::uintptr_t>(cur)) & (align - 1)};
+
+		if(!cur || (pad + size) > static_cast<std::size_t>(end - cur)) {
+			//big blocks get their own chunk so the current one isn't wasted
+			if(size > (chunk_size / 4)) {
+				unsigned char *ptr{new_chunk(size + align)};
+				ptr += (static_cast<std::size_t>(-reinterpret_cast<std::uintptr_t>(ptr)) & (align - 1));
+				return ptr;
+			}
+
+			cur = new_chunk(chunk_size);
+			end = cur + chunk_size;
+			pad = (static_cast<std::size_t>(-reinterpret_cast<std::uintptr_t>(cur)) & (align - 1));
+		}
+
+		unsigned char *ptr{cur + pad};
+		cur = ptr + size;
+		return ptr;
+	}
+
+	void symbol_cache::storage_arena::adopt(storage_arena &other) noexcept
+	{
+		chunks.reserve(chunks.size() + other.chunks.size());
+		for(auto &chunk : other.chunks) {
+			chunks.emplace_back(std::move(chunk));
+		}
+		other.chunks.clear();
+
+		size_ += other.size_;
+
+		other.cur = nullptr;
+		other.end = nullptr;
+		other.size_ = 0;
+	}
+
+	void *symbol_cache::storage_allocate(std::size_t size, std::size_t align) noexcept
+	{
+		//anything allocated without an arena set (lazy materialization, inserts after load) comes from the heap
+		if(compact_storage && current_arena) {
+			return current_arena->allocate(size, align);
+		}
+
+		if(align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			return ::operator new(size, std::align_val_t{align});
+		} else {
+			return ::operator new(size);
+		}
+	}
+
+	void symbol_cache::storage_deallocate(void *ptr, std::size_t align) noexcept
+	{
+		//arena memory goes away with its arena, heap fallbacks still have to be freed
+		if(compact_storage && storage_arena::owns(ptr)) {
+			return;
+		}
+
+		if(align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			::operator delete(ptr, std::align_val_t{align});
+		} else {
+			::operator delete(ptr);
+		}
+	}
+
+#ifndef __VMOD_COMPILING_SYMBOL_TOOL
+	namespace detail
+	{
+		static constexpr std::string_view sigs_magic{"VMODSIGC"};
+		static constexpr std::uint32_t sigs_version{1};
+
+		struct sigs_header_t final
+		{
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t ptr_size;
+			std::uint64_t module_hash;
+			std::uint64_t yaml_hash;
+			std::uint64_t num_sigs;
+		};
+
+		static bool hash_file(int fd, std::uint64_t &hash) noexcept
+		{
+			struct stat stat;
+			if(fstat(fd, &stat) != 0 || stat.st_size <= 0) {
+				return false;
+			}
+
+			std::size_t size{static_cast<std::size_t>(stat.st_size)};
+
+			void *data{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+			if(data == MAP_FAILED) {
+				return false;
+			}
+
+			hash = XXH3_64bits(data, size);
+
+			munmap(data, size);
+
+			return true;
+		}
+
+		static bool check_literal_wildcard_byte() noexcept;
+	}
+#endif
+
+#if !defined __VMOD_COMPILING_SYMBOL_TOOL && !defined GSDK_NO_SYMBOLS
+	namespace detail
+	{
+		static constexpr std::string_view index_magic{"VMODSYMI"};
+		static constexpr std::uint32_t index_version{1};
+
+		struct index_header_t final
+		{
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t ptr_size;
+			std::uint64_t hash;
+			std::uint64_t num_quals;
+			std::uint64_t num_names;
+			std::uint64_t num_locals;
+			std::uint64_t num_ventries;
+			std::uint64_t num_refs;
+			std::uint64_t strings_size;
+		};
+
+		enum : std::uint64_t
+		{
+			index_qual_vtable = (1 << 0),
+			index_qual_vtable_size = (1 << 1)
+		};
+
+		struct index_qual_t final
+		{
+			std::uint64_t str_off;
+			std::uint64_t str_len;
+			std::uint64_t first_name;
+			std::uint64_t num_names;
+			std::uint64_t first_ventry;
+			std::uint64_t num_ventries;
+			std::uint64_t vtable_offset;
+			std::uint64_t vtable_size;
+			std::uint64_t known_vtable_size;
+			std::uint64_t flags;
+		};
+
+		enum class index_name_kind : std::uint32_t
+		{
+			plain,
+			ctor,
+			dtor
+		};
+
+		struct index_name_t final
+		{
+			std::uint64_t str_off;
+			std::uint64_t str_len;
+			std::uint64_t offset;
+			std::uint64_t size;
+			std::uint64_t vindex;
+			std::uint64_t first_local;
+			std::uint64_t num_locals;
+			index_name_kind kind;
+			std::uint32_t sub_kind;
+		};
+
+		struct index_ventry_t final
+		{
+			std::uint64_t type;
+			std::uint64_t value;
+			std::uint64_t first_ref;
+			std::uint64_t num_refs;
+		};
+
+		struct index_ref_t final
+		{
+			std::uint64_t qual;
+			std::uint64_t name;
+		};
+
+		static_assert(sizeof(index_header_t) % alignof(std::uint64_t) == 0);
+		static_assert(sizeof(index_qual_t) % alignof(std::uint64_t) == 0);
+		static_assert(sizeof(index_name_t) % alignof(std::uint64_t) == 0);
+	}
 #endif
 
 	bool symbol_cache::initialize() noexcept
@@ -44,8 +313,30 @@ namespace vmod
 	#endif
 
 	#ifndef __VMOD_COMPILING_SYMBOL_TOOL
+		if(!detail::check_literal_wildcard_byte()) {
+			std::cout << "vmod: signature scanner treats literal bytes as wildcards\n"sv;
+			return false;
+		}
+
+		compact_storage = (CommandLine()->FindParm("-vmod_syms_compact") != 0);
+		#ifndef GSDK_NO_SYMBOLS
+		lazy_symbols = (CommandLine()->FindParm("-vmod_syms_lazy") != 0);
+		#endif
+
 		yamls_dir = main::instance().root_dir();
 		yamls_dir /= "syms"sv;
+
+		sigs_dir = main::instance().root_dir();
+		sigs_dir /= "cache/sigs"sv;
+
+		std::filesystem::path bundle_path{yamls_dir};
+		bundle_path /= "signatures.bin"sv;
+		bundle.open(bundle_path);
+
+		#ifndef GSDK_NO_SYMBOLS
+		index_dir = main::instance().root_dir();
+		index_dir /= "cache/syms"sv;
+		#endif
 	#endif
 
 		return true;
@@ -58,6 +349,8 @@ namespace vmod
 
 		std::filesystem::path ext{path.extension()};
 
+		scope_arena sarena{arena_};
+
 		pure_virt_it = global_qual.names.end();
 		delt_virt_it = global_qual.names.end();
 
@@ -97,12 +390,68 @@ namespace vmod
 					return false;
 				}
 
+			#ifndef __VMOD_COMPILING_SYMBOL_TOOL
+				std::filesystem::path index_path{index_dir};
+				index_path /= path.filename();
+				{
+					//libraries with the same name in different directories must not share an index
+					std::error_code ec;
+					std::filesystem::path canonical_path{std::filesystem::weakly_canonical(path, ec)};
+					if(ec) {
+						canonical_path = path;
+					}
+
+					const std::string &canonical_str{canonical_path.native()};
+
+					char temp_buffer[17];
+
+					char *begin{temp_buffer};
+					char *end{begin + sizeof(temp_buffer)};
+
+					std::to_chars_result tc_res{std::to_chars(begin, end, XXH3_64bits(canonical_str.c_str(), canonical_str.length()), 16)};
+					tc_res.ptr[0] = '\0';
+
+					index_path += '_';
+					index_path += begin;
+				}
+				index_path += ".idx"sv;
+
+				//the index holds fully materialized tables so lazy loading bypasses it
+				std::uint64_t hash{0};
+				bool hashed{!lazy_symbols && detail::hash_file(fd, hash)};
+
+				if(hashed) {
+					auto index_begin{std::chrono::steady_clock::now()};
+					bool indexed{read_index(index_path, hash, base)};
+					timings_.index = (std::chrono::steady_clock::now() - index_begin);
+
+					if(indexed) {
+						timings_.from_index = true;
+						report_timings(path);
+						close(fd);
+						return true;
+					}
+				}
+			#endif
+
 				if(!read_elf_symbols(fd, base)) {
 					close(fd);
 					return false;
 				}
 
-				resolve_vtables(base, true);
+				if(lazy_syms.empty()) {
+					auto vtables_begin{std::chrono::steady_clock::now()};
+					resolve_vtables(base, true);
+					timings_.vtables = (std::chrono::steady_clock::now() - vtables_begin);
+				}
+
+			#ifndef __VMOD_COMPILING_SYMBOL_TOOL
+				if(hashed) {
+					write_index(index_path, hash);
+				}
+
+				report_timings(path);
+			#endif
 
 				close(fd);
 				return true;
@@ -149,6 +498,36 @@ namespace vmod
 		}
 	}
 
+#if !defined __VMOD_COMPILING_SYMBOL_TOOL && !defined GSDK_NO_SYMBOLS
+	void symbol_cache::report_timings(const std::filesystem::path &path) const noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		if(CommandLine()->FindParm("-vmod_syms_timings") == 0) {
+			return;
+		}
+
+		auto ms{
+			[](timings_t::duration dur) noexcept -> double
+			{ return std::chrono::duration<double, std::milli>{dur}.count(); }
+		};
+
+		if(timings_.from_index) {
+			info("vmod: '%s' symbols loaded from index in %.3fms\n"sv, path.c_str(), ms(timings_.index));
+		} else {
+			info("vmod: '%s' %zu symbols on %zu threads: collect %.3fms, demangle %.3fms, merge %.3fms, vtables %.3fms\n"sv,
+				path.c_str(),
+				timings_.symbols,
+				timings_.threads,
+				ms(timings_.symbols_collect),
+				ms(timings_.symbols_demangle),
+				ms(timings_.symbols_merge),
+				ms(timings_.vtables)
+			);
+		}
+	}
+#endif
+
 	symbol_cache::qualification_info::name_info &symbol_cache::qualification_info::name_info::operator=(name_info &&other) noexcept
 	{
 	#ifndef __VMOD_COMPILING_SYMBOL_TOOL
@@ -248,67 +627,764 @@ namespace vmod
 	}
 
 	void symbol_cache::resolve_vtables(unsigned char *base, bool elf) noexcept
+	{
+		if(offset_map.empty()) {
+			return;
+		}
+
+		for(auto &it : qualifications) {
+			class_info *info{dynamic_cast<class_info *>(it.second.get())};
+			if(!info || !info->vtable_.entries_.empty()) {
+				continue;
+			}
+
+			resolve_vtable(*info, base, elf);
+		}
+
+		offset_map.clear();
+	}
+
+	void symbol_cache::resolve_vtable(class_info &info, unsigned char *base, bool elf) noexcept
+	{
+		std::size_t vtable_size{info.vtable_.size_};
+		if(vtable_size == 0) {
+			return;
+		}
+
+		info.vtable_.entries_.resize(vtable_size, ventry_t{});
+
+		generic_vtable_t vtable{vtable_from_prefix(info.vtable_.prefix)};
+		for(std::size_t i{0}; i < vtable_size; ++i) {
+			generic_plain_mfp_t func{vtable[i]};
+			if(func) {
+				std::uint64_t off{elf ? (reinterpret_cast<std::uint64_t>(func) - reinterpret_cast<std::uint64_t>(base)) : reinterpret_cast<std::uint64_t>(func)};
+				if(!lazy_syms.empty()) {
+					materialize_lazy_value(off);
+				}
+				auto map_it{offset_map.find(off)};
+				if(map_it != offset_map.end() && !map_it->second.empty()) {
+					for(auto &fnc : map_it->second) {
+						if(fnc.type_ == info_t::type::qualified) {
+							fnc.qualified.second->second->vindex = i;
+						}
+					}
+
+					info.vtable_.entries_[i] = map_it->second;
+					continue;
+				}
+			}
+
+			if(!func || func == reinterpret_cast<generic_plain_mfp_t>(::__cxxabiv1::__cxa_pure_virtual)) {
+				if(pure_virt_it != global_qual.names.end()) {
+					info.vtable_.entries_[i] = pure_virt_it;
+				}
+			} else if(func == reinterpret_cast<generic_plain_mfp_t>(::__cxxabiv1::__cxa_deleted_virtual)) {
+				if(delt_virt_it != global_qual.names.end()) {
+					info.vtable_.entries_[i] = delt_virt_it;
+				}
+			#pragma GCC diagnostic push
+			#pragma GCC diagnostic ignored "-Wconditionally-supported"
+			} else if(reinterpret_cast<__cxxabiv1::__class_type_info *>(vtable[i+1]) == info.vtable_.prefix->whole_type) {
+				info.vtable_.entries_[i] = static_cast<std::uintptr_t>(-reinterpret_cast<std::intptr_t>(vtable[i]));
+				++i;
+				info.vtable_.entries_[i] = reinterpret_cast<__cxxabiv1::__class_type_info *>(vtable[i+1]);
+				continue;
+			}
+			#pragma GCC diagnostic pop
+		}
+	}
+
+	namespace detail
+	{
+		//only plain identifiers separated by :: can be turned back into a mangled prefix
+		static bool mangle_qualification(std::string_view name, std::string &enc, bool &nested) noexcept
+		{
+			using namespace std::literals::string_view_literals;
+
+			if(name.empty() || name.starts_with("std::"sv)) {
+				return false;
+			}
+
+			nested = false;
+
+			while(true) {
+				std::size_t sep{name.find("::"sv)};
+				std::string_view part{name.substr(0, sep)};
+				if(part.empty()) {
+					return false;
+				}
+
+				for(char c : part) {
+					if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')) {
+						return false;
+					}
+				}
+
+				if(part[0] >= '0' && part[0] <= '9') {
+					return false;
+				}
+
+				enc += std::to_string(part.size());
+				enc += part;
+
+				if(sep == std::string_view::npos) {
+					break;
+				}
+
+				nested = true;
+				name.remove_prefix(sep + 2);
+			}
+
+			return true;
+		}
+	}
+
+	void symbol_cache::sort_lazy_symbols() noexcept
+	{
+		std::sort(lazy_syms.begin(), lazy_syms.end(),
+			[this](const lazy_sym_t &lhs, const lazy_sym_t &rhs) noexcept -> bool
+			{ return lazy_name(lhs) < lazy_name(rhs); }
+		);
+
+		lazy_by_value.resize(lazy_syms.size());
+		for(std::size_t i{0}; i < lazy_syms.size(); ++i) {
+			lazy_by_value[i] = i;
+		}
+
+		std::sort(lazy_by_value.begin(), lazy_by_value.end(),
+			[this](std::size_t lhs, std::size_t rhs) noexcept -> bool
+			{ return lazy_syms[lhs].sym.off < lazy_syms[rhs].sym.off; }
+		);
+	}
+
+	void symbol_cache::materialize_lazy_sym(lazy_sym_t &lazy) noexcept
+	{
+		if(lazy.done) {
+			return;
+		}
+
+		lazy.done = true;
+
+		handle_symbol(lazy_name(lazy), basic_sym_t{lazy.sym}, lazy_base);
+	}
+
+	void symbol_cache::materialize_lazy_value(std::uint64_t off) noexcept
+	{
+		auto it{std::lower_bound(lazy_by_value.begin(), lazy_by_value.end(), off,
+			[this](std::size_t i, std::uint64_t value) noexcept -> bool
+			{ return lazy_syms[i].sym.off < value; }
+		)};
+
+		for(; it != lazy_by_value.end() && lazy_syms[*it].sym.off == off; ++it) {
+			materialize_lazy_sym(lazy_syms[*it]);
+		}
+	}
+
+	void symbol_cache::materialize_qualification(std::string_view name) noexcept
 	{
 		using namespace std::literals::string_view_literals;
 
-		if(offset_map.empty()) {
+		if(!lazy_quals.emplace(name).second) {
+			return;
+		}
+
+		std::string enc;
+		bool nested;
+		if(!detail::mangle_qualification(name, enc, nested)) {
+			materialize_all();
+			return;
+		}
+
+		scope_arena sarena{arena_};
+
+		auto materialize_prefix{
+			[this](std::string_view prefix, bool exact) noexcept -> void {
+				auto it{std::lower_bound(lazy_syms.begin(), lazy_syms.end(), prefix,
+					[this](const lazy_sym_t &lazy, std::string_view value) noexcept -> bool
+					{ return lazy_name(lazy) < value; }
+				)};
+
+				for(; it != lazy_syms.end(); ++it) {
+					std::string_view lazy_name_{lazy_name(*it)};
+					if(exact ? (lazy_name_ != prefix) : !lazy_name_.starts_with(prefix)) {
+						break;
+					}
+
+					materialize_lazy_sym(*it);
+				}
+			}
+		};
+
+		//<nested-name> ::= N [<CV-qualifiers>] [<ref-qualifier>] <prefix> <unqualified-name> E
+		static constexpr std::string_view qualifiers[]{
+			""sv, "K"sv, "V"sv, "VK"sv,
+			"R"sv, "O"sv, "KR"sv, "KO"sv,
+			"VR"sv, "VO"sv, "VKR"sv, "VKO"sv
+		};
+
+		std::string prefix;
+		for(std::string_view qualifier : qualifiers) {
+			prefix = "_ZN"sv;
+			prefix += qualifier;
+			prefix += enc;
+			materialize_prefix(prefix, false);
+		}
+
+		prefix = "_ZTV"sv;
+		if(nested) {
+			prefix += 'N';
+			prefix += enc;
+			prefix += 'E';
+		} else {
+			prefix += enc;
+		}
+		materialize_prefix(prefix, true);
+
+		auto qual_it{qualifications.find(name)};
+		if(qual_it != qualifications.end()) {
+			class_info *info{dynamic_cast<class_info *>(qual_it->second.get())};
+			if(info && info->vtable_.entries_.empty()) {
+				resolve_vtable(*info, lazy_base, true);
+			}
+		}
+	}
+
+	void symbol_cache::materialize_all() noexcept
+	{
+		scope_arena sarena{arena_};
+
+		for(lazy_sym_t &lazy : lazy_syms) {
+			materialize_lazy_sym(lazy);
+		}
+
+		lazy_syms.clear();
+		lazy_syms.shrink_to_fit();
+		lazy_by_value.clear();
+		lazy_by_value.shrink_to_fit();
+		lazy_strings.clear();
+		lazy_strings.shrink_to_fit();
+		lazy_quals.clear();
+
+		resolve_vtables(lazy_base, true);
+	}
+
+#ifndef __VMOD_COMPILING_SYMBOL_TOOL
+	bool symbol_cache::read_index(const std::filesystem::path &path, std::uint64_t hash, unsigned char *base) noexcept
+	{
+		using namespace std::literals::string_literals;
+
+		int fd{open(path.c_str(), O_RDONLY)};
+		if(fd < 0) {
+			return false;
+		}
+
+		struct stat stat;
+		if(fstat(fd, &stat) != 0 || static_cast<std::size_t>(stat.st_size) < sizeof(detail::index_header_t)) {
+			close(fd);
+			return false;
+		}
+
+		std::size_t size{static_cast<std::size_t>(stat.st_size)};
+
+		void *data{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+		close(fd);
+		if(data == MAP_FAILED) {
+			return false;
+		}
+
+		struct scope_unmap final {
+			inline scope_unmap(void *data_, std::size_t size_) noexcept
+				: data{data_}, size{size_} {}
+			inline ~scope_unmap() noexcept
+			{ munmap(data, size); }
+		private:
+			void *data;
+			std::size_t size;
+		};
+
+		scope_unmap sum{data, size};
+
+		const unsigned char *begin{static_cast<const unsigned char *>(data)};
+
+	#ifndef __clang__
+		#pragma GCC diagnostic push
+		#pragma GCC diagnostic ignored "-Wcast-align"
+	#endif
+		const detail::index_header_t *header{reinterpret_cast<const detail::index_header_t *>(begin)};
+
+		if(std::memcmp(header->magic, detail::index_magic.data(), sizeof(detail::index_header_t::magic)) != 0 ||
+			header->version != detail::index_version ||
+			header->ptr_size != sizeof(void *) ||
+			header->hash != hash) {
+			return false;
+		}
+
+		std::size_t remaining{size - sizeof(detail::index_header_t)};
+
+		auto take{
+			[&remaining](std::uint64_t count, std::size_t elem_size) noexcept -> bool {
+				if(count > (remaining / elem_size)) {
+					return false;
+				}
+				remaining -= static_cast<std::size_t>(count) * elem_size;
+				return true;
+			}
+		};
+
+		if(header->num_quals == 0 ||
+			!take(header->num_quals, sizeof(detail::index_qual_t)) ||
+			!take(header->num_names, sizeof(detail::index_name_t)) ||
+			!take(header->num_locals, sizeof(detail::index_name_t)) ||
+			!take(header->num_ventries, sizeof(detail::index_ventry_t)) ||
+			!take(header->num_refs, sizeof(detail::index_ref_t)) ||
+			remaining != header->strings_size) {
+			return false;
+		}
+
+		const detail::index_qual_t *quals{reinterpret_cast<const detail::index_qual_t *>(begin + sizeof(detail::index_header_t))};
+		const detail::index_name_t *names{reinterpret_cast<const detail::index_name_t *>(quals + header->num_quals)};
+		const detail::index_name_t *locals{names + header->num_names};
+		const detail::index_ventry_t *ventries{reinterpret_cast<const detail::index_ventry_t *>(locals + header->num_locals)};
+		const detail::index_ref_t *refs{reinterpret_cast<const detail::index_ref_t *>(ventries + header->num_ventries)};
+		const char *strings{reinterpret_cast<const char *>(refs + header->num_refs)};
+	#ifndef __clang__
+		#pragma GCC diagnostic pop
+	#endif
+
+		auto valid_range{
+			[](std::uint64_t first, std::uint64_t count, std::uint64_t max) noexcept -> bool
+			{ return (first <= max && count <= (max - first)); }
+		};
+
+		auto valid_name{
+			[header,&valid_range](const detail::index_name_t &entry, std::uint64_t max_locals) noexcept -> bool {
+				return (
+					valid_range(entry.str_off, entry.str_len, header->strings_size) &&
+					valid_range(entry.first_local, entry.num_locals, max_locals) &&
+					entry.kind <= detail::index_name_kind::dtor
+				);
+			}
+		};
+
+		for(std::uint64_t i{0}; i < header->num_locals; ++i) {
+			if(!valid_name(locals[i], 0)) {
+				return false;
+			}
+		}
+
+		for(std::uint64_t i{0}; i < header->num_names; ++i) {
+			if(!valid_name(names[i], header->num_locals)) {
+				return false;
+			}
+		}
+
+		for(std::uint64_t i{0}; i < header->num_quals; ++i) {
+			const detail::index_qual_t &entry{quals[i]};
+
+			if(!valid_range(entry.str_off, entry.str_len, header->strings_size) ||
+				!valid_range(entry.first_name, entry.num_names, header->num_names) ||
+				!valid_range(entry.first_ventry, entry.num_ventries, header->num_ventries)) {
+				return false;
+			}
+
+			if(i == 0 && entry.num_ventries > 0) {
+				return false;
+			}
+
+			for(std::uint64_t j{0}; j < entry.num_ventries; ++j) {
+				const detail::index_ventry_t &ventry{ventries[entry.first_ventry + j]};
+				if(ventry.type > static_cast<std::uint64_t>(ventry_t::type::invalid)) {
+					return false;
+				}
+
+				switch(static_cast<ventry_t::type>(ventry.type)) {
+					case ventry_t::type::info: {
+						if(!valid_range(ventry.first_ref, ventry.num_refs, header->num_refs)) {
+							return false;
+						}
+
+						for(std::uint64_t k{0}; k < ventry.num_refs; ++k) {
+							const detail::index_ref_t &ref{refs[ventry.first_ref + k]};
+							if(ref.qual >= header->num_quals) {
+								return false;
+							}
+
+							const detail::index_qual_t &ref_qual{quals[ref.qual]};
+							if(ref.name < ref_qual.first_name || (ref.name - ref_qual.first_name) >= ref_qual.num_names) {
+								return false;
+							}
+						}
+					} break;
+					case ventry_t::type::type_info: {
+						if(!(entry.flags & detail::index_qual_vtable) || (j+1) >= entry.vtable_size) {
+							return false;
+						}
+					} break;
+					case ventry_t::type::offset:
+					case ventry_t::type::invalid:
+					break;
+					default:
+					return false;
+				}
+			}
+		}
+
+		auto make_name{
+			[base,strings](const detail::index_name_t &entry) noexcept -> std::unique_ptr<qualification_info::name_info> {
+				std::unique_ptr<qualification_info::name_info> info;
+
+				switch(entry.kind) {
+					case detail::index_name_kind::ctor: {
+						class_info::ctor_info *ctor_info{new class_info::ctor_info};
+						ctor_info->kind = static_cast<gnu_v3_ctor_kinds>(entry.sub_kind);
+						info.reset(ctor_info);
+					} break;
+					case detail::index_name_kind::dtor: {
+						class_info::dtor_info *dtor_info{new class_info::dtor_info};
+						dtor_info->kind = static_cast<gnu_v3_dtor_kinds>(entry.sub_kind);
+						info.reset(dtor_info);
+					} break;
+					default: {
+						info.reset(new qualification_info::name_info);
+					} break;
+				}
+
+				info->set_offset(entry.offset);
+				info->size_ = entry.size;
+				info->vindex = static_cast<std::size_t>(entry.vindex);
+				info->resolve_from_base(base);
+
+				return info;
+			}
+		};
+
+		std::vector<qualifications_t::iterator> qual_its;
+		qual_its.reserve(static_cast<std::size_t>(header->num_quals));
+
+		std::vector<qualification_info::names_t::iterator> name_its;
+		name_its.resize(static_cast<std::size_t>(header->num_names));
+
+		qualifications.reserve(static_cast<std::size_t>(header->num_quals - 1));
+
+		for(std::uint64_t i{0}; i < header->num_quals; ++i) {
+			const detail::index_qual_t &entry{quals[i]};
+
+			qualification_info *qual_info{&global_qual};
+
+			if(i == 0) {
+				qual_its.emplace_back(qualifications.end());
+			} else {
+				auto qual_it{qualifications.emplace(std::string{strings + entry.str_off, static_cast<std::size_t>(entry.str_len)}, new class_info{}).first};
+				qual_its.emplace_back(qual_it);
+
+				class_info *info{static_cast<class_info *>(qual_it->second.get())};
+
+				info->vtable_.size_ = static_cast<std::size_t>(entry.vtable_size);
+				if(entry.flags & detail::index_qual_vtable) {
+					info->vtable_.offset = entry.vtable_offset;
+					info->vtable_.resolve_from_base(base);
+				}
+
+				if(entry.flags & detail::index_qual_vtable_size) {
+					vtable_sizes.emplace(qual_it->first, static_cast<std::size_t>(entry.known_vtable_size));
+				}
+
+				qual_info = info;
+			}
+
+			qual_info->names.reserve(static_cast<std::size_t>(entry.num_names));
+
+			for(std::uint64_t j{entry.first_name}; j < (entry.first_name + entry.num_names); ++j) {
+				const detail::index_name_t &name_entry{names[j]};
+
+				auto name_it{qual_info->names.emplace(std::string{strings + name_entry.str_off, static_cast<std::size_t>(name_entry.str_len)}, make_name(name_entry)).first};
+				name_its[static_cast<std::size_t>(j)] = name_it;
+
+				if(name_entry.num_locals > 0) {
+					name_it->second->names.reserve(static_cast<std::size_t>(name_entry.num_locals));
+
+					for(std::uint64_t k{name_entry.first_local}; k < (name_entry.first_local + name_entry.num_locals); ++k) {
+						const detail::index_name_t &local_entry{locals[k]};
+						name_it->second->names.emplace(std::string{strings + local_entry.str_off, static_cast<std::size_t>(local_entry.str_len)}, make_name(local_entry));
+					}
+				}
+			}
+		}
+
+		for(std::uint64_t i{1}; i < header->num_quals; ++i) {
+			const detail::index_qual_t &entry{quals[i]};
+			if(entry.num_ventries == 0) {
+				continue;
+			}
+
+			class_info *info{static_cast<class_info *>(qual_its[static_cast<std::size_t>(i)]->second.get())};
+
+			info->vtable_.entries_.resize(static_cast<std::size_t>(entry.num_ventries), ventry_t{});
+
+			for(std::uint64_t j{0}; j < entry.num_ventries; ++j) {
+				const detail::index_ventry_t &ventry{ventries[entry.first_ventry + j]};
+				ventry_t &dst{info->vtable_.entries_[static_cast<std::size_t>(j)]};
+
+				switch(static_cast<ventry_t::type>(ventry.type)) {
+					case ventry_t::type::info: {
+						std::vector<info_t> refvec;
+						refvec.reserve(static_cast<std::size_t>(ventry.num_refs));
+
+						for(std::uint64_t k{ventry.first_ref}; k < (ventry.first_ref + ventry.num_refs); ++k) {
+							const detail::index_ref_t &ref{refs[k]};
+							auto name_it{name_its[static_cast<std::size_t>(ref.name)]};
+							if(ref.qual == 0) {
+								refvec.emplace_back(info_t{name_it});
+							} else {
+								refvec.emplace_back(info_t{qual_its[static_cast<std::size_t>(ref.qual)], name_it});
+							}
+						}
+
+						dst = std::move(refvec);
+					} break;
+					case ventry_t::type::offset: {
+						dst = static_cast<std::uintptr_t>(ventry.value);
+					} break;
+					case ventry_t::type::type_info: {
+						generic_vtable_t vtable{vtable_from_prefix(info->vtable_.prefix)};
+					#ifndef __clang__
+						#pragma GCC diagnostic push
+						#pragma GCC diagnostic ignored "-Wconditionally-supported"
+					#endif
+						dst = reinterpret_cast<__cxxabiv1::__class_type_info *>(vtable[j+1]);
+					#ifndef __clang__
+						#pragma GCC diagnostic pop
+					#endif
+					} break;
+					default: break;
+				}
+			}
+		}
+
+		pure_virt_it = global_qual.names.find("__cxa_pure_virtual"s);
+		delt_virt_it = global_qual.names.find("__cxa_deleted_virtual"s);
+
+		return true;
+	}
+
+	void symbol_cache::write_index(const std::filesystem::path &path, std::uint64_t hash) const noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		std::vector<detail::index_qual_t> quals;
+		std::vector<detail::index_name_t> names;
+		std::vector<detail::index_name_t> locals;
+		std::vector<detail::index_ventry_t> ventries;
+		std::vector<detail::index_ref_t> refs;
+		std::string strings;
+
+		std::unordered_map<const qualification_info *, std::uint64_t> qual_indices;
+		std::unordered_map<const qualification_info::name_info *, std::uint64_t> name_indices;
+
+		auto fill_name{
+			[&strings](detail::index_name_t &entry, std::string_view name, const qualification_info::name_info &info) noexcept -> bool {
+				if(info.type_ != qualification_info::name_info::type::offset) {
+					return false;
+				}
+
+				entry.str_off = strings.size();
+				entry.str_len = name.size();
+				strings += name;
+
+				entry.offset = info.offset_;
+				entry.size = info.size_;
+				entry.vindex = static_cast<std::uint64_t>(info.vindex);
+
+				if(const class_info::ctor_info *ctor_info{dynamic_cast<const class_info::ctor_info *>(&info)}; ctor_info) {
+					entry.kind = detail::index_name_kind::ctor;
+					entry.sub_kind = static_cast<std::uint32_t>(ctor_info->kind);
+				} else if(const class_info::dtor_info *dtor_info{dynamic_cast<const class_info::dtor_info *>(&info)}; dtor_info) {
+					entry.kind = detail::index_name_kind::dtor;
+					entry.sub_kind = static_cast<std::uint32_t>(dtor_info->kind);
+				} else {
+					entry.kind = detail::index_name_kind::plain;
+				}
+
+				return true;
+			}
+		};
+
+		auto add_qual{
+			[this,&quals,&names,&locals,&strings,&qual_indices,&name_indices,&fill_name](std::string_view qual_name, const qualification_info &qual) noexcept -> bool {
+				detail::index_qual_t entry{};
+				entry.str_off = strings.size();
+				entry.str_len = qual_name.size();
+				strings += qual_name;
+
+				entry.first_name = names.size();
+				entry.num_names = qual.names.size();
+
+				for(const auto &it : qual.names) {
+					detail::index_name_t name_entry{};
+					if(!fill_name(name_entry, it.first, *it.second)) {
+						return false;
+					}
+
+					name_entry.first_local = locals.size();
+					name_entry.num_locals = it.second->names.size();
+
+					for(const auto &local : it.second->names) {
+						detail::index_name_t local_entry{};
+						if(!fill_name(local_entry, local.first, *local.second)) {
+							return false;
+						}
+
+						locals.emplace_back(local_entry);
+					}
+
+					name_indices.emplace(it.second.get(), names.size());
+					names.emplace_back(name_entry);
+				}
+
+				if(const class_info *info{dynamic_cast<const class_info *>(&qual)}; info) {
+					entry.vtable_size = info->vtable_.size_;
+					if(info->vtable_.prefix) {
+						entry.vtable_offset = info->vtable_.offset;
+						entry.flags |= detail::index_qual_vtable;
+					}
+
+					auto size_it{vtable_sizes.find(std::string{qual_name})};
+					if(size_it != vtable_sizes.end()) {
+						entry.known_vtable_size = size_it->second;
+						entry.flags |= detail::index_qual_vtable_size;
+					}
+				}
+
+				qual_indices.emplace(&qual, quals.size());
+				quals.emplace_back(entry);
+
+				return true;
+			}
+		};
+
+		if(!add_qual({}, global_qual)) {
 			return;
 		}
 
-		for(auto &it : qualifications) {
-			class_info *info{dynamic_cast<class_info *>(it.second.get())};
+		for(const auto &it : qualifications) {
+			if(!add_qual(it.first, *it.second)) {
+				return;
+			}
+		}
+
+		std::size_t qual_idx{1};
+		for(const auto &it : qualifications) {
+			detail::index_qual_t &entry{quals[qual_idx++]};
+
+			const class_info *info{dynamic_cast<const class_info *>(it.second.get())};
 			if(!info) {
 				continue;
 			}
 
-			std::size_t vtable_size{info->vtable_.size_};
-			if(vtable_size == 0) {
-				continue;
-			}
+			entry.first_ventry = ventries.size();
+			entry.num_ventries = info->vtable_.entries_.size();
+
+			for(const ventry_t &ventry : info->vtable_.entries_) {
+				detail::index_ventry_t ventry_entry{};
+				ventry_entry.type = static_cast<std::uint64_t>(ventry.type_);
+
+				switch(ventry.type_) {
+					case ventry_t::type::info: {
+						ventry_entry.first_ref = refs.size();
+						ventry_entry.num_refs = ventry.info.size();
 
-			info->vtable_.entries_.resize(vtable_size, ventry_t{});
+						for(const info_t &ref : ventry.info) {
+							detail::index_ref_t ref_entry{};
 
-			generic_vtable_t vtable{vtable_from_prefix(info->vtable_.prefix)};
-			for(std::size_t i{0}; i < vtable_size; ++i) {
-				generic_plain_mfp_t func{vtable[i]};
-				if(func) {
-					std::uint64_t off{elf ? (reinterpret_cast<std::uint64_t>(func) - reinterpret_cast<std::uint64_t>(base)) : reinterpret_cast<std::uint64_t>(func)};
-					auto map_it{offset_map.find(off)};
-					if(map_it != offset_map.end() && !map_it->second.empty()) {
-						for(auto &fnc : map_it->second) {
-							if(fnc.type_ == info_t::type::qualified) {
-								fnc.qualified.second->second->vindex = i;
+							const qualification_info::name_info *name{nullptr};
+							if(ref.type_ == info_t::type::qualified) {
+								auto qual_it{qual_indices.find(ref.qualified.first->second.get())};
+								if(qual_it == qual_indices.end()) {
+									return;
+								}
+								ref_entry.qual = qual_it->second;
+								name = ref.qualified.second->second.get();
+							} else {
+								ref_entry.qual = 0;
+								name = ref.global->second.get();
 							}
-						}
 
-						info->vtable_.entries_[i] = map_it->second;
-						continue;
-					}
-				}
+							auto name_it{name_indices.find(name)};
+							if(name_it == name_indices.end()) {
+								return;
+							}
+							ref_entry.name = name_it->second;
 
-				if(!func || func == reinterpret_cast<generic_plain_mfp_t>(::__cxxabiv1::__cxa_pure_virtual)) {
-					if(pure_virt_it != global_qual.names.end()) {
-						info->vtable_.entries_[i] = pure_virt_it;
-					}
-				} else if(func == reinterpret_cast<generic_plain_mfp_t>(::__cxxabiv1::__cxa_deleted_virtual)) {
-					if(delt_virt_it != global_qual.names.end()) {
-						info->vtable_.entries_[i] = delt_virt_it;
-					}
-				#pragma GCC diagnostic push
-				#pragma GCC diagnostic ignored "-Wconditionally-supported"
-				} else if(reinterpret_cast<__cxxabiv1::__class_type_info *>(vtable[i+1]) == info->vtable_.prefix->whole_type) {
-					info->vtable_.entries_[i] = static_cast<std::uintptr_t>(-reinterpret_cast<std::intptr_t>(vtable[i]));
-					++i;
-					info->vtable_.entries_[i] = reinterpret_cast<__cxxabiv1::__class_type_info *>(vtable[i+1]);
-					continue;
+							refs.emplace_back(ref_entry);
+						}
+					} break;
+					case ventry_t::type::offset: {
+						ventry_entry.value = static_cast<std::uint64_t>(ventry.off);
+					} break;
+					default: break;
 				}
-				#pragma GCC diagnostic pop
+
+				ventries.emplace_back(ventry_entry);
 			}
 		}
 
-		offset_map.clear();
+		detail::index_header_t header{};
+		std::memcpy(header.magic, detail::index_magic.data(), sizeof(detail::index_header_t::magic));
+		header.version = detail::index_version;
+		header.ptr_size = sizeof(void *);
+		header.hash = hash;
+		header.num_quals = quals.size();
+		header.num_names = names.size();
+		header.num_locals = locals.size();
+		header.num_ventries = ventries.size();
+		header.num_refs = refs.size();
+		header.strings_size = strings.size();
+
+		std::size_t size{
+			sizeof(detail::index_header_t) +
+			(quals.size() * sizeof(detail::index_qual_t)) +
+			(names.size() * sizeof(detail::index_name_t)) +
+			(locals.size() * sizeof(detail::index_name_t)) +
+			(ventries.size() * sizeof(detail::index_ventry_t)) +
+			(refs.size() * sizeof(detail::index_ref_t)) +
+			strings.size()
+		};
+
+		std::unique_ptr<unsigned char[]> data{new unsigned char[size]};
+		unsigned char *it{data.get()};
+
+		auto append{
+			[&it](const void *src, std::size_t len) noexcept -> void {
+				if(len > 0) {
+					std::memcpy(it, src, len);
+					it += len;
+				}
+			}
+		};
+
+		append(&header, sizeof(detail::index_header_t));
+		append(quals.data(), quals.size() * sizeof(detail::index_qual_t));
+		append(names.data(), names.size() * sizeof(detail::index_name_t));
+		append(locals.data(), locals.size() * sizeof(detail::index_name_t));
+		append(ventries.data(), ventries.size() * sizeof(detail::index_ventry_t));
+		append(refs.data(), refs.size() * sizeof(detail::index_ref_t));
+		append(strings.data(), strings.size());
+
+		std::error_code ec;
+		std::filesystem::create_directories(path.parent_path(), ec);
+
+		std::filesystem::path temp_path{path};
+		temp_path += ".tmp"sv;
+
+		write_file(temp_path, data.get(), size);
+
+		std::filesystem::rename(temp_path, path, ec);
+		if(ec) {
+			std::filesystem::remove(temp_path, ec);
+		}
 	}
 #endif
+#endif
 
 #ifdef __VMOD_COMPILING_VTABLE_DUMPER
 	bool symbol_cache::read_macho(llvm::object::MachOObjectFile &obj, unsigned char *base) noexcept
@@ -403,6 +1479,8 @@ namespace vmod
 			return false;
 		}
 
+		module_hashed = detail::hash_file(fd, module_hash);
+
 		close(fd);
 		return true;
 	}
@@ -428,7 +1506,7 @@ namespace vmod
 		std::size_t num_phdrs{0};
 		elf_getphdrnum(elf, &num_phdrs);
 
-		std::size_t pagesize{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+		exec_segments.clear();
 
 		GElf_Phdr phdr;
 
@@ -441,12 +1519,11 @@ namespace vmod
 				continue;
 			}
 
-			if(phdr.p_flags != (PF_X|PF_R)) {
+			if(!(phdr.p_flags & PF_X) || phdr.p_filesz == 0) {
 				continue;
 			}
 
-			memory_size = align_up(phdr.p_filesz, pagesize);
-			break;
+			exec_segments.emplace_back(segment_t{phdr.p_vaddr, phdr.p_filesz});
 		}
 
 		GElf_Shdr scn_hdr;
@@ -498,6 +1575,112 @@ namespace vmod
 #endif
 
 #ifndef GSDK_NO_SYMBOLS
+	void symbol_cache::handle_symbol(std::string_view name_mangled, basic_sym_t &&sym, unsigned char *base) noexcept
+	{
+		struct scope_free final {
+			inline scope_free(void *mem_) noexcept
+				: mem{mem_} {}
+			inline ~scope_free() noexcept {
+				if(mem) {
+					std::free(mem);
+				}
+			}
+		private:
+			void *mem;
+		};
+
+		void *component_mem{nullptr};
+		demangle_component *component{cplus_demangle_v3_components(name_mangled.data(), demangle_flags, &component_mem)};
+		scope_free sfcm{component_mem};
+
+		qualifications_t::iterator tmp_qual_it;
+		qualification_info::names_t::iterator tmp_name_it;
+		handle_component(name_mangled, nullptr, component, tmp_qual_it, tmp_name_it, std::move(sym), base, true);
+	}
+
+	void symbol_cache::merge_shard(symbol_cache &shard) noexcept
+	{
+		auto take_name{
+			[]([[maybe_unused]] qualification_info::name_info &dst, [[maybe_unused]] qualification_info::name_info &src) noexcept -> void {
+			#ifndef __VMOD_COMPILING_SYMBOL_TOOL
+				dst.names.merge(src.names);
+			#endif
+			}
+		};
+
+		arena_.adopt(shard.arena_);
+
+		qualifications.merge(shard.qualifications);
+
+		for(auto &it : shard.qualifications) {
+			auto qual_it{qualifications.find(it.first)};
+
+			class_info *dst_info{dynamic_cast<class_info *>(qual_it->second.get())};
+			class_info *src_info{dynamic_cast<class_info *>(it.second.get())};
+			if(dst_info && src_info && src_info->vtable_.offset != 0) {
+				dst_info->vtable_.offset = src_info->vtable_.offset;
+				dst_info->vtable_.size_ = src_info->vtable_.size_;
+				dst_info->vtable_.prefix = src_info->vtable_.prefix;
+			}
+
+			auto &dst_names{qual_it->second->names};
+			auto &src_names{it.second->names};
+
+			dst_names.merge(src_names);
+
+			for(auto &name : src_names) {
+				auto name_it{dst_names.find(name.first)};
+				std::swap(name_it->second, name.second);
+				take_name(*name_it->second, *name.second);
+			}
+		}
+
+		global_qual.names.merge(shard.global_qual.names);
+
+		for(auto &name : shard.global_qual.names) {
+			auto name_it{global_qual.names.find(name.first)};
+			take_name(*name_it->second, *name.second);
+		}
+
+		vtable_sizes.merge(shard.vtable_sizes);
+
+		for(auto &it : shard.offset_map) {
+			for(info_t &info : it.second) {
+				if(info.type_ == info_t::type::qualified) {
+					auto qual_it{info.qualified.first};
+					auto shard_qual_it{shard.qualifications.find(qual_it->first)};
+					if(shard_qual_it != shard.qualifications.end() && &*shard_qual_it == &*qual_it) {
+						auto name_it{info.qualified.second};
+						auto dst_qual_it{qualifications.find(qual_it->first)};
+
+						auto shard_name_it{qual_it->second->names.find(name_it->first)};
+						if(shard_name_it != qual_it->second->names.end() && &*shard_name_it == &*name_it) {
+							name_it = dst_qual_it->second->names.find(name_it->first);
+						}
+
+						info.qualified.first = dst_qual_it;
+						info.qualified.second = name_it;
+					}
+				} else {
+					auto name_it{info.global};
+					auto shard_name_it{shard.global_qual.names.find(name_it->first)};
+					if(shard_name_it != shard.global_qual.names.end() && &*shard_name_it == &*name_it) {
+						info.global = global_qual.names.find(name_it->first);
+					}
+				}
+			}
+
+			auto map_it{offset_map.find(it.first)};
+			if(map_it == offset_map.end()) {
+				offset_map.emplace(it.first, std::move(it.second));
+			} else {
+				map_it->second.insert(map_it->second.end(), it.second.begin(), it.second.end());
+			}
+		}
+
+		shard.offset_map.clear();
+	}
+
 	bool symbol_cache::read_elf_symbols(int fd, unsigned char *base) noexcept
 	{
 		using namespace std::literals::string_literals;
@@ -516,6 +1699,16 @@ namespace vmod
 			return false;
 		}
 
+		struct pending_sym_t final
+		{
+			std::string_view name_mangled;
+			basic_sym_t sym;
+		};
+
+		std::vector<pending_sym_t> pending;
+
+		auto collect_begin{std::chrono::steady_clock::now()};
+
 		GElf_Shdr scn_hdr;
 		GElf_Sym sym;
 
@@ -545,6 +1738,8 @@ namespace vmod
 			Elf_Data *scn_data{elf_getdata(scn, nullptr)};
 
 			std::size_t count{static_cast<std::size_t>(scn_hdr.sh_size) / static_cast<std::size_t>(scn_hdr.sh_entsize)};
+			pending.reserve(count);
+
 			for(std::size_t i{0}; i < count; ++i) {
 				gelf_getsym(scn_data, static_cast<int>(i), &sym);
 
@@ -601,28 +1796,82 @@ namespace vmod
 					continue;
 				}
 
-				struct scope_free final {
-					inline scope_free(void *mem_) noexcept
-						: mem{mem_} {}
-					inline ~scope_free() noexcept {
-						if(mem) {
-							std::free(mem);
+				if(lazy_symbols && (name_mangled.starts_with("_ZN"sv) || name_mangled.starts_with("_ZT"sv))) {
+					lazy_syms.emplace_back(lazy_sym_t{lazy_strings.size(), name_mangled.size(), basic_sym, false});
+					lazy_strings += name_mangled;
+					lazy_strings += '\0';
+					continue;
+				}
+
+				pending.emplace_back(pending_sym_t{name_mangled, basic_sym});
+			}
+
+			break;
+		}
+
+		if(!lazy_syms.empty()) {
+			lazy_base = base;
+			sort_lazy_symbols();
+		}
+
+		auto demangle_begin{std::chrono::steady_clock::now()};
+		timings_.symbols_collect = (demangle_begin - collect_begin);
+		timings_.symbols = pending.size();
+
+		constexpr std::size_t min_symbols_per_shard{4096};
+
+		std::size_t num_shards{std::thread::hardware_concurrency()};
+		num_shards = std::min(num_shards, (pending.size() / min_symbols_per_shard));
+		if(num_shards <= 1) {
+			timings_.threads = 1;
+
+			for(pending_sym_t &pend : pending) {
+				handle_symbol(pend.name_mangled, std::move(pend.sym), base);
+			}
+
+			timings_.symbols_demangle = (std::chrono::steady_clock::now() - demangle_begin);
+		} else {
+			timings_.threads = num_shards;
+
+			std::vector<std::unique_ptr<symbol_cache>> shards;
+			shards.reserve(num_shards);
+
+			std::vector<std::thread> workers;
+			workers.reserve(num_shards);
+
+			std::size_t shard_size{(pending.size() + (num_shards - 1)) / num_shards};
+
+			for(std::size_t i{0}; i < num_shards; ++i) {
+				std::size_t first{i * shard_size};
+				std::size_t last{std::min(first + shard_size, pending.size())};
+
+				symbol_cache *shard{new symbol_cache};
+				shards.emplace_back(shard);
+
+				workers.emplace_back(
+					[shard,&pending,first,last,base]() noexcept -> void {
+						current_arena = &shard->arena_;
+
+						for(std::size_t j{first}; j < last; ++j) {
+							pending_sym_t &pend{pending[j]};
+							shard->handle_symbol(pend.name_mangled, std::move(pend.sym), base);
 						}
 					}
-				private:
-					void *mem;
-				};
+				);
+			}
+
+			for(std::thread &worker : workers) {
+				worker.join();
+			}
 
-				void *component_mem{nullptr};
-				demangle_component *component{cplus_demangle_v3_components(name_mangled.data(), demangle_flags, &component_mem)};
-				scope_free sfcm{component_mem};
+			auto merge_begin{std::chrono::steady_clock::now()};
+			timings_.symbols_demangle = (merge_begin - demangle_begin);
 
-				qualifications_t::iterator tmp_qual_it;
-				qualification_info::names_t::iterator tmp_name_it;
-				handle_component(name_mangled, nullptr, component, tmp_qual_it, tmp_name_it, std::move(basic_sym), base, true);
+			for(auto &shard : shards) {
+				merge_shard(*shard);
 			}
 
-			break;
+			timings_.symbols_merge = (std::chrono::steady_clock::now() - merge_begin);
 		}
 
 		elf_end(elf);
@@ -632,487 +1881,569 @@ namespace vmod
 #endif
 
 #ifndef __VMOD_COMPILING_SYMBOL_TOOL
-	bool symbol_cache::read_yaml(const std::filesystem::path &path, unsigned char *base) noexcept
+	bool symbol_cache::read_yaml(const unsigned char *data, std::size_t size) noexcept
 	{
-		using namespace std::literals::string_view_literals;
-		using namespace std::literals::string_literals;
-
-		struct scope_delete_parser final {
-			inline scope_delete_parser(yaml_parser_t &parser_) noexcept
-				: parser{parser_} {}
-			inline ~scope_delete_parser() noexcept
-			{ yaml_parser_delete(&parser); }
-			yaml_parser_t &parser;
-		};
-
-		yaml_parser_t parser{};
-		if(yaml_parser_initialize(&parser) != 1) {
+		std::vector<signature_t> sigs;
+		if(!read_signature_yaml(data, size, sigs, err_str)) {
 			return false;
 		}
-		scope_delete_parser sdp{parser};
 
-		std::size_t size{0};
-		std::unique_ptr<unsigned char[]> yaml_data{read_file(path, size)};
-		if(size == 0) {
-			return false;
+		for(const signature_t &sig : sigs) {
+			emplace_pending_signature(sig.qual, sig.name, sig.bytes.data(), sig.mask.data(), sig.bytes.size(), sig.offset, sig.data);
 		}
 
-		yaml_parser_set_input_string(&parser, yaml_data.get(), size);
-
-		while(true) {
-			yaml_document_t temp_doc{};
-			if(yaml_parser_load(&parser, &temp_doc) != 1) {
-				return false;
-			}
+		return true;
+	}
 
-			yaml_node_t *root{yaml_document_get_root_node(&temp_doc)};
-			if(!root) {
-				break;
-			}
+	void symbol_cache::read_bundled(std::size_t i) noexcept
+	{
+		signature_bundle::file_view_t file{bundle.file(i)};
 
-			if(root->type != YAML_MAPPING_NODE ||
-				std::strcmp(reinterpret_cast<const char *>(root->tag), YAML_MAP_TAG) != 0) {
-				err_str = "root is not a map"s;
-				return false;
-			}
+		for(std::size_t j{0}; j < file.count; ++j) {
+			signature_bundle::entry_view_t entry{bundle.entry(file.first + j)};
+			emplace_pending_signature(entry.qual, entry.name, entry.bytes, entry.mask, entry.size, entry.offset, entry.data);
+		}
+	}
 
-			if(!read_map_node(temp_doc, root, {}, base)) {
-				return false;
+	void symbol_cache::emplace_pending_signature(std::string_view qual, std::string_view name, const unsigned char *bytes, const unsigned char *mask, std::size_t size, std::uint64_t offset, bool data) noexcept
+	{
+		pending_signature_t &sig{pending_signatures.emplace_back()};
+		sig.qual = qual;
+		sig.name = name;
+		sig.offset = offset;
+		sig.data = data;
+
+		//only masked out bytes are wildcards, a literal 0x2A is kept as a value and never added to null_positions
+		for(std::size_t i{0}; i < size; ++i) {
+			if(mask[i] == 0) {
+				sig.bytes.emplace_back(nullptr);
+			} else {
+				sig.bytes.emplace_back(static_cast<unsigned char>(bytes[i]));
 			}
 		}
-
-		return true;
 	}
 
 	namespace detail
 	{
-		static bool is_string_node(yaml_node_t *node) noexcept
+		using bytes_info_t = symbol_cache::qualification_info::name_info::bytes_info_t;
+		using null_or_byte_t = symbol_cache::qualification_info::name_info::null_or_byte_t;
+
+		static constexpr std::array<unsigned char, 256> byte_ranks{
+			[]() constexpr noexcept -> std::array<unsigned char, 256> {
+				//most frequent bytes in x86 code first
+				constexpr unsigned char common[]{
+					0x00, 0xFF, 0x8B, 0x89, 0x48, 0x24, 0x45, 0xE8, 0x83, 0x04,
+					0x08, 0x0F, 0x44, 0x8D, 0x10, 0x85, 0x01, 0x74, 0x75, 0xC7,
+					0x55, 0x5D, 0xC3, 0xCC, 0x90, 0x50, 0x4C, 0xEC, 0xE5, 0x53,
+					0x5B, 0x84, 0xEB, 0x0C, 0x14, 0x18, 0x20, 0x40, 0x80, 0x02,
+					0x03, 0x1C, 0x28, 0x30, 0x38, 0x56, 0x57, 0x5E, 0x5F, 0xF6
+				};
+
+				std::array<unsigned char, 256> ranks{};
+				for(std::size_t i{0}; i < ranks.size(); ++i) {
+					ranks[i] = 255;
+				}
+				for(std::size_t i{0}; i < sizeof(common); ++i) {
+					ranks[common[i]] = static_cast<unsigned char>(i);
+				}
+				return ranks;
+			}()
+		};
+
+		struct byte_pattern_t final
 		{
-			if(node->type != YAML_SCALAR_NODE) {
-				return false;
-			}
+			static constexpr std::size_t chunk{sizeof(__m128i)};
 
-			switch(node->data.scalar.style) {
-				case YAML_PLAIN_SCALAR_STYLE:
-				case YAML_SINGLE_QUOTED_SCALAR_STYLE:
-				case YAML_DOUBLE_QUOTED_SCALAR_STYLE: {
-					if(std::strcmp(reinterpret_cast<const char *>(node->tag), YAML_STR_TAG) == 0) {
-						return true;
-					} else {
-						return false;
+			byte_pattern_t() noexcept = default;
+			byte_pattern_t(byte_pattern_t &&) noexcept = default;
+			byte_pattern_t &operator=(byte_pattern_t &&) noexcept = default;
+
+			bool build(const bytes_info_t &bytes) noexcept
+			{
+				size = bytes.size();
+
+				std::size_t padded{(size + (chunk - 1)) & ~(chunk - 1)};
+				values.resize(padded, 0);
+				masks.resize(padded, 0);
+
+				bool found{false};
+
+				//null_or_byte_t can't tell a wildcard from a literal 0x2A, only null_positions can
+				std::size_t next_null{0};
+
+				for(std::size_t i{0}; i < size; ++i) {
+					if(next_null < bytes.null_positions.size() && bytes.null_positions[next_null] == i) {
+						++next_null;
+						continue;
+					}
+
+					values[i] = bytes[i];
+					masks[i] = 0xFF;
+
+					if(!found || byte_ranks[values[i]] > byte_ranks[byte1]) {
+						anchor2 = anchor1;
+						byte2 = byte1;
+						anchor1 = i;
+						byte1 = values[i];
+					} else if(anchor2 == anchor1 || byte_ranks[values[i]] > byte_ranks[byte2]) {
+						anchor2 = i;
+						byte2 = values[i];
 					}
+
+					found = true;
 				}
-				default:
-				return false;
-			}
-		}
 
-		static bool is_null_node(yaml_node_t *node) noexcept
-		{
-			if(node->type != YAML_SCALAR_NODE) {
-				return false;
+				if(found && !has_second_anchor()) {
+					anchor2 = anchor1;
+					byte2 = byte1;
+				}
+
+				std::memset(splat1, byte1, sizeof(splat1));
+				std::memset(splat2, byte2, sizeof(splat2));
+
+				return found;
 			}
 
-			switch(node->data.scalar.style) {
-				case YAML_PLAIN_SCALAR_STYLE:{
-					if(std::strcmp(reinterpret_cast<const char *>(node->tag), YAML_STR_TAG) == 0) {
-						if(std::strcmp(reinterpret_cast<const char *>(node->data.scalar.value), "null") == 0) {
-							return true;
-						} else {
-							return false;
-						}
-					} else {
+			inline bool has_second_anchor() const noexcept
+			{ return (anchor2 != anchor1 && masks[anchor2] != 0); }
+
+			inline std::size_t reach() const noexcept
+			{ return std::max(anchor1, anchor2); }
+
+			bool verify(const unsigned char *it, const unsigned char *end) const noexcept
+			{
+				std::size_t i{0};
+
+				for(; i < size && (it + i + chunk) <= end; i += chunk) {
+					__m128i data{_mm_loadu_si128(reinterpret_cast<const __m128i *>(it + i))};
+					__m128i value{_mm_loadu_si128(reinterpret_cast<const __m128i *>(values.data() + i))};
+					__m128i mask{_mm_loadu_si128(reinterpret_cast<const __m128i *>(masks.data() + i))};
+
+					if(!_mm_testz_si128(_mm_xor_si128(data, value), mask)) {
 						return false;
 					}
 				}
-				case YAML_LITERAL_SCALAR_STYLE: {
-					if(std::strcmp(reinterpret_cast<const char *>(node->tag), YAML_NULL_TAG) == 0) {
-						return true;
-					} else {
+
+				for(; i < size; ++i) {
+					if((it[i] & masks[i]) != values[i]) {
 						return false;
 					}
 				}
-				default:
-				return false;
+
+				return true;
 			}
-		}
 
-		template <typename T>
-		static bool read_int_node(yaml_node_t *node, T &value, int base = 10) noexcept
-		{
-			if(node->type != YAML_SCALAR_NODE) {
-				return false;
+			inline void match(unsigned char *it) noexcept
+			{
+				if(matches++ == 0) {
+					first = it;
+				}
 			}
 
-			switch(node->data.scalar.style) {
-				case YAML_PLAIN_SCALAR_STYLE: {
-					if(std::strcmp(reinterpret_cast<const char *>(node->tag), YAML_STR_TAG) == 0) {
-						if(std::strncmp(reinterpret_cast<const char *>(node->data.scalar.value), "null", node->data.scalar.length) == 0) {
-							value = static_cast<T>(static_cast<std::make_unsigned_t<T>>(-1));
-							return true;
-						} else {
-							const char *begin{reinterpret_cast<const char *>(node->data.scalar.value)};
+			std::vector<unsigned char> values;
+			std::vector<unsigned char> masks;
+			std::size_t size{0};
 
-							std::size_t len{node->data.scalar.length};
+			std::size_t anchor1{0};
+			std::size_t anchor2{0};
+			unsigned char byte1{0};
+			unsigned char byte2{0};
 
-							if(base == 16) {
-								if(len > 2) {
-									if(begin[0] == '0' &&
-										(begin[1] == 'x' || begin[1] == 'X')) {
-										begin += 2;
-										len -= 2;
-									}
-								}
-							}
+			alignas(32) unsigned char splat1[32]{};
+			alignas(32) unsigned char splat2[32]{};
 
-							const char *end{begin + len};
+			unsigned char *first{nullptr};
+			std::size_t matches{0};
 
-							std::from_chars_result fc_res{std::from_chars(begin, end, value, base)};
+		private:
+			byte_pattern_t(const byte_pattern_t &) = delete;
+			byte_pattern_t &operator=(const byte_pattern_t &) = delete;
+		};
 
-							if(fc_res.ec != std::error_code{} ||
-								fc_res.ptr != end) {
-								return false;
-							}
+		static unsigned char *scan_bytes_tail(unsigned char *it, unsigned char *end, std::vector<byte_pattern_t *> &patterns) noexcept
+		{
+			for(; it < end; ++it) {
+				for(byte_pattern_t *pattern : patterns) {
+					if(static_cast<std::size_t>(end - it) < pattern->size) {
+						continue;
+					}
 
-							return true;
-						}
-					} else {
-						return false;
+					if(it[pattern->anchor1] != pattern->byte1) {
+						continue;
+					}
+
+					if(pattern->verify(it, end)) {
+						pattern->match(it);
 					}
 				}
-				case YAML_LITERAL_SCALAR_STYLE: {
-					if(std::strcmp(reinterpret_cast<const char *>(node->tag), YAML_NULL_TAG) == 0) {
-						value = 0;
-						return true;
-					} else if(std::strcmp(reinterpret_cast<const char *>(node->tag), YAML_INT_TAG) == 0) {
-						switch(node->data.scalar.length) {
-						#ifndef __clang__
-							#pragma GCC diagnostic push
-							#pragma GCC diagnostic ignored "-Wcast-align"
-						#endif
-							case sizeof(char):
-							value = static_cast<T>(*reinterpret_cast<char *>(node->data.scalar.value));
-							return true;
-							case sizeof(short):
-							value = static_cast<T>(*reinterpret_cast<short *>(node->data.scalar.value));
-							return true;
-							case sizeof(int):
-							value = static_cast<T>(*reinterpret_cast<int *>(node->data.scalar.value));
-							return true;
-							case sizeof(long long):
-							value = static_cast<T>(*reinterpret_cast<long long *>(node->data.scalar.value));
-							return true;
-						#ifndef __clang__
-							#pragma GCC diagnostic pop
-						#endif
-							default:
-							return false;
+			}
+
+			return it;
+		}
+
+		static void scan_bytes_sse41(unsigned char *begin, unsigned char *end, std::vector<byte_pattern_t *> &patterns, std::size_t reach) noexcept
+		{
+			constexpr std::size_t width{sizeof(__m128i)};
+
+			unsigned char *it{begin};
+
+			if(static_cast<std::size_t>(end - begin) >= (width + reach)) {
+				unsigned char *last{end - (width + reach)};
+
+				for(; it <= last; it += width) {
+					for(std::size_t i{0}; i < patterns.size(); ++i) {
+						byte_pattern_t *pattern{patterns[i]};
+
+						__m128i eq1{_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(it + pattern->anchor1)), _mm_load_si128(reinterpret_cast<const __m128i *>(pattern->splat1)))};
+						__m128i eq2{_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(it + pattern->anchor2)), _mm_load_si128(reinterpret_cast<const __m128i *>(pattern->splat2)))};
+
+						unsigned int mask{static_cast<unsigned int>(_mm_movemask_epi8(_mm_and_si128(eq1, eq2)))};
+						while(mask != 0) {
+							unsigned char *candidate{it + __builtin_ctz(mask)};
+							mask &= (mask - 1);
+
+							if(static_cast<std::size_t>(end - candidate) >= pattern->size && pattern->verify(candidate, end)) {
+								pattern->match(candidate);
+							}
 						}
-					} else {
-						return false;
 					}
 				}
-				default:
-				return false;
 			}
-		}
 
-		using bytes_info_t = symbol_cache::qualification_info::name_info::bytes_info_t;
-		using null_or_byte_t = symbol_cache::qualification_info::name_info::null_or_byte_t;
+			scan_bytes_tail(it, end, patterns);
+		}
 
-		static unsigned char *resolve_bytes(unsigned char *base, std::uint64_t memory_size, const bytes_info_t &bytes) noexcept
+		__attribute__((__target__("avx2")))
+		static void scan_bytes_avx2(unsigned char *begin, unsigned char *end, std::vector<byte_pattern_t *> &patterns, std::size_t reach) noexcept
 		{
-			std::size_t num_bytes{bytes.size()};
+			constexpr std::size_t width{sizeof(__m256i)};
+
+			unsigned char *it{begin};
+
+			if(static_cast<std::size_t>(end - begin) >= (width + reach)) {
+				unsigned char *last{end - (width + reach)};
+
+				for(; it <= last; it += width) {
+					for(std::size_t i{0}; i < patterns.size(); ++i) {
+						byte_pattern_t *pattern{patterns[i]};
 
-			unsigned char *begin{base};
-			unsigned char *end{base + (memory_size - num_bytes)};
+						__m256i eq1{_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(it + pattern->anchor1)), _mm256_load_si256(reinterpret_cast<const __m256i *>(pattern->splat1)))};
+						__m256i eq2{_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(it + pattern->anchor2)), _mm256_load_si256(reinterpret_cast<const __m256i *>(pattern->splat2)))};
 
-			const unsigned char *bytes_begin{bytes.data()};
+						unsigned int mask{static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_and_si256(eq1, eq2)))};
+						while(mask != 0) {
+							unsigned char *candidate{it + __builtin_ctz(mask)};
+							mask &= (mask - 1);
 
-			if(!bytes.has_null()) {
-				for(unsigned char *it{begin}; it != end; ++it) {
-					if(__builtin_memcmp(it, bytes_begin, num_bytes) == 0) {
-						return it;
+							if(static_cast<std::size_t>(end - candidate) >= pattern->size && pattern->verify(candidate, end)) {
+								pattern->match(candidate);
+							}
+						}
 					}
 				}
+			}
 
-				return nullptr;
+			scan_bytes_tail(it, end, patterns);
+		}
+
+		static void scan_bytes(unsigned char *begin, std::uint64_t size, std::vector<byte_pattern_t *> &patterns) noexcept
+		{
+			if(patterns.empty() || !begin || size == 0) {
+				return;
+			}
+
+			std::size_t reach{0};
+			for(byte_pattern_t *pattern : patterns) {
+				reach = std::max(reach, pattern->reach());
+			}
+
+			unsigned char *end{begin + size};
+
+			static const bool has_avx2{__builtin_cpu_supports("avx2") != 0};
+			if(has_avx2) {
+				scan_bytes_avx2(begin, end, patterns, reach);
 			} else {
-				for(unsigned char *it{begin}; it != end; ++it) {
-					bool found{true};
-
-					std::size_t last_null_pos{0};
-					for(std::size_t null_pos : bytes.null_positions) {
-						std::size_t diff{null_pos-last_null_pos};
-						if(__builtin_memcmp(it+last_null_pos, bytes_begin+last_null_pos, diff) != 0) {
-							found = false;
-							break;
-						}
-						last_null_pos = null_pos;
-					}
+				scan_bytes_sse41(begin, end, patterns, reach);
+			}
+		}
+	}
 
-					if(found) {
-						if(__builtin_memcmp(it+last_null_pos, bytes_begin+last_null_pos, num_bytes-last_null_pos) == 0) {
-							return it;
-						}
+	namespace detail
+	{
+		//a literal 0x2A must only match itself, it used to be mistaken for a wildcard
+		static bool check_literal_wildcard_byte() noexcept
+		{
+			bytes_info_t bytes;
+			bytes.emplace_back(static_cast<unsigned char>(0x55)).emplace_back(static_cast<unsigned char>(0x8B)).emplace_back(static_cast<unsigned char>(0xEC));
+			bytes.emplace_back(static_cast<unsigned char>(0x6A)).emplace_back(static_cast<unsigned char>(0x2A));
+			bytes.emplace_back(nullptr).emplace_back(static_cast<unsigned char>(0xE8));
+
+			constexpr std::size_t at{16};
+
+			unsigned char buffer[64]{};
+			const unsigned char code[]{0x55, 0x8B, 0xEC, 0x6A, 0x2A, 0x11, 0xE8};
+			std::memcpy(buffer + at, code, sizeof(code));
+
+			auto count{
+				[&bytes,&buffer]() noexcept -> std::size_t {
+					byte_pattern_t pattern;
+					if(!pattern.build(bytes)) {
+						return 0;
 					}
+
+					std::vector<byte_pattern_t *> patterns{&pattern};
+					scan_bytes(buffer, sizeof(buffer), patterns);
+					return pattern.matches;
 				}
+			};
 
-				return nullptr;
+			if(count() != 1) {
+				return false;
+			}
+
+			//differs only at the literal 0x2A
+			buffer[at + 4] = 0x2B;
+			if(count() != 0) {
+				return false;
 			}
+
+			return true;
 		}
 	}
 
-	bool symbol_cache::read_final_map_node(yaml_document_t &doc, yaml_node_t *node, std::string &&qual, std::string &&name, unsigned char *base) noexcept
+	bool symbol_cache::resolve_signatures(unsigned char *base) noexcept
 	{
 		using namespace std::literals::string_view_literals;
 		using namespace std::literals::string_literals;
 
-		std::unordered_map<std::string, yaml_node_t *> members;
-
 		auto build_err_str{
-			[this,&qual,name](std::string_view pre, std::string_view post) noexcept -> void {
-				if(!pre.empty()) {
-					err_str += pre;
-					err_str += ' ';
-				}
-				err_str += '\'';
-				if(!qual.empty()) {
-					err_str += qual;
+			[this](const pending_signature_t &sig, std::string_view post) noexcept -> void {
+				err_str = '\'';
+				if(!sig.qual.empty()) {
+					err_str += sig.qual;
 					err_str += "::"sv;
 				}
-				err_str += name;
+				err_str += sig.name;
 				err_str += "' "sv;
 				err_str += post;
 			}
 		};
 
-		for(yaml_node_pair_t *pair{node->data.mapping.pairs.start}; pair != node->data.mapping.pairs.top; ++pair) {
-			yaml_node_t *key_node{yaml_document_get_node(&doc, pair->key)};
-			if(!detail::is_string_node(key_node)) {
-				build_err_str("key in"sv, "is not a string"sv);
-				return false;
-			}
+		std::vector<detail::byte_pattern_t> patterns;
+		patterns.resize(pending_signatures.size());
 
-			yaml_node_t *value_node{yaml_document_get_node(&doc, pair->value)};
+		std::vector<detail::byte_pattern_t *> mem_patterns;
+		std::vector<detail::byte_pattern_t *> data_patterns;
 
-			std::string keystr{reinterpret_cast<const char *>(key_node->data.scalar.value), key_node->data.scalar.length};
+		for(std::size_t i{0}; i < pending_signatures.size(); ++i) {
+			const pending_signature_t &sig{pending_signatures[i]};
+			if(sig.resolved) {
+				continue;
+			}
 
-			members.emplace(std::move(keystr), value_node);
-		}
+			if(!patterns[i].build(sig.bytes)) {
+				build_err_str(sig, "bytes has no fixed values"sv);
+				pending_signatures.clear();
+				return false;
+			}
 
-		auto method_node_it{members.find("method"s)};
-		if(method_node_it == members.end()) {
-			build_err_str({}, "is missing method"sv);
-			return false;
+			if(sig.data) {
+				data_patterns.emplace_back(&patterns[i]);
+			} else {
+				mem_patterns.emplace_back(&patterns[i]);
+			}
 		}
 
-		if(!detail::is_string_node(method_node_it->second)) {
-			build_err_str({}, "method is not a string"sv);
-			return false;
+		if(!mem_patterns.empty()) {
+			for(const segment_t &segment : exec_segments) {
+				detail::scan_bytes(base + segment.offset, segment.size, mem_patterns);
+			}
 		}
 
-		std::string_view methodstr{reinterpret_cast<const char *>(method_node_it->second->data.scalar.value), method_node_it->second->data.scalar.length};
+		detail::scan_bytes(base + data_offset, data_size, data_patterns);
 
-		if(methodstr.compare(0, 9, "byte_scan"sv) == 0) {
-			auto bytes_node_it{members.find("bytes"s)};
-			if(bytes_node_it == members.end()) {
-				build_err_str({}, "is missing bytes"sv);
-				return false;
+		for(std::size_t i{0}; i < pending_signatures.size(); ++i) {
+			pending_signature_t &sig{pending_signatures[i]};
+			if(sig.resolved) {
+				continue;
 			}
 
-			detail::bytes_info_t bytes;
-
-			switch(bytes_node_it->second->type) {
-				case YAML_SEQUENCE_NODE: {
-					if(std::strcmp(reinterpret_cast<const char *>(bytes_node_it->second->tag), YAML_SEQ_TAG) != 0) {
-						build_err_str({}, "bytes is not a array"sv);
-						return false;
-					}
-
-					for(yaml_node_item_t *item{bytes_node_it->second->data.sequence.items.start}; item != bytes_node_it->second->data.sequence.items.top; ++item) {
-						yaml_node_t *value_node{yaml_document_get_node(&doc, *item)};
-
-						if(detail::is_null_node(value_node)) {
-							bytes.emplace_back(nullptr);
-						} else {
-							unsigned char byte;
-							if(!detail::read_int_node<unsigned char>(value_node, byte, 16)) {
-								build_err_str({}, "bytes has a non byte value"sv);
-								return false;
-							}
+			const detail::byte_pattern_t &pattern{patterns[i]};
 
-							bytes.emplace_back(byte);
-						}
-					}
-				} break;
-				default: {
-					build_err_str({}, "bytes is not a array"sv);
-					return false;
+			if(pattern.matches == 0) {
+				debugtrap();
+				build_err_str(sig, "address not found"sv);
+				pending_signatures.clear();
+				return false;
+			} else if(pattern.matches > 1) {
+				if(sig.qual.empty()) {
+					warning("vmod: '%s' signature is ambiguous (%zu matches)\n"sv, sig.name.c_str(), pattern.matches);
+				} else {
+					warning("vmod: '%s::%s' signature is ambiguous (%zu matches)\n"sv, sig.qual.c_str(), sig.name.c_str(), pattern.matches);
 				}
 			}
 
-			unsigned char *addr{nullptr};
-
-			if(methodstr.ends_with("_mem"sv)) {
-				addr = detail::resolve_bytes(base, memory_size, bytes);
-			} else if(methodstr.ends_with("_data"sv)) {
-				addr = detail::resolve_bytes(base + data_offset, data_size, bytes);
-			} else {
-				build_err_str({}, "unknown method '"sv);
-				err_str += methodstr;
-				err_str += '\'';
-				return false;
-			}
+			sig.match = static_cast<std::uint64_t>(pattern.first - base);
+			sig.resolved = true;
+		}
 
-			auto offset_node_it{members.find("offset"s)};
-			if(offset_node_it != members.end()) {
-				std::uint64_t off;
-				if(!detail::read_int_node<std::uint64_t>(offset_node_it->second, off, 16)) {
-					build_err_str({}, "invalid offset"sv);
-					return false;
-				}
+		return true;
+	}
 
-				addr += off;
-			}
+	void symbol_cache::emplace_signatures(unsigned char *base) noexcept
+	{
+		for(pending_signature_t &sig : pending_signatures) {
+			unsigned char *addr{base + sig.match + sig.offset};
 
-			if(!addr) {
-				debugtrap();
-				build_err_str({}, "address not found"sv);
-				return false;
-			}
+			std::unique_ptr<qualification_info::name_info> info{new qualification_info::name_info};
+			info->set_bytes(std::move(sig.bytes));
+			info->resolve_absolute(addr);
 
-			if(qual.empty()) {
-				std::unique_ptr<qualification_info::name_info> info{new qualification_info::name_info};
-				info->set_bytes(std::move(bytes));
-				info->resolve_absolute(addr);
-				global_qual.names.emplace(std::move(name), std::move(info));
+			if(sig.qual.empty()) {
+				global_qual.names.emplace(std::move(sig.name), std::move(info));
 			} else {
-				auto this_qual_it{qualifications.find(qual)};
+				auto this_qual_it{qualifications.find(sig.qual)};
 				if(this_qual_it == qualifications.end()) {
-					this_qual_it = qualifications.emplace(std::move(qual), new class_info{}).first;
+					this_qual_it = qualifications.emplace(std::move(sig.qual), new class_info{}).first;
 				}
 
-				std::unique_ptr<qualification_info::name_info> info{new qualification_info::name_info};
-				info->set_bytes(std::move(bytes));
-				info->resolve_absolute(addr);
-				this_qual_it->second->names.emplace(std::move(name), std::move(info));
+				this_qual_it->second->names.emplace(std::move(sig.name), std::move(info));
 			}
-
-			return true;
-		} else {
-			build_err_str({}, "unknown method '"sv);
-			err_str += methodstr;
-			err_str += '\'';
-			return false;
 		}
+
+		pending_signatures.clear();
 	}
 
-	bool symbol_cache::read_array_node(yaml_document_t &doc, yaml_node_t *node, std::string_view name, unsigned char *base) noexcept
+	bool symbol_cache::read_signature_cache(const std::filesystem::path &path, std::uint64_t yaml_hash, std::size_t first) noexcept
 	{
-		using namespace std::literals::string_view_literals;
-		using namespace std::literals::string_literals;
+		std::size_t size{0};
+		std::unique_ptr<unsigned char[]> data{read_file(path, size)};
+		if(!data || size < sizeof(detail::sigs_header_t)) {
+			return false;
+		}
 
-		auto build_err_str{
-			[this,name](std::string_view post) noexcept -> void {
-				err_str = "value in '"s;
-				err_str += name;
-				err_str += "' "sv;
-				err_str += post;
-			}
-		};
+		detail::sigs_header_t header;
+		std::memcpy(&header, data.get(), sizeof(detail::sigs_header_t));
 
-		for(yaml_node_item_t *item{node->data.sequence.items.start}; item != node->data.sequence.items.top; ++item) {
-			yaml_node_t *value_node{yaml_document_get_node(&doc, *item)};
+		std::size_t count{pending_signatures.size() - first};
 
-			switch(value_node->type) {
-				case YAML_MAPPING_NODE: {
-					if(std::strcmp(reinterpret_cast<const char *>(value_node->tag), YAML_MAP_TAG) != 0) {
-						build_err_str("is not a map"sv);
-						return false;
-					}
+		if(std::memcmp(header.magic, detail::sigs_magic.data(), sizeof(detail::sigs_header_t::magic)) != 0 ||
+			header.version != detail::sigs_version ||
+			header.ptr_size != sizeof(void *) ||
+			header.module_hash != module_hash ||
+			header.yaml_hash != yaml_hash ||
+			header.num_sigs != count ||
+			(size - sizeof(detail::sigs_header_t)) != (count * sizeof(std::uint64_t))) {
+			return false;
+		}
 
-					if(!read_map_node(doc, value_node, name, base)) {
-						return false;
+		const unsigned char *it{data.get() + sizeof(detail::sigs_header_t)};
+
+		std::vector<std::uint64_t> matches;
+		matches.resize(count);
+		if(count > 0) {
+			std::memcpy(matches.data(), it, count * sizeof(std::uint64_t));
+		}
+
+		for(std::size_t i{0}; i < count; ++i) {
+			const pending_signature_t &sig{pending_signatures[first + i]};
+			std::uint64_t match{matches[i]};
+			std::size_t len{sig.bytes.size()};
+
+			bool inside{false};
+			if(sig.data) {
+				inside = (match >= data_offset && (match + len) <= (data_offset + data_size));
+			} else {
+				for(const segment_t &segment : exec_segments) {
+					if(match >= segment.offset && (match + len) <= (segment.offset + segment.size)) {
+						inside = true;
+						break;
 					}
-				} break;
-				default: {
-					build_err_str("is not a map"sv);
-					return false;
 				}
 			}
+
+			if(!inside) {
+				return false;
+			}
+		}
+
+		for(std::size_t i{0}; i < count; ++i) {
+			pending_signature_t &sig{pending_signatures[first + i]};
+			sig.match = matches[i];
+			sig.resolved = true;
 		}
 
 		return true;
 	}
 
-	bool symbol_cache::read_map_node(yaml_document_t &doc, yaml_node_t *node, std::string_view name, unsigned char *base) noexcept
+	void symbol_cache::write_signature_cache(const std::filesystem::path &path, std::uint64_t yaml_hash, std::size_t first, std::size_t count) const noexcept
 	{
 		using namespace std::literals::string_view_literals;
-		using namespace std::literals::string_literals;
 
-		for(yaml_node_pair_t *pair{node->data.mapping.pairs.start}; pair != node->data.mapping.pairs.top; ++pair) {
-			yaml_node_t *key_node{yaml_document_get_node(&doc, pair->key)};
-			if(!detail::is_string_node(key_node)) {
-				debugtrap();
-				err_str = "value in '"s;
-				err_str += name.empty() ? "root"sv : name;
-				err_str += "' is not a string"sv;
-				return false;
-			}
+		detail::sigs_header_t header{};
+		std::memcpy(header.magic, detail::sigs_magic.data(), sizeof(detail::sigs_header_t::magic));
+		header.version = detail::sigs_version;
+		header.ptr_size = sizeof(void *);
+		header.module_hash = module_hash;
+		header.yaml_hash = yaml_hash;
+		header.num_sigs = count;
 
-			std::string_view keystr{reinterpret_cast<const char *>(key_node->data.scalar.value), key_node->data.scalar.length};
+		std::size_t size{sizeof(detail::sigs_header_t) + (count * sizeof(std::uint64_t))};
 
-			auto build_err_str{
-				[this,keystr,name](std::string_view post) noexcept -> void {
-					err_str = "'"s;
-					err_str += keystr;
-					err_str += "' in '"sv;
-					err_str += name.empty() ? "root"sv : name;
-					err_str += "' "sv;
-					err_str += post;
-				}
-			};
+		std::unique_ptr<unsigned char[]> data{new unsigned char[size]};
+		std::memcpy(data.get(), &header, sizeof(detail::sigs_header_t));
 
-			yaml_node_t *value_node{yaml_document_get_node(&doc, pair->value)};
-			switch(value_node->type) {
-				case YAML_MAPPING_NODE: {
-					if(std::strcmp(reinterpret_cast<const char *>(value_node->tag), YAML_MAP_TAG) != 0) {
-						build_err_str("is not a map"sv);
-						return false;
-					}
+		unsigned char *it{data.get() + sizeof(detail::sigs_header_t)};
+		for(std::size_t i{0}; i < count; ++i) {
+			std::uint64_t match{pending_signatures[first + i].match};
+			std::memcpy(it, &match, sizeof(std::uint64_t));
+			it += sizeof(std::uint64_t);
+		}
 
-					std::string tmpqual{name};
-					std::string tmpname{keystr};
+		std::error_code ec;
+		std::filesystem::create_directories(path.parent_path(), ec);
 
-					if(!read_final_map_node(doc, value_node, std::move(tmpqual), std::move(tmpname), base)) {
-						return false;
-					}
-				} break;
-				case YAML_SEQUENCE_NODE: {
-					if(std::strcmp(reinterpret_cast<const char *>(value_node->tag), YAML_SEQ_TAG) != 0) {
-						build_err_str("is not a array"sv);
-						return false;
-					}
+		std::filesystem::path temp_path{path};
+		temp_path += ".tmp"sv;
 
-					if(!read_array_node(doc, value_node, keystr, base)) {
-						return false;
-					}
-				} break;
-				default: {
-					build_err_str("is not a array or map"sv);
-					return false;
-				}
-			}
-		}
+		write_file(temp_path, data.get(), size);
 
-		return true;
+		std::filesystem::rename(temp_path, path, ec);
+		if(ec) {
+			std::filesystem::remove(temp_path, ec);
+		}
 	}
 
 	bool symbol_cache::read_yamls(const std::filesystem::path &dir, unsigned char *base) noexcept
 	{
 		using namespace std::literals::string_view_literals;
 
+		std::vector<std::tuple<std::filesystem::path, std::uint64_t, std::size_t, std::size_t>> misses;
+
+		std::filesystem::path dir_filename{dir.filename()};
+		std::string_view dir_name{dir_filename.native()};
+
+		auto add_cache{
+			[this,&misses,&dir_filename](std::string_view filename, std::uint64_t yaml_hash, std::size_t first) noexcept -> void {
+				if(!module_hashed) {
+					return;
+				}
+
+				std::filesystem::path cache_path{sigs_dir};
+				cache_path /= dir_filename;
+				cache_path /= filename;
+				cache_path += ".sigs"sv;
+
+				if(!read_signature_cache(cache_path, yaml_hash, first)) {
+					misses.emplace_back(std::move(cache_path), yaml_hash, first, pending_signatures.size() - first);
+				}
+			}
+		};
+
+		//yamls on disk always take priority over their bundled copy
+		std::size_t num_bundled{bundle.num_files()};
+		std::vector<bool> superseded(num_bundled, false);
+
 		std::error_code ec;
 		for(const auto &file : std::filesystem::directory_iterator{dir, ec}) {
 			if(!file.is_regular_file()) {
@@ -1130,11 +2461,69 @@ namespace vmod
 				continue;
 			}
 
-			if(!read_yaml(path, base)) {
+			std::size_t first{pending_signatures.size()};
+
+			std::size_t yaml_size{0};
+			std::unique_ptr<unsigned char[]> yaml_data{read_file(path, yaml_size)};
+			if(yaml_size == 0) {
+				pending_signatures.clear();
+				return false;
+			}
+
+			std::uint64_t yaml_hash{XXH3_64bits(yaml_data.get(), yaml_size)};
+
+			bool bundled{false};
+
+			for(std::size_t i{0}; i < num_bundled; ++i) {
+				signature_bundle::file_view_t bfile{bundle.file(i)};
+				if(bfile.dir != dir_name || bfile.name != filename.native()) {
+					continue;
+				}
+
+				superseded[i] = true;
+
+				if(bfile.hash == yaml_hash) {
+					read_bundled(i);
+					bundled = true;
+				}
+				break;
+			}
+
+			if(!bundled && !read_yaml(yaml_data.get(), yaml_size)) {
+				pending_signatures.clear();
 				return false;
 			}
+
+			add_cache(filename.native(), yaml_hash, first);
+		}
+
+		for(std::size_t i{0}; i < num_bundled; ++i) {
+			if(superseded[i]) {
+				continue;
+			}
+
+			signature_bundle::file_view_t bfile{bundle.file(i)};
+			if(bfile.dir != dir_name) {
+				continue;
+			}
+
+			std::size_t first{pending_signatures.size()};
+
+			read_bundled(i);
+
+			add_cache(bfile.name, bfile.hash, first);
+		}
+
+		if(!resolve_signatures(base)) {
+			return false;
+		}
+
+		for(const auto &[cache_path, yaml_hash, first, count] : misses) {
+			write_signature_cache(cache_path, yaml_hash, first, count);
 		}
 
+		emplace_signatures(base);
+
 		return true;
 	}
 #endif
@@ -1402,7 +2791,7 @@ namespace vmod
 								}
 							#endif
 
-								name_it = this_qual_it->second->names.insert_or_assign(std::move(name), std::move(info)).first;
+								name_it = this_qual_it->second->names.insert_or_assign(string_t{name}, std::move(info)).first;
 								qual_it = this_qual_it;
 
 								auto map_it{offset_map.find(offset)};
@@ -1527,7 +2916,7 @@ namespace vmod
 								}
 							#endif
 
-								name_it = this_qual_it->second->names.insert_or_assign(std::move(func_name), std::move(info)).first;
+								name_it = this_qual_it->second->names.insert_or_assign(string_t{func_name}, std::move(info)).first;
 								qual_it = this_qual_it;
 
 								auto map_it{offset_map.find(offset)};
@@ -1686,7 +3075,7 @@ namespace vmod
 								}
 							#endif
 
-								name_it = this_qual_it->second->names.insert_or_assign(std::move(func_name), std::move(info)).first;
+								name_it = this_qual_it->second->names.insert_or_assign(string_t{func_name}, std::move(info)).first;
 								qual_it = this_qual_it;
 
 							#ifndef __VMOD_COMPILING_SYMBOL_TOOL
@@ -1730,7 +3119,7 @@ namespace vmod
 									info->size_ = sym.size;
 									info->resolve_from_base(base);
 
-									name_it = global_qual.names.insert_or_assign(std::move(func_name), std::move(info)).first;
+									name_it = global_qual.names.insert_or_assign(string_t{func_name}, std::move(info)).first;
 									qual_it = qualifications.end();
 									return true;
 								} else {
@@ -1765,6 +3154,12 @@ namespace vmod
 
 	std::size_t symbol_cache::vtable_size(const std::string &name) const noexcept
 	{
+	#ifndef GSDK_NO_SYMBOLS
+		if(!lazy_syms.empty()) {
+			const_cast<symbol_cache *>(this)->materialize_qualification(name);
+		}
+	#endif
+
 		auto it{vtable_sizes.find(name)};
 		if(it == vtable_sizes.end()) {
 			return static_cast<std::size_t>(-1);
@@ -1774,101 +3169,170 @@ namespace vmod
 	}
 
 #if !defined __VMOD_COMPILING_SYMBOL_TOOL && !defined GSDK_NO_SYMBOLS
-	template <bool F>
-	static std::uint64_t uncached_find_mangled_impl(const std::filesystem::path &path, std::string_view search) noexcept
+	namespace detail
 	{
-		int fd{open(path.c_str(), O_RDONLY)};
-		if(fd < 0) {
-			return 0;
-		}
+		struct mangled_index_t final
+		{
+			mangled_index_t() noexcept = default;
 
-		Elf *elf{elf_begin(fd, ELF_C_READ, nullptr)};
-		if(!elf) {
-			return 0;
-		}
+			inline ~mangled_index_t() noexcept
+			{
+				if(data) {
+					munmap(data, size);
+				}
+			}
 
-		if(elf_kind(elf) != ELF_K_ELF || gelf_getclass(elf) == ELFCLASSNONE) {
-			elf_end(elf);
-			return 0;
-		}
+			void *data{nullptr};
+			std::size_t size{0};
 
-		std::uint64_t offset{0};
+			std::unordered_map<std::string_view, std::uint64_t> funcs;
+			std::unordered_map<std::string_view, std::uint64_t> globals;
 
-		GElf_Shdr scn_hdr;
-		GElf_Sym sym;
+		private:
+			mangled_index_t(const mangled_index_t &) = delete;
+			mangled_index_t &operator=(const mangled_index_t &) = delete;
+			mangled_index_t(mangled_index_t &&) = delete;
+			mangled_index_t &operator=(mangled_index_t &&) = delete;
+		};
 
-		Elf_Scn *scn{elf_nextscn(elf, nullptr)};
-		while(scn) {
-			struct scope_nextscn final {
-				inline scope_nextscn(Elf *elf_, Elf_Scn *&scn_) noexcept
-					: elf{elf_}, scn{scn_} {}
-				inline ~scope_nextscn() noexcept
-				{ scn = elf_nextscn(elf, scn); }
-			private:
-				Elf *elf;
-				Elf_Scn *&scn;
-			};
+		static std::unordered_map<std::string, std::unique_ptr<mangled_index_t>> mangled_indices;
 
-			scope_nextscn snscn{elf, scn};
+		static mangled_index_t *build_mangled_index(const std::filesystem::path &path) noexcept
+		{
+			int fd{open(path.c_str(), O_RDONLY)};
+			if(fd < 0) {
+				return nullptr;
+			}
 
-			if(!gelf_getshdr(scn, &scn_hdr)) {
-				continue;
+			struct stat stat;
+			if(fstat(fd, &stat) != 0 || stat.st_size <= 0) {
+				close(fd);
+				return nullptr;
 			}
 
-			switch(scn_hdr.sh_type) {
-				case SHT_SYMTAB: break;
-				default: continue;
+			std::unique_ptr<mangled_index_t> index{new mangled_index_t};
+
+			index->size = static_cast<std::size_t>(stat.st_size);
+
+			void *data{mmap(nullptr, index->size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0)};
+			close(fd);
+			if(data == MAP_FAILED) {
+				return nullptr;
 			}
 
-			Elf_Data *scn_data{elf_getdata(scn, nullptr)};
+			index->data = data;
 
-			std::size_t count{static_cast<std::size_t>(scn_hdr.sh_size) / static_cast<std::size_t>(scn_hdr.sh_entsize)};
-			for(std::size_t i{0}; i < count; ++i) {
-				gelf_getsym(scn_data, static_cast<int>(i), &sym);
+			Elf *elf{elf_memory(static_cast<char *>(data), index->size)};
+			if(!elf) {
+				return nullptr;
+			}
+
+			if(elf_kind(elf) != ELF_K_ELF || gelf_getclass(elf) == ELFCLASSNONE) {
+				elf_end(elf);
+				return nullptr;
+			}
+
+			GElf_Shdr scn_hdr;
+			GElf_Sym sym;
+
+			Elf_Scn *scn{elf_nextscn(elf, nullptr)};
+			while(scn) {
+				struct scope_nextscn final {
+					inline scope_nextscn(Elf *elf_, Elf_Scn *&scn_) noexcept
+						: elf{elf_}, scn{scn_} {}
+					inline ~scope_nextscn() noexcept
+					{ scn = elf_nextscn(elf, scn); }
+				private:
+					Elf *elf;
+					Elf_Scn *&scn;
+				};
+
+				scope_nextscn snscn{elf, scn};
+
+				if(!gelf_getshdr(scn, &scn_hdr)) {
+					continue;
+				}
 
-				switch(GELF_ST_BIND(sym.st_info)) {
-					case STB_LOCAL: break;
+				switch(scn_hdr.sh_type) {
+					case SHT_SYMTAB: break;
 					default: continue;
 				}
 
-				if constexpr(F) {
-					switch(GELF_ST_TYPE(sym.st_info)) {
-						case STT_FUNC: break;
+				Elf_Data *scn_data{elf_getdata(scn, nullptr)};
+
+				std::size_t count{static_cast<std::size_t>(scn_hdr.sh_size) / static_cast<std::size_t>(scn_hdr.sh_entsize)};
+
+				index->funcs.reserve(index->funcs.size() + (count / 2));
+
+				for(std::size_t i{0}; i < count; ++i) {
+					gelf_getsym(scn_data, static_cast<int>(i), &sym);
+
+					switch(GELF_ST_BIND(sym.st_info)) {
+						case STB_LOCAL: break;
 						default: continue;
 					}
-				} else {
+
+					std::unordered_map<std::string_view, std::uint64_t> *names{nullptr};
+
 					switch(GELF_ST_TYPE(sym.st_info)) {
-						case STT_OBJECT: break;
+						case STT_FUNC:
+						names = &index->funcs;
+						break;
+						case STT_OBJECT:
+						names = &index->globals;
+						break;
 						default: continue;
 					}
-				}
 
-				switch(GELF_ST_VISIBILITY(sym.st_other)) {
-					case STV_DEFAULT: break;
-					default: continue;
-				}
+					switch(GELF_ST_VISIBILITY(sym.st_other)) {
+						case STV_DEFAULT: break;
+						default: continue;
+					}
 
-				std::string_view name_mangled{elf_strptr(elf, scn_hdr.sh_link, sym.st_name)};
-				if(name_mangled.empty()) {
-					continue;
-				}
+					//elf_memory strings point into the mapping so they outlive elf_end
+					const char *name_ptr{elf_strptr(elf, scn_hdr.sh_link, sym.st_name)};
+					if(!name_ptr) {
+						continue;
+					}
 
-				if(search == name_mangled) {
-					offset = static_cast<std::uint64_t>(sym.st_value);
-					break;
+					std::string_view name_mangled{name_ptr};
+					if(name_mangled.empty()) {
+						continue;
+					}
+
+					names->emplace(name_mangled, static_cast<std::uint64_t>(sym.st_value));
 				}
 			}
 
-			if(offset != 0) {
-				break;
+			elf_end(elf);
+
+			return mangled_indices.emplace(path.native(), std::move(index)).first->second.get();
+		}
+	}
+
+	template <bool F>
+	static std::uint64_t uncached_find_mangled_impl(const std::filesystem::path &path, std::string_view search) noexcept
+	{
+		detail::mangled_index_t *index{nullptr};
+
+		auto it{detail::mangled_indices.find(path.native())};
+		if(it != detail::mangled_indices.end()) {
+			index = it->second.get();
+		} else {
+			index = detail::build_mangled_index(path);
+			if(!index) {
+				return 0;
 			}
 		}
 
-		elf_end(elf);
+		const auto &names{F ? index->funcs : index->globals};
 
-		close(fd);
+		auto name_it{names.find(search)};
+		if(name_it == names.end()) {
+			return 0;
+		}
 
-		return offset;
+		return name_it->second;
 	}
 
 	std::uint64_t symbol_cache::uncached_find_mangled_func(const std::filesystem::path &path, std::string_view search) noexcept
@@ -1876,5 +3340,11 @@ namespace vmod
 
 	std::uint64_t symbol_cache::uncached_find_mangled_global(const std::filesystem::path &path, std::string_view search) noexcept
 	{ return uncached_find_mangled_impl<false>(path, search); }
+
+	void symbol_cache::drop_mangled_index(const std::filesystem::path &path) noexcept
+	{ detail::mangled_indices.erase(path.native()); }
+
+	void symbol_cache::drop_mangled_indices() noexcept
+	{ detail::mangled_indices.clear(); }
 #endif
 }
@@ -1,10 +1,10 @@
 #pragma once
 
-#if defined __VMOD_COMPILING_VTABLE_DUMPER || defined __VMOD_COMPILING_SIGNATURE_GUESSER
+#if defined __VMOD_COMPILING_VTABLE_DUMPER || defined __VMOD_COMPILING_SIGNATURE_GUESSER || defined __VMOD_COMPILING_SYMBOL_BENCH
 	#define __VMOD_COMPILING_SYMBOL_TOOL
 #endif
 
-#ifndef __VMOD_COMPILING_VTABLE_DUMPER
+#if !defined __VMOD_COMPILING_VTABLE_DUMPER && !defined __VMOD_COMPILING_SYMBOL_BENCH
 #include "gsdk/config.hpp"
 #endif
 
@@ -15,12 +15,15 @@
 #include <filesystem>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
 #include <functional>
+#include <chrono>
 #include "hacking.hpp"
 #include "type_traits.hpp"
 
 #ifndef __VMOD_COMPILING_SYMBOL_TOOL
-#include <yaml.h>
+#include "signature_bundle.hpp"
 #endif
 
 #include <libelf.h>
@@ -45,13 +48,139 @@ namespace vmod
 		inline const std::string &error_string() const noexcept
 		{ return err_str; }
 
+		struct timings_t final
+		{
+			using duration = std::chrono::steady_clock::duration;
+
+			duration symbols_collect{};
+			duration symbols_demangle{};
+			duration symbols_merge{};
+			duration vtables{};
+			duration index{};
+
+			std::size_t symbols{0};
+			std::size_t threads{0};
+
+			bool from_index{false};
+		};
+
+		inline const timings_t &timings() const noexcept
+		{ return timings_; }
+
+		inline std::size_t storage_size() const noexcept
+		{ return arena_.size(); }
+
+		static inline void set_compact_storage(bool value) noexcept
+		{ compact_storage = value; }
+	#ifndef GSDK_NO_SYMBOLS
+		static inline void set_lazy_symbols(bool value) noexcept
+		{ lazy_symbols = value; }
+	#endif
+
+	private:
+		class storage_arena final
+		{
+		public:
+			storage_arena() noexcept = default;
+			~storage_arena() noexcept;
+
+			void *allocate(std::size_t size, std::size_t align) noexcept;
+
+			void adopt(storage_arena &other) noexcept;
+
+			inline std::size_t size() const noexcept
+			{ return size_; }
+
+			//whether ptr lives in a chunk of any arena, those are freed with the arena not one by one
+			static bool owns(const void *ptr) noexcept;
+
+		private:
+			static constexpr std::size_t chunk_size{64 * 1024};
+
+			unsigned char *new_chunk(std::size_t size) noexcept;
+
+			std::vector<std::unique_ptr<unsigned char[]>> chunks;
+			unsigned char *cur{nullptr};
+			unsigned char *end{nullptr};
+			std::size_t size_{0};
+
+		private:
+			storage_arena(const storage_arena &) = delete;
+			storage_arena &operator=(const storage_arena &) = delete;
+			storage_arena(storage_arena &&) = delete;
+			storage_arena &operator=(storage_arena &&) = delete;
+		};
+
+		static bool compact_storage;
+		static thread_local storage_arena *current_arena;
+
+		static void *storage_allocate(std::size_t size, std::size_t align) noexcept;
+		static void storage_deallocate(void *ptr, std::size_t align) noexcept;
+
+		struct scope_arena final
+		{
+			inline scope_arena(storage_arena &arena) noexcept
+				: old{current_arena}
+			{ current_arena = &arena; }
+			inline ~scope_arena() noexcept
+			{ current_arena = old; }
+
+		private:
+			storage_arena *old;
+		};
+
+		template <typename T>
+		struct storage_allocator
+		{
+			using value_type = T;
+
+			storage_allocator() noexcept = default;
+			template <typename U>
+			inline storage_allocator(const storage_allocator<U> &) noexcept {}
+
+			inline T *allocate(std::size_t n) noexcept
+			{ return static_cast<T *>(storage_allocate(n * sizeof(T), alignof(T))); }
+			inline void deallocate(T *ptr, std::size_t) noexcept
+			{ storage_deallocate(ptr, alignof(T)); }
+
+			template <typename U>
+			inline bool operator==(const storage_allocator<U> &) const noexcept
+			{ return true; }
+		};
+
+		struct string_hash final
+		{
+			using is_transparent = void;
+
+			inline std::size_t operator()(std::string_view str) const noexcept
+			{ return std::hash<std::string_view>{}(str); }
+		};
+
+		struct string_equal final
+		{
+			using is_transparent = void;
+
+			inline bool operator()(std::string_view lhs, std::string_view rhs) const noexcept
+			{ return lhs == rhs; }
+		};
+
 	public:
+		using string_t = std::basic_string<char, std::char_traits<char>, storage_allocator<char>>;
+
+		template <typename T>
+		using storage_map_t = std::unordered_map<string_t, T, string_hash, string_equal, storage_allocator<std::pair<const string_t, T>>>;
+
 		struct qualification_info
 		{
 			friend class symbol_cache;
 
 			virtual ~qualification_info() noexcept;
 
+			static inline void *operator new(std::size_t size) noexcept
+			{ return storage_allocate(size, alignof(std::max_align_t)); }
+			static inline void operator delete(void *ptr) noexcept
+			{ storage_deallocate(ptr, alignof(std::max_align_t)); }
+
 			qualification_info() noexcept = default;
 			qualification_info(qualification_info &&) noexcept = default;
 			qualification_info &operator=(qualification_info &&) noexcept = default;
@@ -59,7 +188,7 @@ namespace vmod
 			struct name_info;
 
 		private:
-			using names_t = std::unordered_map<std::string, std::unique_ptr<name_info>>;
+			using names_t = storage_map_t<std::unique_ptr<name_info>>;
 
 		public:
 			struct name_info
@@ -68,6 +197,11 @@ namespace vmod
 
 				virtual ~name_info() noexcept;
 
+				static inline void *operator new(std::size_t size) noexcept
+				{ return storage_allocate(size, alignof(std::max_align_t)); }
+				static inline void operator delete(void *ptr) noexcept
+				{ storage_deallocate(ptr, alignof(std::max_align_t)); }
+
 				inline name_info() noexcept
 				{
 				}
@@ -322,9 +456,9 @@ namespace vmod
 		};
 
 	private:
-		using qualifications_t = std::unordered_map<std::string, std::unique_ptr<qualification_info>>;
+		using qualifications_t = storage_map_t<std::unique_ptr<qualification_info>>;
 
-		using vtable_sizes_t = std::unordered_map<std::string, std::size_t>;
+		using vtable_sizes_t = storage_map_t<std::size_t>;
 
 	public:
 		struct info_t
@@ -639,15 +773,32 @@ namespace vmod
 		using const_iterator = qualifications_t::const_iterator;
 
 		inline const_iterator find(const std::string &name) const noexcept
-		{ return qualifications.find(name); }
+		{
+		#ifndef GSDK_NO_SYMBOLS
+			if(!lazy_syms.empty()) {
+				const_cast<symbol_cache *>(this)->materialize_qualification(name);
+			}
+		#endif
+			return qualifications.find(name);
+		}
 
+		//enumerating needs every class, so in lazy mode the first walk materializes whatever is still pending
 		inline const_iterator begin() const noexcept
-		{ return qualifications.cbegin(); }
+		{
+		#ifndef GSDK_NO_SYMBOLS
+			if(!lazy_syms.empty()) {
+				const_cast<symbol_cache *>(this)->materialize_all();
+			}
+		#endif
+			return qualifications.cbegin();
+		}
+
+		//not here too, find() == end() would otherwise materialize everything and invalidate what find() returned
 		inline const_iterator end() const noexcept
 		{ return qualifications.cend(); }
 
 		inline const_iterator cbegin() const noexcept
-		{ return qualifications.cbegin(); }
+		{ return begin(); }
 		inline const_iterator cend() const noexcept
 		{ return qualifications.cend(); }
 
@@ -659,13 +810,27 @@ namespace vmod
 	#ifndef __VMOD_COMPILING_SYMBOL_TOOL
 		static std::uint64_t uncached_find_mangled_func(const std::filesystem::path &path, std::string_view search) noexcept;
 		static std::uint64_t uncached_find_mangled_global(const std::filesystem::path &path, std::string_view search) noexcept;
+
+		static void drop_mangled_index(const std::filesystem::path &path) noexcept;
+		static void drop_mangled_indices() noexcept;
 	#endif
 
 	private:
 		std::string err_str;
 
+		timings_t timings_;
+
+	#if !defined __VMOD_COMPILING_SYMBOL_TOOL && !defined GSDK_NO_SYMBOLS
+		void report_timings(const std::filesystem::path &path) const noexcept;
+	#endif
+
 	#ifndef __VMOD_COMPILING_SYMBOL_TOOL
 		static std::filesystem::path yamls_dir;
+		static std::filesystem::path sigs_dir;
+		static signature_bundle bundle;
+		#ifndef GSDK_NO_SYMBOLS
+		static std::filesystem::path index_dir;
+		#endif
 	#endif
 
 	#ifndef GSDK_NO_SYMBOLS
@@ -681,11 +846,29 @@ namespace vmod
 		bool read_elf_info(int fd) noexcept;
 
 		bool read_yamls(const std::filesystem::path &dir, unsigned char *base) noexcept;
-		bool read_yaml(const std::filesystem::path &path, unsigned char *base) noexcept;
+		bool read_yaml(const unsigned char *data, std::size_t size) noexcept;
+		void read_bundled(std::size_t i) noexcept;
+
+		void emplace_pending_signature(std::string_view qual, std::string_view name, const unsigned char *bytes, const unsigned char *mask, std::size_t size, std::uint64_t offset, bool data) noexcept;
 
-		bool read_array_node(yaml_document_t &doc, yaml_node_t *node, std::string_view name, unsigned char *base) noexcept;
-		bool read_map_node(yaml_document_t &doc, yaml_node_t *node, std::string_view name, unsigned char *base) noexcept;
-		bool read_final_map_node(yaml_document_t &doc, yaml_node_t *node, std::string &&qualifier, std::string &&name, unsigned char *base) noexcept;
+		struct pending_signature_t final
+		{
+			std::string qual;
+			std::string name;
+			qualification_info::name_info::bytes_info_t bytes;
+			std::uint64_t offset{0};
+			bool data{false};
+			std::uint64_t match{0};
+			bool resolved{false};
+		};
+
+		bool resolve_signatures(unsigned char *base) noexcept;
+		void emplace_signatures(unsigned char *base) noexcept;
+
+		bool read_signature_cache(const std::filesystem::path &path, std::uint64_t yaml_hash, std::size_t first) noexcept;
+		void write_signature_cache(const std::filesystem::path &path, std::uint64_t yaml_hash, std::size_t first, std::size_t count) const noexcept;
+
+		std::vector<pending_signature_t> pending_signatures;
 	#endif
 
 	#ifndef GSDK_NO_SYMBOLS
@@ -697,13 +880,49 @@ namespace vmod
 			std::uint64_t size;
 		};
 
+		void handle_symbol(std::string_view name_mangled, basic_sym_t &&sym, unsigned char *base) noexcept;
+		void merge_shard(symbol_cache &shard) noexcept;
+
 		bool handle_component(std::string_view name_mangled, demangle_component *old_component, demangle_component *component, qualifications_t::iterator &qual_it, qualification_info::names_t::iterator &name_it, basic_sym_t &&sym, unsigned char *base, bool elf) noexcept;
 
 		void resolve_vtables(unsigned char *base, bool elf) noexcept;
+		void resolve_vtable(class_info &info, unsigned char *base, bool elf) noexcept;
+
+		static bool lazy_symbols;
+
+		struct lazy_sym_t final
+		{
+			std::size_t name_off;
+			std::size_t name_len;
+			basic_sym_t sym;
+			bool done;
+		};
+
+		inline std::string_view lazy_name(const lazy_sym_t &lazy) const noexcept
+		{ return std::string_view{lazy_strings.data() + lazy.name_off, lazy.name_len}; }
+
+		void sort_lazy_symbols() noexcept;
+		void materialize_lazy_sym(lazy_sym_t &lazy) noexcept;
+		void materialize_lazy_value(std::uint64_t off) noexcept;
+		void materialize_qualification(std::string_view name) noexcept;
+		void materialize_all() noexcept;
+
+		std::string lazy_strings;
+		std::vector<lazy_sym_t> lazy_syms;
+		std::vector<std::size_t> lazy_by_value;
+		std::unordered_set<std::string> lazy_quals;
+		unsigned char *lazy_base{nullptr};
+
+	#ifndef __VMOD_COMPILING_SYMBOL_TOOL
+		bool read_index(const std::filesystem::path &path, std::uint64_t hash, unsigned char *base) noexcept;
+		void write_index(const std::filesystem::path &path, std::uint64_t hash) const noexcept;
+	#endif
 
 		std::unordered_map<std::uint64_t, std::vector<info_t>> offset_map;
 	#endif
 
+		storage_arena arena_;
+
 		qualifications_t qualifications;
 		vtable_sizes_t vtable_sizes;
 
@@ -713,7 +932,16 @@ namespace vmod
 		qualification_info::names_t::iterator delt_virt_it;
 
 	#ifndef __VMOD_COMPILING_SYMBOL_TOOL
-		std::uint64_t memory_size{0};
+		struct segment_t final
+		{
+			std::uint64_t offset{0};
+			std::uint64_t size{0};
+		};
+
+		std::vector<segment_t> exec_segments;
+
+		std::uint64_t module_hash{0};
+		bool module_hashed{false};
 
 		std::uint64_t data_size{0};
 		std::uint64_t data_offset{0};
@@ -734,7 +962,7 @@ namespace std
 	struct hash<vmod::symbol_cache::const_iterator>
 	{
 		inline size_t operator()(vmod::symbol_cache::const_iterator it) const noexcept
-		{ return hash<std::string>{}(it->first); }
+		{ return hash<std::string_view>{}(it->first); }
 	};
 
 	template <>
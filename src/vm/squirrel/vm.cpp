@@ -5,10 +5,24 @@
 #include "../../main.hpp"
 #include <string>
 #include <string_view>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <functional>
 #include "../../gsdk/mathlib/vector.hpp"
 #include "../../bindings/docs.hpp"
 #include "../../filesystem.hpp"
+#include "../../xxhash.hpp"
 #include "../../gsdk/tier1/utlstring.hpp"
+#include "../../gsdk/tier1/utlbuffer.hpp"
+
+#if __has_include("build_id.hpp")
+	#include "build_id.hpp"
+#endif
+
+#ifndef __VMOD_BUILD_ID
+	#define __VMOD_BUILD_ID "unknown"
+#endif
 
 #ifdef __clang__
 #pragma clang diagnostic push
@@ -48,6 +62,7 @@
 #endif
 #include <sqfuncproto.h>
 #include <sqclosure.h>
+#include <sqvm.h>
 #ifdef __clang__
 #pragma clang diagnostic pop
 #else
@@ -614,6 +629,26 @@ namespace vmod::vm
 		return 0;
 	}
 
+	namespace detail
+	{
+		//the 4th lane is always zero so it never contributes to sums
+		using vec4f = float __attribute__((__vector_size__(16)));
+
+		static inline vec4f vec4f_load(const gsdk::Vector &vec) noexcept
+		{ return vec4f{vec.x, vec.y, vec.z, 0.0f}; }
+		static inline gsdk::Vector vec4f_store(vec4f vec) noexcept
+		{ return gsdk::Vector{vec[0], vec[1], vec[2]}; }
+		static inline float vec4f_hsum(vec4f vec) noexcept
+		{ return (vec[0] + vec[1]) + (vec[2] + vec[3]); }
+
+		static inline float vec4f_dot(vec4f a, vec4f b) noexcept
+		{ return vec4f_hsum(a * b); }
+		static inline vec4f vec4f_lerp(vec4f a, vec4f b, float t) noexcept
+		{ return a + ((b - a) * t); }
+		static inline vec4f vec4f_normalized(vec4f vec) noexcept
+		{ return vec * (1.0f / (__builtin_sqrtf(vec4f_dot(vec, vec)) + FLT_EPSILON)); }
+	}
+
 	template <typename T, typename ...Args>
 	static bool create_vector3d(HSQUIRRELVM vm, Args &&...args) noexcept
 	{
@@ -1274,7 +1309,7 @@ namespace vmod::vm
 		gsdk::Vector &vec1{*static_cast<gsdk::Vector *>(userptr1)};
 		gsdk::Vector &vec2{*static_cast<gsdk::Vector *>(userptr2)};
 
-		sq_pushfloat(vm, vec1.dot(vec2));
+		sq_pushfloat(vm, detail::vec4f_dot(detail::vec4f_load(vec1), detail::vec4f_load(vec2)));
 		return 1;
 	}
 
@@ -1351,6 +1386,94 @@ namespace vmod::vm
 		return 1;
 	}
 
+	template <bool sqr>
+	static SQInteger vector3d_dist(HSQUIRRELVM vm)
+	{
+		using namespace std::literals::string_view_literals;
+
+		SQInteger top{sq_gettop(vm)};
+		if(top != 2) {
+			return sq_throwerror(vm, _SC("wrong number of parameters"));
+		}
+
+		SQUserPointer userptr1{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, -1, &userptr1, typeid_ptr<gsdk::Vector>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		SQUserPointer userptr2{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, -2, &userptr2, typeid_ptr<gsdk::Vector>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		detail::vec4f delta{detail::vec4f_load(*static_cast<gsdk::Vector *>(userptr2)) - detail::vec4f_load(*static_cast<gsdk::Vector *>(userptr1))};
+		float len_sqr{detail::vec4f_dot(delta, delta)};
+
+		if constexpr(sqr) {
+			sq_pushfloat(vm, len_sqr);
+		} else {
+			sq_pushfloat(vm, __builtin_sqrtf(len_sqr));
+		}
+
+		return 1;
+	}
+
+	static SQInteger vector3d_lerp(HSQUIRRELVM vm)
+	{
+		using namespace std::literals::string_view_literals;
+
+		SQInteger top{sq_gettop(vm)};
+		if(top != 3) {
+			return sq_throwerror(vm, _SC("wrong number of parameters"));
+		}
+
+		float t{0.0f};
+		if(SQ_FAILED(sq_getfloat(vm, -1, &t))) {
+			return sq_throwerror(vm, _SC("failed to get t parameter"));
+		}
+
+		SQUserPointer userptr1{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, -2, &userptr1, typeid_ptr<gsdk::Vector>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		SQUserPointer userptr2{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, -3, &userptr2, typeid_ptr<gsdk::Vector>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		detail::vec4f res{detail::vec4f_lerp(detail::vec4f_load(*static_cast<gsdk::Vector *>(userptr2)), detail::vec4f_load(*static_cast<gsdk::Vector *>(userptr1)), t)};
+
+		if(!create_vector3d<gsdk::Vector>(vm, detail::vec4f_store(res))) {
+			return sq_throwerror(vm, _SC("failed to create object"));
+		}
+
+		return 1;
+	}
+
+	static SQInteger vector3d_normalized(HSQUIRRELVM vm)
+	{
+		using namespace std::literals::string_view_literals;
+
+		SQInteger top{sq_gettop(vm)};
+		if(top != 1) {
+			return sq_throwerror(vm, _SC("wrong number of parameters"));
+		}
+
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, -1, &userptr, typeid_ptr<gsdk::Vector>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		detail::vec4f res{detail::vec4f_normalized(detail::vec4f_load(*static_cast<gsdk::Vector *>(userptr)))};
+
+		if(!create_vector3d<gsdk::Vector>(vm, detail::vec4f_store(res))) {
+			return sq_throwerror(vm, _SC("failed to create object"));
+		}
+
+		return 1;
+	}
+
 #ifdef __VMOD_USING_QUIRREL
 	void squirrel::compile_err_func(HSQUIRRELVM vm, const SQChar *desc, const SQChar *src, SQInteger line, SQInteger column, const SQChar *extra)
 	{
@@ -1804,6 +1927,34 @@ namespace vmod::vm
 				return false;
 			}
 
+			if(!register_func({
+				"Async"sv, coroutine_async, -2, ".c"sv
+			})) {
+				sq_pop(impl, 1);
+				return false;
+			}
+
+			if(!register_func({
+				"WaitTicks"sv, coroutine_wait_ticks, -1, ".i"sv
+			})) {
+				sq_pop(impl, 1);
+				return false;
+			}
+
+			if(!register_func({
+				"WaitUntil"sv, coroutine_wait_until, 2, ".n"sv
+			})) {
+				sq_pop(impl, 1);
+				return false;
+			}
+
+			if(!register_func({
+				"WaitFuture"sv, coroutine_wait_future, 2, ".x"sv
+			})) {
+				sq_pop(impl, 1);
+				return false;
+			}
+
 			sq_pop(impl, 1);
 		}
 
@@ -1893,6 +2044,10 @@ namespace vmod::vm
 				vector_funcs.emplace_back(native_closure_info{"Length2DSqr"sv, vector3d_len2d_sqr, 1, "x"sv});
 				vector_funcs.emplace_back(native_closure_info{"Norm"sv, vector3d_norm, 1, "x"sv});
 				vector_funcs.emplace_back(native_closure_info{"Angles"sv, vector3d_ang, 1, "x"sv});
+				vector_funcs.emplace_back(native_closure_info{"Normalized"sv, vector3d_normalized, 1, "x"sv});
+				vector_funcs.emplace_back(native_closure_info{"Distance"sv, vector3d_dist<false>, 2, "xx"sv});
+				vector_funcs.emplace_back(native_closure_info{"DistanceSqr"sv, vector3d_dist<true>, 2, "xx"sv});
+				vector_funcs.emplace_back(native_closure_info{"Lerp"sv, vector3d_lerp, 3, "xxn"sv});
 
 				if(!register_class(
 					vector_class, vector_registered, "Vector"sv, std::type_identity<gsdk::Vector>{}, vector_funcs)) {
@@ -1919,6 +2074,21 @@ namespace vmod::vm
 				}
 			}
 
+			{
+				std::vector<native_closure_info> future_funcs{
+					native_closure_info{"constructor"sv, future_ctor, 1, "x"sv},
+					native_closure_info{"Resolve"sv, future_resolve, -1, "x."sv},
+					native_closure_info{"IsResolved"sv, future_is_resolved, 1, "x"sv},
+					native_closure_info{"Value"sv, future_value, 1, "x"sv}
+				};
+
+				if(!register_class(
+					future_class, future_registered, "Future"sv, std::type_identity<future_ud_t>{}, future_funcs)) {
+					sq_pop(impl, 1);
+					return false;
+				}
+			}
+
 			sq_pop(impl, 1);
 		}
 
@@ -2030,12 +2200,39 @@ namespace vmod::vm
 			sq_pop(impl, 1);
 		}
 
+		start_compile_worker();
+
 		return true;
 	}
 
 	void squirrel::Shutdown()
 	{
+		stop_compile_worker();
+
 		if(impl) {
+			profiling_ = false;
+			watchdog_budget = std::chrono::milliseconds{0};
+			update_debug_hook();
+			profile.reset(nullptr);
+			for(auto &it : coroutines) {
+				sq_release(impl, &it.second.thread);
+			}
+			coroutines.clear();
+			tick_waits.clear();
+			time_waits.clear();
+			ready_coroutines.clear();
+			running_coroutine = 0;
+			for(auto &it : futures) {
+				if(it.second.resolved) {
+					sq_release(impl, &it.second.value);
+				}
+			}
+			futures.clear();
+			if(future_registered) {
+				sq_release(impl, &future_class);
+				sq_resetobject(&future_class);
+				future_registered = false;
+			}
 			if(qangle_registered) {
 				sq_release(impl, &qangle_class);
 				sq_resetobject(&qangle_class);
@@ -2077,6 +2274,11 @@ namespace vmod::vm
 				sq_resetobject(&register_func_desc);
 				got_reg_func_desc = false;
 			}
+			for(auto &&it : key_cache) {
+				sq_release(impl, &it.second);
+			}
+			key_cache.clear();
+			key_slots.fill(key_slot_t{});
 		#ifdef __VMOD_USING_QUIRREL
 			modules.reset(nullptr);
 		#endif
@@ -2085,6 +2287,12 @@ namespace vmod::vm
 			impl = nullptr;
 		}
 
+		if(handles.live_count() > 0) {
+			warning("vmod vm: %zu script handles were never released\n"sv, handles.live_count());
+		}
+
+		handles.retire();
+
 		unique_ids = 0;
 	}
 
@@ -2125,380 +2333,1893 @@ namespace vmod::vm
 		return false;
 	}
 
-	bool squirrel::Frame([[maybe_unused]] float)
+#ifdef __VMOD_SQUIRREL_COUNT_ALLOCATIONS
+	extern SQUnsignedInteger sq_vm_allocated();
+#endif
+
+	std::size_t squirrel::heap_size() noexcept
 	{
-		return true;
+	#ifdef __VMOD_SQUIRREL_COUNT_ALLOCATIONS
+		return static_cast<std::size_t>(sq_vm_allocated());
+	#else
+		return 0;
+	#endif
 	}
 
-	gsdk::ScriptStatus_t squirrel::Run(const char *code, bool wait)
+	namespace detail
 	{
-		if(SQ_FAILED(sq_compilebuffer(impl, code, static_cast<SQInteger>(std::strlen(code)), "<<unnamed>>", SQTrue))) {
-			return gsdk::SCRIPT_ERROR;
+		//used until a collection was timed, deliberately pessimistic
+		static constexpr double gc_default_ns_per_byte{1.0};
+		//ticks that must arrive on schedule before the server counts as having slack
+		static constexpr std::size_t gc_min_on_time_frames{8};
+	}
+
+	std::chrono::nanoseconds squirrel::gc_estimate() const noexcept
+	{
+		//cost of a full collection follows heap size
+		std::size_t heap{heap_size()};
+		if(heap > 0) {
+			double ns_per_byte{(gc_ns_per_byte > 0.0) ? gc_ns_per_byte : detail::gc_default_ns_per_byte};
+			return std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(static_cast<double>(heap) * ns_per_byte)};
 		}
 
-		sq_pushroottable(impl);
+		return gc_estimate_;
+	}
 
-		bool failed{SQ_FAILED(sq_call(impl, 1, SQFalse, SQTrue))};
+	std::size_t squirrel::collect_garbage(bool forced) noexcept
+	{
+		std::size_t heap{heap_size()};
 
-		sq_pop(impl, 1);
+		auto begin{std::chrono::steady_clock::now()};
+		SQInteger freed{sq_collectgarbage(impl)};
+		std::chrono::nanoseconds time{std::chrono::steady_clock::now() - begin};
 
-		if(failed) {
-			return gsdk::SCRIPT_ERROR;
-		} else if(wait) {
-			return gsdk::SCRIPT_DONE;
+		gc_elapsed = 0.0f;
+
+		//smooth the samples instead of trusting one
+		if(gc_estimate_.count() == 0) {
+			gc_estimate_ = time;
 		} else {
-			return gsdk::SCRIPT_RUNNING;
+			gc_estimate_ = ((gc_estimate_ * 3) + time) / 4;
 		}
-	}
 
-	gsdk::ScriptHandleWrapper_t squirrel::CompileScript_strict(const char *code, const char *name) noexcept
-	{
-		if(!name || name[0] == '\0') {
-			name = "<<unnamed>>";
+		if(heap > 0) {
+			double ns_per_byte{static_cast<double>(time.count()) / static_cast<double>(heap)};
+			if(gc_ns_per_byte <= 0.0) {
+				gc_ns_per_byte = ns_per_byte;
+			} else {
+				gc_ns_per_byte = ((gc_ns_per_byte * 3.0) + ns_per_byte) / 4.0;
+			}
 		}
 
-		if(SQ_FAILED(sq_compilebuffer_strict(impl, code, static_cast<SQInteger>(std::strlen(code)), name, USQTrue))) {
-			return gsdk::ScriptHandleWrapper_t{};
-		}
+		std::size_t num_freed{(freed > 0) ? static_cast<std::size_t>(freed) : 0};
 
-		gsdk::ScriptHandleWrapper_t tmp;
-		tmp.object = compile_script();
-		tmp.should_free_ = true;
+		++gc_stats_.collections;
+		if(forced) {
+			++gc_stats_.forced;
+		}
+		gc_stats_.objects_freed += num_freed;
+		gc_stats_.last_freed = num_freed;
+		gc_stats_.total_time += time;
+		gc_stats_.last_time = time;
+		if(time > gc_stats_.max_time) {
+			gc_stats_.max_time = time;
+		}
 
-		return tmp;
+		return num_freed;
 	}
 
-	gsdk::HSCRIPT squirrel::CompileScript_impl(const char *code, const char *name)
+	squirrel *squirrel::hook_owner{nullptr};
+
+	void squirrel::debug_hook(HSQUIRRELVM vm, [[maybe_unused]] SQInteger type, const SQChar *source, SQInteger line, const SQChar *func)
 	{
-		if(!name || name[0] == '\0') {
-			name = "<<unnamed>>";
+		squirrel *actual_vm{hook_owner};
+		if(!actual_vm) {
+			return;
 		}
 
-		if(SQ_FAILED(sq_compilebuffer(impl, code, static_cast<SQInteger>(std::strlen(code)), name, SQTrue))) {
-			return gsdk::INVALID_HSCRIPT;
+		auto now{std::chrono::steady_clock::now()};
+
+		if(actual_vm->watchdog_depth > 0 && actual_vm->watchdog_budget.count() > 0) {
+			if(actual_vm->watchdog_tripped || now >= actual_vm->watchdog_deadline) {
+				actual_vm->watchdog_trip(vm, source, line, func);
+				return;
+			}
 		}
 
-		return compile_script();
+		if(actual_vm->profiling_) {
+			profile_t &prof{*actual_vm->profile};
+			if(now >= prof.next_sample) {
+				prof.next_sample = now + prof.interval;
+				actual_vm->take_profile_sample(vm);
+			}
+		}
 	}
 
-	gsdk::HSCRIPT squirrel::compile_script() noexcept
+	void squirrel::apply_debug_hook(HSQUIRRELVM thread) const noexcept
 	{
-		HSQOBJECT *script_obj{new HSQOBJECT};
-		sq_resetobject(script_obj);
+		sq_setnativedebughook(thread, (hook_owner == this) ? debug_hook : nullptr);
+	}
 
-		if(SQ_FAILED(sq_getstackobj(impl, -1, script_obj))) {
-			sq_release(impl, script_obj);
-			delete script_obj;
-			script_obj = vs_cast(gsdk::INVALID_HSCRIPT);
-		} else {
-			sq_addref(impl, script_obj);
+	void squirrel::update_debug_hook() noexcept
+	{
+		if(profiling_ || watchdog_budget.count() > 0) {
+			hook_owner = this;
+		} else if(hook_owner == this) {
+			hook_owner = nullptr;
 		}
 
-		sq_pop(impl, 1);
+		apply_debug_hook(impl);
 
-		return vs_cast(script_obj);
+		//every live coroutine thread too, not just the ones started after the change
+		for(auto &it : coroutines) {
+			apply_debug_hook(it.second.vm);
+		}
 	}
 
-	gsdk::ScriptStatus_t squirrel::Run(gsdk::HSCRIPT obj, gsdk::HSCRIPT scope, bool wait)
+	void squirrel::watchdog_trip(HSQUIRRELVM vm, const SQChar *source, SQInteger line, const SQChar *func) noexcept
 	{
-		//TEMP!!! for l4d2
-		if(obj == gsdk::INVALID_HSCRIPT) {
-			return gsdk::SCRIPT_ERROR;
-		}
+		using namespace std::literals::string_view_literals;
 
-		sq_pushobject(impl, *vs_cast(obj));
+		if(!watchdog_tripped) {
+			watchdog_tripped = true;
+			++watchdog_aborts_;
 
-		if(scope) {
-			sq_pushobject(impl, *vs_cast(scope));
-		} else {
-			sq_pushroottable(impl);
+			error("vmod vm: '%s' (%s:%lli) exceeded the %lims watchdog budget, aborting call\n"sv,
+				func ? func : _SC("unknown"), source ? source : _SC("unknown"), static_cast<long long>(line), static_cast<long>(watchdog_budget.count()));
 		}
 
-		bool failed{SQ_FAILED(sq_call(impl, 1, SQFalse, SQTrue))};
-
-		sq_pop(impl, 1);
+		//the hook cant unwind, so send the current frame to its trailing return, every frame down to the call does the same
+		if(vm->ci && sq_isclosure(vm->ci->_closure)) {
+			SQFunctionProto *proto{_closure(vm->ci->_closure)->_function};
+			if(proto->_ninstructions > 0) {
+				//the jump skips the _OP_POPTRAP of any try this frame is in, left behind
+				//they would pile up and a later throw in an outer frame would land in this dead one
+				for(; vm->ci->_etraps > 0; --vm->ci->_etraps) {
+					vm->_etraps.pop_back();
+				}
 
-		if(failed) {
-			return gsdk::SCRIPT_ERROR;
-		} else if(wait) {
-			return gsdk::SCRIPT_DONE;
-		} else {
-			return gsdk::SCRIPT_RUNNING;
+				vm->ci->_ip = proto->_instructions + (proto->_ninstructions - 1);
+			}
 		}
 	}
 
-	gsdk::ScriptStatus_t squirrel::Run(gsdk::HSCRIPT obj, bool wait)
+	void squirrel::set_watchdog(std::chrono::milliseconds budget) noexcept
 	{
-		sq_pushobject(impl, *vs_cast(obj));
-
-		sq_pushroottable(impl);
-
-		bool failed{SQ_FAILED(sq_call(impl, 1, SQFalse, SQTrue))};
+		if(budget == watchdog_budget) {
+			return;
+		}
 
-		sq_pop(impl, 1);
+		watchdog_budget = budget;
 
-		if(failed) {
-			return gsdk::SCRIPT_ERROR;
-		} else if(wait) {
-			return gsdk::SCRIPT_DONE;
-		} else {
-			return gsdk::SCRIPT_RUNNING;
+		//line events are needed to interrupt loops that dont call anything
+		if(budget.count() > 0) {
+			debug_vm = true;
+			sq_enabledebuginfo(impl, SQTrue);
 		}
+
+		update_debug_hook();
 	}
 
-	gsdk::HSCRIPT squirrel::CreateScope_impl(const char *name, gsdk::HSCRIPT parent)
+	struct squirrel::scope_watchdog final
 	{
-		sq_pushobject(impl, create_scope_func);
-
-		sq_pushroottable(impl);
-		sq_pushstring(impl, name, -1);
-		if(parent) {
-			sq_pushobject(impl, *vs_cast(parent));
-		} else {
-			sq_pushroottable(impl);
+		inline scope_watchdog(squirrel &vm_) noexcept
+			: vm{vm_}
+		{
+			if(vm.watchdog_depth++ == 0 && vm.watchdog_budget.count() > 0) {
+				vm.watchdog_deadline = std::chrono::steady_clock::now() + vm.watchdog_budget;
+				vm.watchdog_tripped = false;
+			}
+		}
+		inline ~scope_watchdog() noexcept
+		{
+			if(--vm.watchdog_depth == 0) {
+				vm.watchdog_tripped = false;
+			}
 		}
 
-		HSQOBJECT *scope{vs_cast(gsdk::INVALID_HSCRIPT)};
+		squirrel &vm;
+	};
 
-		if(SQ_SUCCEEDED(sq_call(impl, 3, SQTrue, SQTrue))) {
-			scope = new HSQOBJECT;
-			sq_resetobject(scope);
+	struct squirrel::scope_native_vm final
+	{
+		//get/push/throw and anything the binding calls back into work on impl, so point it at the calling thread
+		inline scope_native_vm(squirrel &vm_, HSQUIRRELVM thread) noexcept
+			: vm{vm_}, old{vm_.impl}
+		{ vm.impl = thread; }
+		inline ~scope_native_vm() noexcept
+		{ vm.impl = old; }
 
-			bool got{SQ_SUCCEEDED(sq_getstackobj(impl, -1, scope))};
+		squirrel &vm;
+		HSQUIRRELVM old;
+	};
 
-			if(!got || sq_isnull(*scope)) {
-				sq_release(impl, scope);
-				delete scope;
-				scope = vs_cast(gsdk::INVALID_HSCRIPT);
-			} else {
-				sq_addref(impl, scope);
-			}
+	SQInteger squirrel::coroutine_async(HSQUIRRELVM vm)
+	{
+		squirrel *actual_vm{static_cast<squirrel *>(sq_getforeignptr(vm))};
 
-			sq_pop(impl, 1);
+		SQInteger top{sq_gettop(vm)};
+		if(top < 2) {
+			return sq_throwerror(vm, _SC("wrong number of parameters"));
 		}
 
-		sq_pop(impl, 1);
+		//coroutines started by coroutines belong to the same plugin, whatever their environment is
+		plugin *owner{plugin::assumed_currently_running()};
+		if(actual_vm->running_coroutine != 0) {
+			auto rit{actual_vm->coroutines.find(actual_vm->running_coroutine)};
+			if(rit != actual_vm->coroutines.end()) {
+				owner = rit->second.owner;
+			}
+		}
 
-		return vs_cast(scope);
+		HSQUIRRELVM thread{sq_newthread(vm, 1024)};
+		if(!thread) {
+			return sq_throwerror(vm, _SC("failed to create thread"));
+		}
+
+		HSQOBJECT thread_obj;
+		sq_resetobject(&thread_obj);
+		if(SQ_FAILED(sq_getstackobj(vm, -1, &thread_obj))) {
+			sq_pop(vm, 1);
+			return sq_throwerror(vm, _SC("failed to get thread"));
+		}
+
+		sq_addref(actual_vm->impl, &thread_obj);
+
+		//natives look the vm up through the foreign pointer so threads need it too
+		sq_setforeignptr(thread, actual_vm);
+		actual_vm->apply_debug_hook(thread);
+
+		std::size_t id{++actual_vm->coroutine_ids};
+		actual_vm->coroutines.emplace(id, coroutine_t{thread_obj, thread, owner, 0, false, true, false});
+
+		sq_move(thread, vm, 2);
+		sq_move(thread, vm, 1);
+		for(SQInteger i{3}; i <= top; ++i) {
+			sq_move(thread, vm, i);
+		}
+
+		std::size_t prev_running{actual_vm->running_coroutine};
+		actual_vm->running_coroutine = id;
+
+		bool failed{false};
+		{
+			scope_watchdog swd{*actual_vm};
+			failed = SQ_FAILED(sq_call(thread, top-1, SQFalse, SQTrue));
+			if(actual_vm->watchdog_tripped) {
+				failed = true;
+			}
+		}
+
+		actual_vm->running_coroutine = prev_running;
+
+		actual_vm->settle_coroutine(id, failed);
+
+		//the thread is still on top for scripts wanting to check on it
+		return 1;
 	}
 
-	gsdk::HSCRIPT squirrel::CopyHandle(gsdk::HSCRIPT obj)
+	void squirrel::wait_coroutine_ticks(std::size_t id, std::size_t ticks) noexcept
 	{
-		sq_pushobject(impl, *vs_cast(obj));
+		tick_waits.emplace_back(coroutine_tick + ticks, id);
+		std::push_heap(tick_waits.begin(), tick_waits.end(), std::greater<>{});
+	}
 
-		HSQOBJECT *copy{new HSQOBJECT};
-		sq_resetobject(copy);
+	SQInteger squirrel::coroutine_wait_ticks(HSQUIRRELVM vm)
+	{
+		squirrel *actual_vm{static_cast<squirrel *>(sq_getforeignptr(vm))};
 
-		if(SQ_FAILED(sq_getstackobj(impl, -1, copy))) {
-			sq_release(impl, copy);
-			delete copy;
-			copy = vs_cast(gsdk::INVALID_HSCRIPT);
-		} else {
-			sq_addref(impl, copy);
+		auto it{actual_vm->coroutines.find(actual_vm->running_coroutine)};
+		if(it == actual_vm->coroutines.end() || it->second.vm != vm) {
+			return sq_throwerror(vm, _SC("can only wait inside a coroutine started with Async"));
 		}
 
-		sq_pop(impl, 1);
-		return vs_cast(copy);
+		SQInteger ticks{1};
+		if(sq_gettop(vm) > 1) {
+			if(SQ_FAILED(sq_getinteger(vm, 2, &ticks))) {
+				return sq_throwerror(vm, _SC("failed to get ticks"));
+			}
+		}
+
+		actual_vm->wait_coroutine_ticks(it->first, ticks > 1 ? static_cast<std::size_t>(ticks) : 1);
+		it->second.scheduled = true;
+
+		return sq_suspendvm(vm);
 	}
 
-	gsdk::HSCRIPT squirrel::ReferenceScope_impl(gsdk::HSCRIPT obj)
+	SQInteger squirrel::coroutine_wait_until(HSQUIRRELVM vm)
 	{
-		//TODO!!! l4d2 AI_ResponseParams::ScriptFollowup_t
-		if(!obj || obj == gsdk::INVALID_HSCRIPT) {
-			return gsdk::INVALID_HSCRIPT;
+		squirrel *actual_vm{static_cast<squirrel *>(sq_getforeignptr(vm))};
+
+		auto it{actual_vm->coroutines.find(actual_vm->running_coroutine)};
+		if(it == actual_vm->coroutines.end() || it->second.vm != vm) {
+			return sq_throwerror(vm, _SC("can only wait inside a coroutine started with Async"));
 		}
 
-		//TODO!!!! increment __vrefs ?
+		SQFloat time{0.0f};
+		if(SQ_FAILED(sq_getfloat(vm, 2, &time))) {
+			return sq_throwerror(vm, _SC("failed to get time"));
+		}
 
-		gsdk::HSCRIPT copy{squirrel::CopyHandle(obj)};
-		return copy;
+		//times already passed still wait a tick so a loop cant spin inside run_coroutines
+		if(static_cast<float>(time) <= actual_vm->coroutine_time) {
+			actual_vm->wait_coroutine_ticks(it->first, 1);
+		} else {
+			actual_vm->time_waits.emplace_back(static_cast<float>(time), it->first);
+			std::push_heap(actual_vm->time_waits.begin(), actual_vm->time_waits.end(), std::greater<>{});
+		}
+
+		it->second.scheduled = true;
+
+		return sq_suspendvm(vm);
 	}
 
-	void squirrel::ReleaseScript(gsdk::HSCRIPT obj)
+	SQInteger squirrel::coroutine_wait_future(HSQUIRRELVM vm)
 	{
-		//TEMP!!! for l4d2
-		if(obj == gsdk::INVALID_HSCRIPT) {
-			return;
+		squirrel *actual_vm{static_cast<squirrel *>(sq_getforeignptr(vm))};
+
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, 2, &userptr, typeid_ptr<future_ud_t>()))) {
+			return sq_throwerror(vm, _SC("expected a Future"));
 		}
 
-		sq_release(impl, vs_cast(obj));
-		delete vs_cast(obj);
+		auto fit{actual_vm->futures.find(static_cast<future_ud_t *>(userptr)->id)};
+		if(fit == actual_vm->futures.end()) {
+			return sq_throwerror(vm, _SC("invalid Future"));
+		}
+
+		if(fit->second.resolved) {
+			sq_pushobject(vm, fit->second.value);
+			return 1;
+		}
+
+		auto it{actual_vm->coroutines.find(actual_vm->running_coroutine)};
+		if(it == actual_vm->coroutines.end() || it->second.vm != vm) {
+			return sq_throwerror(vm, _SC("can only wait inside a coroutine started with Async"));
+		}
+
+		fit->second.waiters.emplace_back(it->first);
+		it->second.future = fit->first;
+		it->second.scheduled = true;
+
+		return sq_suspendvm(vm);
 	}
 
-	void squirrel::ReleaseFunction(gsdk::HSCRIPT obj)
+	void squirrel::resume_coroutine(std::size_t id) noexcept
 	{
-		//TODO!!! CDirector::PostRunScript gives invalid function find out why
-		if(obj == gsdk::INVALID_HSCRIPT) {
+		auto it{coroutines.find(id)};
+		if(it == coroutines.end() || it->second.cancelled) {
 			return;
 		}
 
-		sq_release(impl, vs_cast(obj));
-		delete vs_cast(obj);
+		HSQUIRRELVM thread{it->second.vm};
+
+		if(sq_getvmstate(thread) != SQ_VMSTATE_SUSPENDED) {
+			settle_coroutine(id, true);
+			return;
+		}
+
+		//a resolved future becomes the return value of WaitFuture
+		SQBool has_value{SQFalse};
+		if(it->second.future != 0) {
+			auto fit{futures.find(it->second.future)};
+			if(fit != futures.end() && fit->second.resolved) {
+				sq_pushobject(thread, fit->second.value);
+				has_value = SQTrue;
+			}
+			it->second.future = 0;
+		}
+
+		it->second.scheduled = false;
+		it->second.running = true;
+
+		std::size_t prev_running{running_coroutine};
+		running_coroutine = id;
+
+		apply_debug_hook(thread);
+
+		bool failed{false};
+		{
+			//bindings called from the coroutine attribute their work to the plugin that started it
+			plugin::scope_assume_current sac{it->second.owner};
+			scope_watchdog swd{*this};
+			failed = SQ_FAILED(sq_wakeupvm(thread, has_value, SQFalse, SQTrue, SQFalse));
+			if(watchdog_tripped) {
+				failed = true;
+			}
+		}
+
+		running_coroutine = prev_running;
+
+		settle_coroutine(id, failed);
 	}
 
-	void squirrel::ReleaseScope(gsdk::HSCRIPT obj)
+	void squirrel::settle_coroutine(std::size_t id, bool failed) noexcept
 	{
-		//TODO!!! l4d2 AI_ResponseParams::ScriptFollowup_t
-		if(obj == gsdk::INVALID_HSCRIPT) {
+		auto it{coroutines.find(id)};
+		if(it == coroutines.end()) {
 			return;
 		}
 
-	#if GSDK_ENGINE == GSDK_ENGINE_L4D2
-		//TODO!!!! CDirector::TermScripts is calling this on a table instead of a scope investigate why
+		it->second.running = false;
 
-		sq_pushobject(impl, *vs_cast(obj));
-		sq_pushstring(impl, _SC("__vrefs"), 7);
+		if(!failed && !it->second.cancelled && sq_getvmstate(it->second.vm) == SQ_VMSTATE_SUSPENDED) {
+			//a plain suspend() didnt ask for anything so just come back next tick
+			if(!it->second.scheduled) {
+				wait_coroutine_ticks(id, 1);
+				it->second.scheduled = true;
+			}
+			return;
+		}
 
-		bool got{SQ_SUCCEEDED(sq_get(impl, -2))};
-		if(got) {
-			sq_pop(impl, 1);
+		sq_release(impl, &it->second.thread);
+		coroutines.erase(it);
+	}
+
+	void squirrel::run_coroutines(float curtime) noexcept
+	{
+		++coroutine_tick;
+		coroutine_time = curtime;
+
+		if(!ready_coroutines.empty()) {
+			std::swap(ready_coroutines, ready_coroutines_swap);
+			for(std::size_t id : ready_coroutines_swap) {
+				resume_coroutine(id);
+			}
+			ready_coroutines_swap.clear();
 		}
 
-		sq_pop(impl, 1);
+		while(!tick_waits.empty() && tick_waits.front().first <= coroutine_tick) {
+			std::pop_heap(tick_waits.begin(), tick_waits.end(), std::greater<>{});
+			std::size_t id{tick_waits.back().second};
+			tick_waits.pop_back();
+			resume_coroutine(id);
+		}
 
-		if(!got) {
-			sq_release(impl, vs_cast(obj));
-			delete vs_cast(obj);
+		while(!time_waits.empty() && time_waits.front().first <= curtime) {
+			std::pop_heap(time_waits.begin(), time_waits.end(), std::greater<>{});
+			std::size_t id{time_waits.back().second};
+			time_waits.pop_back();
+			resume_coroutine(id);
+		}
+	}
+
+	void squirrel::cancel_coroutines(const plugin *owner) noexcept
+	{
+		if(!owner) {
 			return;
 		}
-	#endif
 
-		sq_pushobject(impl, release_scope_func);
+		//queued waits of dropped coroutines are skipped once they come up
+		for(auto it{coroutines.begin()}; it != coroutines.end();) {
+			if(it->second.owner != owner) {
+				++it;
+				continue;
+			}
 
-		sq_pushroottable(impl);
-		sq_pushobject(impl, *vs_cast(obj));
+			if(it->second.running) {
+				it->second.cancelled = true;
+				++it;
+				continue;
+			}
 
-		if(SQ_SUCCEEDED(sq_call(impl, 2, SQFalse, SQTrue))) {
-			sq_release(impl, vs_cast(obj));
-			delete vs_cast(obj);
+			sq_release(impl, &it->second.thread);
+			it = coroutines.erase(it);
 		}
+	}
 
-		sq_pop(impl, 1);
+	SQInteger squirrel::future_ctor(HSQUIRRELVM vm)
+	{
+		squirrel *actual_vm{static_cast<squirrel *>(sq_getforeignptr(vm))};
+
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, 1, &userptr, typeid_ptr<future_ud_t>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		std::size_t id{++actual_vm->future_ids};
+
+		future_t future{};
+		sq_resetobject(&future.value);
+		actual_vm->futures.emplace(id, std::move(future));
+
+		new (userptr) future_ud_t{actual_vm, id};
+
+		sq_setreleasehook(vm, 1, future_release);
+
+		return 0;
 	}
 
-	void squirrel::ReleaseValue(gsdk::ScriptVariant_t &value)
+	SQInteger squirrel::future_release(SQUserPointer userptr, SQInteger size)
 	{
-		if(value.m_flags & gsdk::SV_FREE) {
-			switch(value.m_type) {
-				case gsdk::FIELD_VOID:
-				break;
-				case gsdk::FIELD_TYPEUNKNOWN:
-				break;
-				case gsdk::FIELD_POSITION_VECTOR:
-				case gsdk::FIELD_VECTOR:
-				delete value.m_vector;
-				break;
-				case gsdk::FIELD_VECTOR2D:
-				//delete m_vector2d;
-				break;
-				case gsdk::FIELD_QANGLE:
-				delete value.m_qangle;
-				break;
-				case gsdk::FIELD_QUATERNION:
-				//delete value.m_quaternion;
-				break;
-				case gsdk::FIELD_UTLSTRINGTOKEN:
-				//delete value.m_utlstringtoken;
-				break;
-				case gsdk::FIELD_CSTRING:
-				gsdk::free_arr<char>(value.m_cstr);
-				break;
-				case gsdk::FIELD_HSCRIPT_NEW_INSTANCE:
-				case gsdk::FIELD_HSCRIPT:
-				case gsdk::FIELD_CUSTOM:
-				case gsdk::FIELD_FUNCTION:
-				case gsdk::FIELD_EMBEDDED:
-				sq_release(impl, vs_cast(value.m_object));
-				delete vs_cast(value.m_object);
-				break;
-				default:
-				gsdk::free<void>(static_cast<void *>(value.m_data));
-				break;
+		if(static_cast<std::size_t>(size) != sizeof(future_ud_t)) {
+			return SQ_ERROR;
+		}
+
+		future_ud_t *ud{static_cast<future_ud_t *>(userptr)};
+
+		auto it{ud->vm->futures.find(ud->id)};
+		if(it != ud->vm->futures.end()) {
+			if(it->second.resolved) {
+				sq_release(ud->vm->impl, &it->second.value);
 			}
+			ud->vm->futures.erase(it);
 		}
 
-		value.m_flags = gsdk::SV_NOFLAGS;
-		std::memset(value.m_data, 0, sizeof(gsdk::ScriptVariant_t::m_data));
-		value.m_object = gsdk::INVALID_HSCRIPT;
-		value.m_type = gsdk::FIELD_TYPEUNKNOWN;
+		ud->~future_ud_t();
+
+		return 0;
 	}
 
-	gsdk::HSCRIPT squirrel::LookupFunction_impl(const char *name, gsdk::HSCRIPT scope)
+	bool squirrel::resolve_future(std::size_t id, const HSQOBJECT &value) noexcept
 	{
-		if(scope) {
-			sq_pushobject(impl, *vs_cast(scope));
-		} else {
-			sq_pushroottable(impl);
+		auto it{futures.find(id)};
+		if(it == futures.end() || it->second.resolved) {
+			return false;
 		}
 
-		HSQOBJECT *copy{vs_cast(gsdk::INVALID_HSCRIPT)};
+		it->second.value = value;
+		sq_addref(impl, &it->second.value);
+		it->second.resolved = true;
 
-		sq_pushstring(impl, name, -1);
-		if(SQ_SUCCEEDED(sq_get(impl, -2))) {
-			copy = new HSQOBJECT;
-			sq_resetobject(copy);
+		ready_coroutines.insert(ready_coroutines.end(), it->second.waiters.begin(), it->second.waiters.end());
+		it->second.waiters.clear();
 
-			if(SQ_FAILED(sq_getstackobj(impl, -1, copy))) {
-				sq_release(impl, copy);
-				delete copy;
-				copy = vs_cast(gsdk::INVALID_HSCRIPT);
-			} else {
-				sq_addref(impl, copy);
-			}
+		return true;
+	}
+
+	bool squirrel::resolve_future(std::size_t id, const gsdk::ScriptVariant_t &value) noexcept
+	{
+		if(!push(value)) {
+			return false;
+		}
 
+		HSQOBJECT obj;
+		sq_resetobject(&obj);
+		if(SQ_FAILED(sq_getstackobj(impl, -1, &obj))) {
 			sq_pop(impl, 1);
+			return false;
 		}
 
+		bool resolved{resolve_future(id, obj)};
+
 		sq_pop(impl, 1);
 
-		return vs_cast(copy);
+		return resolved;
 	}
 
-	bool squirrel::push(const gsdk::ScriptVariant_t &var) noexcept
+	std::size_t squirrel::create_future(gsdk::ScriptVariant_t &var) noexcept
 	{
-		switch(var.m_type) {
-			case gsdk::FIELD_VOID: {
-				sq_pushnull(impl);
-				return true;
-			}
-			case gsdk::FIELD_TIME:
-			case gsdk::FIELD_FLOAT: {
-				sq_pushfloat(impl, var.m_float);
-				return true;
-			}
-			case gsdk::FIELD_FLOAT64: {
-			#if GSDK_ENGINE == GSDK_ENGINE_TF2 || GSDK_ENGINE == GSDK_ENGINE_L4D2
-				sq_pushfloat(impl, static_cast<float>(var.m_double));
-			#elif GSDK_CHECK_BRANCH_VER(GSDK_ENGINE_BRANCH_2010, >=, GSDK_ENGINE_BRANCH_2010_V0)
-				sq_pushfloat(impl, var.m_float);
-			#else
-				#error
-			#endif
-				return true;
-			}
-			case gsdk::FIELD_STRING: {
-				const char *ccstr{gsdk::vscript::STRING(var.m_tstr)};
+		if(!future_registered) {
+			return 0;
+		}
 
-				sq_pushstring(impl, ccstr, -1);
-				return true;
-			}
-			case gsdk::FIELD_MODELNAME:
-			case gsdk::FIELD_SOUNDNAME:
-			case gsdk::FIELD_CSTRING: {
-				sq_pushstring(impl, var.m_ccstr, -1);
-				return true;
-			}
-			case gsdk::FIELD_CHARACTER: {
-				char buff[2]{var.m_char, '\0'};
-				sq_pushstring(impl, buff, 1);
-				return true;
-			}
-			case gsdk::FIELD_SHORT: {
-				sq_pushinteger(impl, var.m_short);
-				return true;
-			}
-			case gsdk::FIELD_POSITIVEINTEGER_OR_NULL: {
-			#if GSDK_ENGINE == GSDK_ENGINE_TF2 || GSDK_ENGINE == GSDK_ENGINE_L4D2
+		sq_pushobject(impl, future_class);
+		sq_pushroottable(impl);
+		if(SQ_FAILED(sq_call(impl, 1, SQTrue, SQTrue))) {
+			sq_pop(impl, 1);
+			return 0;
+		}
+
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(impl, -1, &userptr, typeid_ptr<future_ud_t>())) || !get(-1, var)) {
+			sq_pop(impl, 2);
+			return 0;
+		}
+
+		std::size_t id{static_cast<future_ud_t *>(userptr)->id};
+
+		sq_pop(impl, 2);
+
+		return id;
+	}
+
+	SQInteger squirrel::future_resolve(HSQUIRRELVM vm)
+	{
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, 1, &userptr, typeid_ptr<future_ud_t>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		HSQOBJECT value;
+		sq_resetobject(&value);
+		if(sq_gettop(vm) > 1) {
+			if(SQ_FAILED(sq_getstackobj(vm, 2, &value))) {
+				return sq_throwerror(vm, _SC("failed to get value"));
+			}
+		}
+
+		future_ud_t *ud{static_cast<future_ud_t *>(userptr)};
+		if(!ud->vm->resolve_future(ud->id, value)) {
+			return sq_throwerror(vm, _SC("Future was already resolved"));
+		}
+
+		return 0;
+	}
+
+	SQInteger squirrel::future_is_resolved(HSQUIRRELVM vm)
+	{
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, 1, &userptr, typeid_ptr<future_ud_t>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		future_ud_t *ud{static_cast<future_ud_t *>(userptr)};
+
+		auto it{ud->vm->futures.find(ud->id)};
+		sq_pushbool(vm, (it != ud->vm->futures.end() && it->second.resolved) ? SQTrue : SQFalse);
+		return 1;
+	}
+
+	SQInteger squirrel::future_value(HSQUIRRELVM vm)
+	{
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(vm, 1, &userptr, typeid_ptr<future_ud_t>()))) {
+			return sq_throwerror(vm, _SC("failed to get userptr"));
+		}
+
+		future_ud_t *ud{static_cast<future_ud_t *>(userptr)};
+
+		auto it{ud->vm->futures.find(ud->id)};
+		if(it != ud->vm->futures.end() && it->second.resolved) {
+			sq_pushobject(vm, it->second.value);
+		} else {
+			sq_pushnull(vm);
+		}
+		return 1;
+	}
+
+	void squirrel::take_profile_sample(HSQUIRRELVM vm) noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		profile_t &prof{*profile};
+
+		auto append_frame{
+			[](std::string &str, const SQStackInfos &si) noexcept -> void {
+				str += (si.funcname ? si.funcname : _SC("unknown"));
+				str += '@';
+
+				std::string_view source{si.source ? si.source : _SC("NATIVE")};
+				std::size_t slash{source.rfind('/')};
+				if(slash != std::string_view::npos) {
+					source.remove_prefix(slash+1);
+				}
+				str += source;
+			}
+		};
+
+		SQStackInfos frames[64];
+		std::size_t num_frames{0};
+
+		for(SQInteger level{0}; num_frames < std::size(frames); ++level) {
+			if(SQ_FAILED(sq_stackinfos(vm, level, &frames[num_frames]))) {
+				break;
+			}
+
+			++num_frames;
+		}
+
+		if(num_frames == 0) {
+			return;
+		}
+
+		std::string &stack{prof.stack_buffer};
+		stack.clear();
+
+		for(std::size_t i{num_frames}; i > 0; --i) {
+			append_frame(stack, frames[i-1]);
+			if(i > 1) {
+				stack += ';';
+			}
+		}
+
+		++prof.stacks[stack];
+
+		stack.clear();
+		append_frame(stack, frames[0]);
+		stack += ':';
+
+		char line_buffer[24];
+		std::to_chars_result tc_res{std::to_chars(std::begin(line_buffer), std::end(line_buffer), frames[0].line)};
+		stack.append(line_buffer, tc_res.ptr);
+
+		++prof.lines[stack];
+
+		++prof.samples;
+	}
+
+	bool squirrel::start_profiling(std::chrono::microseconds interval) noexcept
+	{
+		if(hook_owner && hook_owner != this) {
+			return false;
+		}
+
+		profile.reset(new profile_t);
+		profile->interval = interval;
+		profile->next_sample = std::chrono::steady_clock::now();
+
+		profiling_ = true;
+		update_debug_hook();
+
+		return true;
+	}
+
+	void squirrel::stop_profiling() noexcept
+	{
+		if(!profiling_) {
+			return;
+		}
+
+		profiling_ = false;
+		update_debug_hook();
+	}
+
+	bool squirrel::write_profile_collapsed(const std::filesystem::path &path) const noexcept
+	{
+		if(!profile) {
+			return false;
+		}
+
+		std::string data;
+
+		for(const auto &it : profile->stacks) {
+			data += it.first;
+			data += ' ';
+
+			char count_buffer[24];
+			std::to_chars_result tc_res{std::to_chars(std::begin(count_buffer), std::end(count_buffer), it.second)};
+			data.append(count_buffer, tc_res.ptr);
+
+			data += '\n';
+		}
+
+		write_file(path, reinterpret_cast<const unsigned char *>(data.c_str()), data.length());
+
+		return true;
+	}
+
+	void squirrel::print_profile_top(std::size_t num) const noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		if(!profile || profile->samples == 0) {
+			info("vmod vm: no profile samples\n"sv);
+			return;
+		}
+
+		std::vector<std::pair<std::string_view, std::size_t>> sorted;
+		sorted.reserve(profile->lines.size());
+		for(const auto &it : profile->lines) {
+			sorted.emplace_back(it.first, it.second);
+		}
+
+		num = std::min(num, sorted.size());
+
+		std::partial_sort(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(num), sorted.end(),
+			[](const auto &lhs, const auto &rhs) noexcept -> bool {
+				return lhs.second > rhs.second;
+			}
+		);
+
+		double total{static_cast<double>(profile->samples)};
+		double sample_ms{std::chrono::duration<double, std::milli>{profile->interval}.count()};
+
+		info("vmod vm: %zu samples every %lldus\n"sv, profile->samples, static_cast<long long>(profile->interval.count()));
+		info("vmod vm:  samples      %%     ~ms  location\n"sv);
+
+		for(std::size_t i{0}; i < num; ++i) {
+			const auto &it{sorted[i]};
+			double count{static_cast<double>(it.second)};
+			info("vmod vm: %8zu %6.2f %7.1f  %.*s\n"sv, it.second, (count / total) * 100.0, count * sample_ms, static_cast<int>(it.first.length()), it.first.data());
+		}
+	}
+
+	namespace detail
+	{
+		static int bench_getter() noexcept
+		{ return 1; }
+	}
+
+	bool squirrel::benchmark_bindings(std::size_t iterations) noexcept
+	{
+		using namespace std::literals::string_literals;
+		using namespace std::literals::string_view_literals;
+
+		static vscript::function_desc bench_desc;
+
+		if(registered_funcs.find("__vmod_bench_getter"s) == registered_funcs.end()) {
+			bench_desc.initialize(detail::bench_getter, "bench_getter"sv, "__vmod_bench_getter"sv);
+			RegisterFunction_nonvirtual(&bench_desc);
+		}
+
+		constexpr std::string_view bench_code{
+			"local n = vargv[0]; local t = 0; for(local i = 0; i < n; ++i) { t += __vmod_bench_getter(); } return t;"sv
+		};
+
+		if(SQ_FAILED(sq_compilebuffer(impl, bench_code.data(), static_cast<SQInteger>(bench_code.length()), _SC("vmod_bench_bindings"), SQFalse))) {
+			error("vmod vm: failed to compile binding benchmark\n"sv);
+			return false;
+		}
+
+		const bool old_direct{direct_bindings};
+
+		auto run{
+			[this, iterations](bool direct) noexcept -> std::chrono::nanoseconds {
+				direct_bindings = direct;
+
+				sq_push(impl, -1);
+				sq_pushroottable(impl);
+				sq_pushinteger(impl, static_cast<SQInteger>(iterations));
+
+				auto start{std::chrono::steady_clock::now()};
+				SQRESULT res{sq_call(impl, 2, SQFalse, SQTrue)};
+				auto end{std::chrono::steady_clock::now()};
+
+				sq_pop(impl, 1);
+
+				if(SQ_FAILED(res)) {
+					return std::chrono::nanoseconds{-1};
+				}
+
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+			}
+		};
+
+		std::chrono::nanoseconds variant_time{run(false)};
+		std::chrono::nanoseconds direct_time{run(true)};
+
+		direct_bindings = old_direct;
+
+		sq_pop(impl, 1);
+
+		if(variant_time.count() < 0 || direct_time.count() < 0) {
+			error("vmod vm: binding benchmark failed\n"sv);
+			return false;
+		}
+
+		double calls{static_cast<double>(iterations)};
+		double variant_ns{static_cast<double>(variant_time.count())};
+		double direct_ns{static_cast<double>(direct_time.count())};
+
+		info("vmod vm: %zu calls to a trivial getter\n"sv, iterations);
+		info("vmod vm:   variant path %10.3fms %8.1fns/call\n"sv, variant_ns / 1000000.0, variant_ns / calls);
+		info("vmod vm:   direct path  %10.3fms %8.1fns/call\n"sv, direct_ns / 1000000.0, direct_ns / calls);
+		if(direct_ns > 0.0) {
+			info("vmod vm:   %.2fx faster\n"sv, variant_ns / direct_ns);
+		}
+
+		return true;
+	}
+
+	bool squirrel::Frame(float frametime)
+	{
+		auto now{std::chrono::steady_clock::now()};
+		std::chrono::nanoseconds delta{now - gc_last_frame};
+		gc_last_frame = now;
+
+		if(gc_budget.count() <= 0 || gc_interval <= 0.0f || frametime <= 0.0f) {
+			gc_on_time_frames = 0;
+			return true;
+		}
+
+		//ticks arriving on schedule mean the server finished early and slept, late ones mean there is no slack
+		std::chrono::nanoseconds tick{std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<float>{frametime})};
+		if(delta <= (tick + (tick / 20))) {
+			++gc_on_time_frames;
+		} else {
+			gc_on_time_frames = 0;
+		}
+
+		gc_elapsed += frametime;
+		if(gc_elapsed < gc_interval) {
+			return true;
+		}
+
+		//cycle collection cant be split, it only runs when it fits both the budget and the tick
+		//a busy server defers it indefinitely, which is no worse than never collecting from here
+		std::chrono::nanoseconds estimate{gc_estimate()};
+		if(estimate.count() > 0 && estimate <= gc_budget && estimate < tick && gc_on_time_frames >= detail::gc_min_on_time_frames) {
+			collect_garbage(false);
+		} else {
+			++gc_stats_.deferred;
+		}
+
+		return true;
+	}
+
+	gsdk::ScriptStatus_t squirrel::Run(const char *code, bool wait)
+	{
+		if(SQ_FAILED(sq_compilebuffer(impl, code, static_cast<SQInteger>(std::strlen(code)), "<<unnamed>>", SQTrue))) {
+			return gsdk::SCRIPT_ERROR;
+		}
+
+		sq_pushroottable(impl);
+
+		bool failed{SQ_FAILED(sq_call(impl, 1, SQFalse, SQTrue))};
+
+		sq_pop(impl, 1);
+
+		if(failed) {
+			return gsdk::SCRIPT_ERROR;
+		} else if(wait) {
+			return gsdk::SCRIPT_DONE;
+		} else {
+			return gsdk::SCRIPT_RUNNING;
+		}
+	}
+
+	gsdk::ScriptHandleWrapper_t squirrel::CompileScript_strict(const char *code, const char *name) noexcept
+	{
+		if(!name || name[0] == '\0') {
+			name = "<<unnamed>>";
+		}
+
+		if(SQ_FAILED(sq_compilebuffer_strict(impl, code, static_cast<SQInteger>(std::strlen(code)), name, USQTrue))) {
+			return gsdk::ScriptHandleWrapper_t{};
+		}
+
+		gsdk::ScriptHandleWrapper_t tmp;
+		tmp.object = compile_script();
+		tmp.should_free_ = true;
+
+		return tmp;
+	}
+
+	gsdk::HSCRIPT squirrel::CompileScript_impl(const char *code, const char *name)
+	{
+		if(!name || name[0] == '\0') {
+			name = "<<unnamed>>";
+		}
+
+		if(SQ_FAILED(sq_compilebuffer(impl, code, static_cast<SQInteger>(std::strlen(code)), name, SQTrue))) {
+			return gsdk::INVALID_HSCRIPT;
+		}
+
+		return compile_script();
+	}
+
+	namespace detail
+	{
+		//bump when anything that affects serialized closures changes without a squirrel version change
+		static constexpr std::uint64_t bytecode_cache_version{2};
+
+		//consts is the const table hash, const and enum values are folded into the closures
+		static std::uint64_t bytecode_cache_seed(std::string_view name, bool debug_info, std::uint64_t consts) noexcept
+		{
+			std::string_view sq_build_id{SQUIRREL_VERSION};
+			std::string_view vmod_build_id{__VMOD_BUILD_ID};
+
+			std::uint64_t id[]{
+				bytecode_cache_version,
+				XXH3_64bits(sq_build_id.data(), sq_build_id.size()),
+				XXH3_64bits(vmod_build_id.data(), vmod_build_id.size()),
+				consts,
+				static_cast<std::uint64_t>(GSDK_ENGINE),
+				sizeof(SQInteger),
+				sizeof(SQFloat),
+				sizeof(SQChar),
+				sizeof(void *),
+				debug_info ? 1u : 0u
+			};
+
+			//closures keep their source name so it must be part of the key
+			return XXH3_64bits_withSeed(id, sizeof(id), XXH3_64bits(name.data(), name.size()));
+		}
+
+		static SQInteger bytecode_write(SQUserPointer up, SQUserPointer data, SQInteger size)
+		{
+			std::vector<unsigned char> &buffer{*static_cast<std::vector<unsigned char> *>(up)};
+
+			const unsigned char *begin{static_cast<const unsigned char *>(data)};
+			buffer.insert(buffer.end(), begin, begin + size);
+
+			return size;
+		}
+
+		struct bytecode_reader_t final
+		{
+			const unsigned char *data;
+			std::size_t size;
+			std::size_t pos;
+		};
+
+		static SQInteger bytecode_read(SQUserPointer up, SQUserPointer dest, SQInteger size)
+		{
+			bytecode_reader_t &reader{*static_cast<bytecode_reader_t *>(up)};
+
+			std::size_t len{static_cast<std::size_t>(size)};
+			if(len > (reader.size - reader.pos)) {
+				return -1;
+			}
+
+			std::memcpy(dest, reader.data + reader.pos, len);
+			reader.pos += len;
+
+			return size;
+		}
+
+		static std::filesystem::path bytecode_cache_path(const std::filesystem::path &cache_dir, const char *code, std::size_t len, std::string_view name, bool debug_info, std::uint64_t consts) noexcept
+		{
+			using namespace std::literals::string_view_literals;
+
+			std::uint64_t key{XXH3_64bits_withSeed(code, len, bytecode_cache_seed(name, debug_info, consts))};
+
+			char key_buffer[17];
+
+			char *begin{key_buffer};
+			char *end{begin + sizeof(key_buffer)};
+
+			std::to_chars_result tc_res{std::to_chars(begin, end, key, 16)};
+			tc_res.ptr[0] = '\0';
+
+			std::filesystem::path cache_path{cache_dir};
+			cache_path /= begin;
+			cache_path += ".cnut"sv;
+
+			return cache_path;
+		}
+	}
+
+	namespace detail
+	{
+		//entries are summed so the result doesn't depend on iteration order
+		static std::uint64_t hash_const_entries(HSQUIRRELVM vm, bool nested) noexcept
+		{
+			std::uint64_t hash{0};
+
+			sq_pushnull(vm);
+			while(SQ_SUCCEEDED(sq_next(vm, -2))) {
+				SQObjectType type{sq_gettype(vm, -1)};
+				std::uint64_t value_hash{static_cast<std::uint64_t>(type)};
+
+				switch(type) {
+					case OT_INTEGER: {
+						SQInteger value{0};
+						sq_getinteger(vm, -1, &value);
+						value_hash = XXH3_64bits_withSeed(&value, sizeof(value), value_hash);
+					} break;
+					case OT_FLOAT: {
+						SQFloat value{0};
+						sq_getfloat(vm, -1, &value);
+						value_hash = XXH3_64bits_withSeed(&value, sizeof(value), value_hash);
+					} break;
+					case OT_BOOL: {
+						SQBool value{SQFalse};
+						sq_getbool(vm, -1, &value);
+						value_hash = XXH3_64bits_withSeed(&value, sizeof(value), value_hash);
+					} break;
+					case OT_STRING: {
+						const SQChar *value{nullptr};
+						SQInteger len{0};
+						if(SQ_SUCCEEDED(sq_getstringandsize(vm, -1, &value, &len))) {
+							value_hash = XXH3_64bits_withSeed(value, static_cast<std::size_t>(len) * sizeof(SQChar), value_hash);
+						}
+					} break;
+					case OT_TABLE: {
+						//enums are the only nesting the const table has
+						if(!nested) {
+							value_hash += hash_const_entries(vm, true);
+						}
+					} break;
+					default:
+					break;
+				}
+
+				const SQChar *name{nullptr};
+				SQInteger len{0};
+				if(sq_gettype(vm, -2) == OT_STRING && SQ_SUCCEEDED(sq_getstringandsize(vm, -2, &name, &len))) {
+					hash += XXH3_64bits_withSeed(name, static_cast<std::size_t>(len) * sizeof(SQChar), value_hash);
+				}
+
+				sq_pop(vm, 2);
+			}
+			sq_pop(vm, 1);
+
+			return hash;
+		}
+	}
+
+	std::uint64_t squirrel::const_table_hash() noexcept
+	{
+		sq_pushconsttable(impl);
+		std::uint64_t hash{detail::hash_const_entries(impl, false)};
+		sq_pop(impl, 1);
+
+		return hash;
+	}
+
+	gsdk::HSCRIPT squirrel::CompileScript_cached(const char *code, std::size_t len, const char *name, const std::filesystem::path &cache_dir) noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		if(!name || name[0] == '\0') {
+			name = "<<unnamed>>";
+		}
+
+		std::filesystem::path cache_path;
+
+		if(!cache_dir.empty()) {
+			cache_path = detail::bytecode_cache_path(cache_dir, code, len, name, debug_vm, const_table_hash());
+
+			std::error_code ec;
+			if(std::filesystem::exists(cache_path, ec)) {
+				std::size_t size{0};
+				std::unique_ptr<unsigned char[]> data{read_file(cache_path, size)};
+				if(data) {
+					detail::bytecode_reader_t reader{data.get(), size, 0};
+					if(SQ_SUCCEEDED(sq_readclosure(impl, detail::bytecode_read, &reader))) {
+						++bytecode_stats.hits;
+						return compile_script();
+					}
+				}
+
+				warning("vmod vm: discarding unreadable bytecode cache '%s'\n"sv, cache_path.c_str());
+				std::filesystem::remove(cache_path, ec);
+			}
+
+			++bytecode_stats.misses;
+		}
+
+		if(SQ_FAILED(sq_compilebuffer(impl, code, static_cast<SQInteger>(len), name, SQTrue))) {
+			return gsdk::INVALID_HSCRIPT;
+		}
+
+		if(!cache_path.empty()) {
+			std::vector<unsigned char> buffer;
+			if(SQ_SUCCEEDED(sq_writeclosure(impl, detail::bytecode_write, &buffer))) {
+				std::error_code ec;
+				std::filesystem::create_directories(cache_dir, ec);
+
+				write_file(cache_path, buffer.data(), buffer.size());
+			}
+		}
+
+		return compile_script();
+	}
+
+	void squirrel::compile_print_func(HSQUIRRELVM vm, const SQChar *fmt, ...)
+	{
+		compile_job_t *job{static_cast<compile_job_t *>(sq_getforeignptr(vm))};
+		if(!job) {
+			return;
+		}
+
+		//print_buff/err_buff belong to the main thread
+		char buffer[gsdk::MAXPRINTMSG];
+
+		va_list vargs;
+		va_start(vargs, fmt);
+	#ifdef __clang__
+		#pragma clang diagnostic push
+		#pragma clang diagnostic ignored "-Wformat-nonliteral"
+	#endif
+		std::vsnprintf(buffer, sizeof(buffer), fmt, vargs);
+	#ifdef __clang__
+		#pragma clang diagnostic pop
+	#endif
+		va_end(vargs);
+
+		job->errors += buffer;
+	}
+
+#ifdef __VMOD_USING_QUIRREL
+	void squirrel::compile_worker_err_func(HSQUIRRELVM vm, const SQChar *desc, const SQChar *src, SQInteger line, SQInteger column, const SQChar *extra)
+	{
+		if(extra && extra[0] != '\0') {
+			compile_print_func(vm, "%s:%lli:%lli - %s - %s\n", src, static_cast<long long>(line), static_cast<long long>(column), desc, extra);
+		} else {
+			compile_print_func(vm, "%s:%lli:%lli - %s\n", src, static_cast<long long>(line), static_cast<long long>(column), desc);
+		}
+	}
+#endif
+
+	namespace detail
+	{
+		static bool snapshot_const(HSQUIRRELVM vm, std::string &name, SQObjectType &type, SQInteger &int_value, SQFloat &float_value, std::string &str_value) noexcept
+		{
+			const SQChar *str{nullptr};
+			SQInteger len{0};
+
+			if(sq_gettype(vm, -2) != OT_STRING || SQ_FAILED(sq_getstringandsize(vm, -2, &str, &len))) {
+				return false;
+			}
+
+			name.assign(str, static_cast<std::size_t>(len));
+
+			type = sq_gettype(vm, -1);
+			switch(type) {
+				case OT_INTEGER:
+				return SQ_SUCCEEDED(sq_getinteger(vm, -1, &int_value));
+				case OT_FLOAT:
+				return SQ_SUCCEEDED(sq_getfloat(vm, -1, &float_value));
+				case OT_BOOL: {
+					SQBool value{SQFalse};
+					if(SQ_FAILED(sq_getbool(vm, -1, &value))) {
+						return false;
+					}
+					int_value = value ? 1 : 0;
+					return true;
+				}
+				case OT_STRING:
+				if(SQ_FAILED(sq_getstringandsize(vm, -1, &str, &len))) {
+					return false;
+				}
+				str_value.assign(str, static_cast<std::size_t>(len));
+				return true;
+				case OT_TABLE:
+				return true;
+				default:
+				return false;
+			}
+		}
+	}
+
+	void squirrel::snapshot_consts(std::vector<compile_const_t> &consts) noexcept
+	{
+		sq_pushconsttable(impl);
+
+		sq_pushnull(impl);
+		while(SQ_SUCCEEDED(sq_next(impl, -2))) {
+			compile_const_t cnst;
+			if(detail::snapshot_const(impl, cnst.name, cnst.type, cnst.int_value, cnst.float_value, cnst.str_value)) {
+				//enums are the only nesting the const table has
+				if(cnst.type == OT_TABLE) {
+					sq_pushnull(impl);
+					while(SQ_SUCCEEDED(sq_next(impl, -2))) {
+						compile_const_t member;
+						if(detail::snapshot_const(impl, member.name, member.type, member.int_value, member.float_value, member.str_value) && member.type != OT_TABLE) {
+							cnst.members.emplace_back(std::move(member));
+						}
+						sq_pop(impl, 2);
+					}
+					sq_pop(impl, 1);
+				}
+
+				consts.emplace_back(std::move(cnst));
+			}
+			sq_pop(impl, 2);
+		}
+		sq_pop(impl, 2);
+	}
+
+	namespace detail
+	{
+		template <typename T>
+		static void push_const(HSQUIRRELVM vm, const T &cnst) noexcept
+		{
+			sq_pushstring(vm, cnst.name.c_str(), static_cast<SQInteger>(cnst.name.length()));
+
+			switch(cnst.type) {
+				case OT_INTEGER:
+				sq_pushinteger(vm, cnst.int_value);
+				break;
+				case OT_FLOAT:
+				sq_pushfloat(vm, cnst.float_value);
+				break;
+				case OT_BOOL:
+				sq_pushbool(vm, cnst.int_value ? SQTrue : SQFalse);
+				break;
+				case OT_STRING:
+				sq_pushstring(vm, cnst.str_value.c_str(), static_cast<SQInteger>(cnst.str_value.length()));
+				break;
+				case OT_TABLE:
+				sq_newtable(vm);
+				for(const T &member : cnst.members) {
+					push_const(vm, member);
+				}
+				break;
+				default:
+				sq_pushnull(vm);
+				break;
+			}
+
+			sq_newslot(vm, -3, SQFalse);
+		}
+	}
+
+	void squirrel::run_compile_job(HSQUIRRELVM vm, compile_job_t &job) noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		if(!job.cache_path.empty()) {
+			std::error_code ec;
+			if(std::filesystem::exists(job.cache_path, ec)) {
+				std::size_t size{0};
+				std::unique_ptr<unsigned char[]> data{read_file(job.cache_path, size)};
+				if(data) {
+					job.bytecode.assign(data.get(), data.get() + size);
+					job.from_cache = true;
+					return;
+				}
+			}
+		}
+
+		sq_setforeignptr(vm, &job);
+
+		sq_enabledebuginfo(vm, job.debug_info ? SQTrue : SQFalse);
+	#ifdef __VMOD_USING_QUIRREL
+		sq_lineinfo_in_expressions(vm, job.debug_info ? SQTrue : SQFalse);
+	#endif
+
+		sq_newtable(vm);
+		for(const compile_const_t &cnst : job.consts) {
+			detail::push_const(vm, cnst);
+		}
+		sq_setconsttable(vm);
+
+		if(SQ_FAILED(sq_compilebuffer(vm, job.code.c_str(), static_cast<SQInteger>(job.code.length()), job.name.c_str(), SQTrue))) {
+			job.failed = true;
+		} else {
+			if(SQ_FAILED(sq_writeclosure(vm, detail::bytecode_write, &job.bytecode))) {
+				job.errors += "failed to serialize compiled closure\n"sv;
+				job.failed = true;
+			}
+
+			sq_pop(vm, 1);
+		}
+
+		sq_setforeignptr(vm, nullptr);
+
+		//the constants of the next job replace these
+		sq_newtable(vm);
+		sq_setconsttable(vm);
+		sq_collectgarbage(vm);
+
+		if(!job.failed && !job.cache_path.empty()) {
+			std::error_code ec;
+			std::filesystem::create_directories(job.cache_dir, ec);
+
+			write_file(job.cache_path, job.bytecode.data(), job.bytecode.size());
+		}
+	}
+
+	void squirrel::compile_worker() noexcept
+	{
+		for(;;) {
+			std::unique_ptr<compile_job_t> job;
+
+			{
+				std::unique_lock<std::mutex> lock{compile_mx};
+				compile_cv.wait(lock, [this]() noexcept -> bool {
+					return compile_stop || !compile_queue.empty();
+				});
+
+				if(compile_stop) {
+					return;
+				}
+
+				job = std::move(compile_queue.front());
+				compile_queue.pop_front();
+				compile_running = job->id;
+			}
+
+			run_compile_job(compile_vm, *job);
+
+			{
+				std::lock_guard<std::mutex> VMOD_UNIQUE_NAME{compile_mx};
+				//cancelled while it was compiling
+				if(compile_running == job->id) {
+					std::size_t id{job->id};
+					compile_done.emplace(id, std::move(job));
+					compile_running = 0;
+				}
+			}
+		}
+	}
+
+	bool squirrel::start_compile_worker() noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		compile_vm = sq_open(1024);
+		if(!compile_vm) {
+			warning("vmod vm: failed to open compile worker vm, scripts will be compiled on the main thread\n"sv);
+			return false;
+		}
+
+		sq_setforeignptr(compile_vm, nullptr);
+
+	#ifndef __clang__
+		#pragma GCC diagnostic push
+		#pragma GCC diagnostic ignored "-Wsuggest-attribute=format"
+	#endif
+		sq_setprintfunc(compile_vm, compile_print_func, compile_print_func);
+	#ifdef __VMOD_USING_QUIRREL
+		sq_setcompilererrorhandler(compile_vm, compile_worker_err_func);
+	#endif
+	#ifndef __clang__
+		#pragma GCC diagnostic pop
+	#endif
+
+	#ifdef __VMOD_USING_QUIRREL
+		sq_forbidglobalconstrewrite(compile_vm, SQTrue);
+		sq_setcompilationoption(compile_vm, CompilationOptions::CO_CLOSURE_HOISTING_OPT, SQTrue);
+	#else
+		sqstd_seterrorhandlers(compile_vm);
+	#endif
+
+		compile_stop = false;
+		compile_thread = std::jthread{&squirrel::compile_worker, this};
+
+		return true;
+	}
+
+	void squirrel::stop_compile_worker() noexcept
+	{
+		if(compile_thread.joinable()) {
+			{
+				std::lock_guard<std::mutex> VMOD_UNIQUE_NAME{compile_mx};
+				compile_stop = true;
+			}
+			compile_cv.notify_one();
+			compile_thread.join();
+		}
+
+		compile_queue.clear();
+		compile_done.clear();
+		compile_running = 0;
+
+		if(compile_vm) {
+			sq_close(compile_vm);
+			compile_vm = nullptr;
+		}
+	}
+
+	std::size_t squirrel::compile_async(std::string &&code, std::string &&name, const std::filesystem::path &cache_dir) noexcept
+	{
+		if(!compile_thread.joinable()) {
+			return 0;
+		}
+
+		if(name.empty()) {
+			name = "<<unnamed>>";
+		}
+
+		std::unique_ptr<compile_job_t> job{new compile_job_t};
+		job->id = ++compile_ids;
+		//must match the main vm or the closures and their cache keys would differ
+		job->debug_info = debug_vm;
+		if(!cache_dir.empty()) {
+			job->cache_dir = cache_dir;
+			//the worker serves cache hits before it applies the constants, so the key has to cover them
+			job->cache_path = detail::bytecode_cache_path(cache_dir, code.c_str(), code.length(), name, job->debug_info, const_table_hash());
+		}
+		job->code = std::move(code);
+		job->name = std::move(name);
+
+		snapshot_consts(job->consts);
+
+		std::size_t id{job->id};
+
+		{
+			std::lock_guard<std::mutex> VMOD_UNIQUE_NAME{compile_mx};
+			compile_queue.emplace_back(std::move(job));
+		}
+		compile_cv.notify_one();
+
+		return id;
+	}
+
+	async_compile_status squirrel::take_compiled(std::size_t id, gsdk::HSCRIPT &script) noexcept
+	{
+		using namespace std::literals::string_view_literals;
+
+		std::unique_ptr<compile_job_t> job;
+
+		{
+			std::lock_guard<std::mutex> VMOD_UNIQUE_NAME{compile_mx};
+
+			auto it{compile_done.find(id)};
+			if(it == compile_done.end()) {
+				if(compile_running == id) {
+					return async_compile_status::pending;
+				}
+
+				for(const auto &queued : compile_queue) {
+					if(queued->id == id) {
+						return async_compile_status::pending;
+					}
+				}
+
+				return async_compile_status::failed;
+			}
+
+			job = std::move(it->second);
+			compile_done.erase(it);
+		}
+
+		if(job->failed) {
+			if(!job->errors.empty()) {
+				error("%s"sv, job->errors.c_str());
+			}
+			return async_compile_status::failed;
+		}
+
+		detail::bytecode_reader_t reader{job->bytecode.data(), job->bytecode.size(), 0};
+		if(SQ_SUCCEEDED(sq_readclosure(impl, detail::bytecode_read, &reader))) {
+			if(job->from_cache) {
+				++bytecode_stats.hits;
+			} else if(!job->cache_path.empty()) {
+				++bytecode_stats.misses;
+			}
+		} else {
+			if(job->from_cache) {
+				warning("vmod vm: discarding unreadable bytecode cache '%s'\n"sv, job->cache_path.c_str());
+				std::error_code ec;
+				std::filesystem::remove(job->cache_path, ec);
+			} else {
+				warning("vmod vm: bytecode of '%s' from the compile worker was unreadable, compiling it here\n"sv, job->name.c_str());
+			}
+
+			if(SQ_FAILED(sq_compilebuffer(impl, job->code.c_str(), static_cast<SQInteger>(job->code.length()), job->name.c_str(), SQTrue))) {
+				return async_compile_status::failed;
+			}
+		}
+
+		script = compile_script();
+		if(script == gsdk::INVALID_HSCRIPT) {
+			return async_compile_status::failed;
+		}
+
+		return async_compile_status::done;
+	}
+
+	void squirrel::cancel_compile(std::size_t id) noexcept
+	{
+		if(id == 0) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> VMOD_UNIQUE_NAME{compile_mx};
+
+		if(compile_running == id) {
+			compile_running = 0;
+			return;
+		}
+
+		compile_done.erase(id);
+
+		auto it{std::find_if(compile_queue.begin(), compile_queue.end(),
+			[id](const std::unique_ptr<compile_job_t> &job) noexcept -> bool {
+				return job->id == id;
+			}
+		)};
+		if(it != compile_queue.end()) {
+			compile_queue.erase(it);
+		}
+	}
+
+	gsdk::HSCRIPT squirrel::compile_script() noexcept
+	{
+		HSQOBJECT *script_obj{handles.allocate()};
+		sq_resetobject(script_obj);
+
+		if(SQ_FAILED(sq_getstackobj(impl, -1, script_obj))) {
+			sq_release(impl, script_obj);
+			handles.deallocate(script_obj);
+			script_obj = vs_cast(gsdk::INVALID_HSCRIPT);
+		} else {
+			sq_addref(impl, script_obj);
+		}
+
+		sq_pop(impl, 1);
+
+		return vs_cast(script_obj);
+	}
+
+	gsdk::ScriptStatus_t squirrel::Run(gsdk::HSCRIPT obj, gsdk::HSCRIPT scope, bool wait)
+	{
+		//TEMP!!! for l4d2
+		if(obj == gsdk::INVALID_HSCRIPT) {
+			return gsdk::SCRIPT_ERROR;
+		}
+
+		sq_pushobject(impl, *vs_cast(obj));
+
+		if(scope) {
+			sq_pushobject(impl, *vs_cast(scope));
+		} else {
+			sq_pushroottable(impl);
+		}
+
+		bool failed{SQ_FAILED(sq_call(impl, 1, SQFalse, SQTrue))};
+
+		sq_pop(impl, 1);
+
+		if(failed) {
+			return gsdk::SCRIPT_ERROR;
+		} else if(wait) {
+			return gsdk::SCRIPT_DONE;
+		} else {
+			return gsdk::SCRIPT_RUNNING;
+		}
+	}
+
+	gsdk::ScriptStatus_t squirrel::Run(gsdk::HSCRIPT obj, bool wait)
+	{
+		sq_pushobject(impl, *vs_cast(obj));
+
+		sq_pushroottable(impl);
+
+		bool failed{SQ_FAILED(sq_call(impl, 1, SQFalse, SQTrue))};
+
+		sq_pop(impl, 1);
+
+		if(failed) {
+			return gsdk::SCRIPT_ERROR;
+		} else if(wait) {
+			return gsdk::SCRIPT_DONE;
+		} else {
+			return gsdk::SCRIPT_RUNNING;
+		}
+	}
+
+	gsdk::HSCRIPT squirrel::CreateScope_impl(const char *name, gsdk::HSCRIPT parent)
+	{
+		sq_pushobject(impl, create_scope_func);
+
+		sq_pushroottable(impl);
+		sq_pushstring(impl, name, -1);
+		if(parent) {
+			sq_pushobject(impl, *vs_cast(parent));
+		} else {
+			sq_pushroottable(impl);
+		}
+
+		HSQOBJECT *scope{vs_cast(gsdk::INVALID_HSCRIPT)};
+
+		if(SQ_SUCCEEDED(sq_call(impl, 3, SQTrue, SQTrue))) {
+			scope = handles.allocate();
+			sq_resetobject(scope);
+
+			bool got{SQ_SUCCEEDED(sq_getstackobj(impl, -1, scope))};
+
+			if(!got || sq_isnull(*scope)) {
+				sq_release(impl, scope);
+				handles.deallocate(scope);
+				scope = vs_cast(gsdk::INVALID_HSCRIPT);
+			} else {
+				sq_addref(impl, scope);
+			}
+
+			sq_pop(impl, 1);
+		}
+
+		sq_pop(impl, 1);
+
+		return vs_cast(scope);
+	}
+
+	gsdk::HSCRIPT squirrel::CopyHandle(gsdk::HSCRIPT obj)
+	{
+		sq_pushobject(impl, *vs_cast(obj));
+
+		HSQOBJECT *copy{handles.allocate()};
+		sq_resetobject(copy);
+
+		if(SQ_FAILED(sq_getstackobj(impl, -1, copy))) {
+			sq_release(impl, copy);
+			handles.deallocate(copy);
+			copy = vs_cast(gsdk::INVALID_HSCRIPT);
+		} else {
+			sq_addref(impl, copy);
+		}
+
+		sq_pop(impl, 1);
+		return vs_cast(copy);
+	}
+
+	gsdk::HSCRIPT squirrel::ReferenceScope_impl(gsdk::HSCRIPT obj)
+	{
+		//TODO!!! l4d2 AI_ResponseParams::ScriptFollowup_t
+		if(!obj || obj == gsdk::INVALID_HSCRIPT) {
+			return gsdk::INVALID_HSCRIPT;
+		}
+
+		//TODO!!!! increment __vrefs ?
+
+		gsdk::HSCRIPT copy{squirrel::CopyHandle(obj)};
+		return copy;
+	}
+
+	void squirrel::release_handle(HSQOBJECT *obj) noexcept
+	{
+		//the objects went away with the vm but the handle memory is still ours
+		if(impl) {
+			sq_release(impl, obj);
+		}
+
+		handles.deallocate(obj);
+	}
+
+	void squirrel::ReleaseScript(gsdk::HSCRIPT obj)
+	{
+		//TEMP!!! for l4d2
+		if(obj == gsdk::INVALID_HSCRIPT) {
+			return;
+		}
+
+		release_handle(vs_cast(obj));
+	}
+
+	void squirrel::ReleaseFunction(gsdk::HSCRIPT obj)
+	{
+		//TODO!!! CDirector::PostRunScript gives invalid function find out why
+		if(obj == gsdk::INVALID_HSCRIPT) {
+			return;
+		}
+
+		release_handle(vs_cast(obj));
+	}
+
+	void squirrel::ReleaseScope(gsdk::HSCRIPT obj)
+	{
+		//TODO!!! l4d2 AI_ResponseParams::ScriptFollowup_t
+		if(obj == gsdk::INVALID_HSCRIPT) {
+			return;
+		}
+
+		if(!impl) {
+			release_handle(vs_cast(obj));
+			return;
+		}
+
+	#if GSDK_ENGINE == GSDK_ENGINE_L4D2
+		//TODO!!!! CDirector::TermScripts is calling this on a table instead of a scope investigate why
+
+		sq_pushobject(impl, *vs_cast(obj));
+		sq_pushstring(impl, _SC("__vrefs"), 7);
+
+		bool got{SQ_SUCCEEDED(sq_get(impl, -2))};
+		if(got) {
+			sq_pop(impl, 1);
+		}
+
+		sq_pop(impl, 1);
+
+		if(!got) {
+			sq_release(impl, vs_cast(obj));
+			handles.deallocate(vs_cast(obj));
+			return;
+		}
+	#endif
+
+		sq_pushobject(impl, release_scope_func);
+
+		sq_pushroottable(impl);
+		sq_pushobject(impl, *vs_cast(obj));
+
+		if(SQ_SUCCEEDED(sq_call(impl, 2, SQFalse, SQTrue))) {
+			sq_release(impl, vs_cast(obj));
+			handles.deallocate(vs_cast(obj));
+		}
+
+		sq_pop(impl, 1);
+	}
+
+	void squirrel::ReleaseValue(gsdk::ScriptVariant_t &value)
+	{
+		if(value.m_flags & gsdk::SV_FREE) {
+			switch(value.m_type) {
+				case gsdk::FIELD_VOID:
+				break;
+				case gsdk::FIELD_TYPEUNKNOWN:
+				break;
+				case gsdk::FIELD_POSITION_VECTOR:
+				case gsdk::FIELD_VECTOR:
+				delete value.m_vector;
+				break;
+				case gsdk::FIELD_VECTOR2D:
+				//delete m_vector2d;
+				break;
+				case gsdk::FIELD_QANGLE:
+				delete value.m_qangle;
+				break;
+				case gsdk::FIELD_QUATERNION:
+				//delete value.m_quaternion;
+				break;
+				case gsdk::FIELD_UTLSTRINGTOKEN:
+				//delete value.m_utlstringtoken;
+				break;
+				case gsdk::FIELD_CSTRING:
+				gsdk::free_arr<char>(value.m_cstr);
+				break;
+				case gsdk::FIELD_HSCRIPT_NEW_INSTANCE:
+				case gsdk::FIELD_HSCRIPT:
+				case gsdk::FIELD_CUSTOM:
+				case gsdk::FIELD_FUNCTION:
+				case gsdk::FIELD_EMBEDDED:
+				release_handle(vs_cast(value.m_object));
+				break;
+				default:
+				gsdk::free<void>(static_cast<void *>(value.m_data));
+				break;
+			}
+		}
+
+		value.m_flags = gsdk::SV_NOFLAGS;
+		std::memset(value.m_data, 0, sizeof(gsdk::ScriptVariant_t::m_data));
+		value.m_object = gsdk::INVALID_HSCRIPT;
+		value.m_type = gsdk::FIELD_TYPEUNKNOWN;
+	}
+
+	gsdk::HSCRIPT squirrel::LookupFunction_impl(const char *name, gsdk::HSCRIPT scope)
+	{
+		if(scope) {
+			sq_pushobject(impl, *vs_cast(scope));
+		} else {
+			sq_pushroottable(impl);
+		}
+
+		HSQOBJECT *copy{vs_cast(gsdk::INVALID_HSCRIPT)};
+
+		push_key(name);
+		if(SQ_SUCCEEDED(sq_get(impl, -2))) {
+			copy = handles.allocate();
+			sq_resetobject(copy);
+
+			if(SQ_FAILED(sq_getstackobj(impl, -1, copy))) {
+				sq_release(impl, copy);
+				handles.deallocate(copy);
+				copy = vs_cast(gsdk::INVALID_HSCRIPT);
+			} else {
+				sq_addref(impl, copy);
+			}
+
+			sq_pop(impl, 1);
+		}
+
+		sq_pop(impl, 1);
+
+		return vs_cast(copy);
+	}
+
+	bool squirrel::push(const gsdk::ScriptVariant_t &var) noexcept
+	{
+		switch(var.m_type) {
+			case gsdk::FIELD_VOID: {
+				sq_pushnull(impl);
+				return true;
+			}
+			case gsdk::FIELD_TIME:
+			case gsdk::FIELD_FLOAT: {
+				sq_pushfloat(impl, var.m_float);
+				return true;
+			}
+			case gsdk::FIELD_FLOAT64: {
+			#if GSDK_ENGINE == GSDK_ENGINE_TF2 || GSDK_ENGINE == GSDK_ENGINE_L4D2
+				sq_pushfloat(impl, static_cast<float>(var.m_double));
+			#elif GSDK_CHECK_BRANCH_VER(GSDK_ENGINE_BRANCH_2010, >=, GSDK_ENGINE_BRANCH_2010_V0)
+				sq_pushfloat(impl, var.m_float);
+			#else
+				#error
+			#endif
+				return true;
+			}
+			case gsdk::FIELD_STRING: {
+				const char *ccstr{gsdk::vscript::STRING(var.m_tstr)};
+
+				sq_pushstring(impl, ccstr, -1);
+				return true;
+			}
+			case gsdk::FIELD_MODELNAME:
+			case gsdk::FIELD_SOUNDNAME:
+			case gsdk::FIELD_CSTRING: {
+				sq_pushstring(impl, var.m_ccstr, -1);
+				return true;
+			}
+			case gsdk::FIELD_CHARACTER: {
+				char buff[2]{var.m_char, '\0'};
+				sq_pushstring(impl, buff, 1);
+				return true;
+			}
+			case gsdk::FIELD_SHORT: {
+				sq_pushinteger(impl, var.m_short);
+				return true;
+			}
+			case gsdk::FIELD_POSITIVEINTEGER_OR_NULL: {
+			#if GSDK_ENGINE == GSDK_ENGINE_TF2 || GSDK_ENGINE == GSDK_ENGINE_L4D2
 				if(var.m_longlong > 0) {
 					sq_pushinteger(impl, var.m_longlong);
 				}
@@ -2588,7 +4309,7 @@ namespace vmod::vm
 		}
 	}
 
-	bool squirrel::get(SQInteger idx, gsdk::ScriptVariant_t &var) noexcept
+	bool squirrel::get(SQInteger idx, gsdk::ScriptVariant_t &var, bool borrow) noexcept
 	{
 		var.reset();
 
@@ -2596,7 +4317,7 @@ namespace vmod::vm
 
 		auto handle_obj(
 			[this,&var,idx,type]() noexcept -> bool {
-				HSQOBJECT *copy{new HSQOBJECT};
+				HSQOBJECT *copy{handles.allocate()};
 				sq_resetobject(copy);
 				if(SQ_SUCCEEDED(sq_getstackobj(impl, idx, copy))) {
 					sq_addref(impl, copy);
@@ -2624,7 +4345,7 @@ namespace vmod::vm
 					var.m_flags |= gsdk::SV_FREE;
 					return true;
 				} else {
-					delete copy;
+					handles.deallocate(copy);
 					var.m_type = gsdk::FIELD_VOID;
 					var.m_object = gsdk::INVALID_HSCRIPT;
 					return false;
@@ -2719,8 +4440,12 @@ namespace vmod::vm
 						}
 
 						var.m_type = gsdk::FIELD_VECTOR;
-						var.m_vector = new gsdk::Vector{*static_cast<gsdk::Vector *>(userptr2)};
-						var.m_flags |= gsdk::SV_FREE;
+						if(borrow) {
+							var.m_vector = static_cast<gsdk::Vector *>(userptr2);
+						} else {
+							var.m_vector = new gsdk::Vector{*static_cast<gsdk::Vector *>(userptr2)};
+							var.m_flags |= gsdk::SV_FREE;
+						}
 						return true;
 					} else if(typetag == typeid_ptr<gsdk::QAngle>()) {
 						SQUserPointer userptr2{nullptr};
@@ -2731,8 +4456,12 @@ namespace vmod::vm
 						}
 
 						var.m_type = gsdk::FIELD_QANGLE;
-						var.m_qangle = new gsdk::QAngle{*static_cast<gsdk::QAngle *>(userptr2)};
-						var.m_flags |= gsdk::SV_FREE;
+						if(borrow) {
+							var.m_qangle = static_cast<gsdk::QAngle *>(userptr2);
+						} else {
+							var.m_qangle = new gsdk::QAngle{*static_cast<gsdk::QAngle *>(userptr2)};
+							var.m_flags |= gsdk::SV_FREE;
+						}
 						return true;
 					}
 				}
@@ -2763,7 +4492,7 @@ namespace vmod::vm
 
 		auto handle_obj(
 			[this,&var,&obj,type]() noexcept -> bool {
-				HSQOBJECT *copy{new HSQOBJECT};
+				HSQOBJECT *copy{handles.allocate()};
 				sq_resetobject(copy);
 				if(SQ_SUCCEEDED(sq_getstackobj(impl, -1, copy))) {
 					sq_addref(impl, copy);
@@ -2793,7 +4522,7 @@ namespace vmod::vm
 					return true;
 				} else {
 					sq_pop(impl, 1);
-					delete copy;
+					handles.deallocate(copy);
 					var.m_type = gsdk::FIELD_VOID;
 					var.m_object = gsdk::INVALID_HSCRIPT;
 					return false;
@@ -2919,46 +4648,30 @@ namespace vmod::vm
 		return SQ_OK;
 	}
 
-	gsdk::ScriptStatus_t squirrel::ExecuteFunction_impl(gsdk::HSCRIPT obj, gsdk::ScriptVariant_t *args, int num_args, gsdk::ScriptVariant_t *ret_var, gsdk::HSCRIPT scope, gsdk::ScriptExecuteFlags_t flags)
+	bool squirrel::prepare_call(gsdk::HSCRIPT func, gsdk::HSCRIPT scope, HSQOBJECT &sq_func, HSQOBJECT &sq_scope) const noexcept
 	{
-		std::size_t num_args_siz{static_cast<std::size_t>(num_args)};
-
-		std::vector<gsdk::ScriptVariant_t *> to_free;
-
-		//TODO!!! CDirector::PostRunScript gives invalid function find out why
-		if(obj == gsdk::INVALID_HSCRIPT) {
-			for(std::size_t i{0}; i < num_args_siz; ++i) {
-				args[i].free();
-			}
-			return gsdk::SCRIPT_ERROR;
+		if(!func || func == gsdk::INVALID_HSCRIPT) {
+			return false;
 		}
 
-		sq_pushobject(impl, *vs_cast(obj));
+		sq_func = *vs_cast(func);
 
-		if(scope) {
-			sq_pushobject(impl, *vs_cast(scope));
+		if(scope && scope != gsdk::INVALID_HSCRIPT) {
+			sq_scope = *vs_cast(scope);
 		} else {
-			sq_pushroottable(impl);
-		}
-
-		for(std::size_t i{0}; i < num_args_siz; ++i) {
-			if(args[i].should_free()) {
-				to_free.emplace_back(&args[i]);
-			}
-
-			if(!push(args[i])) {
-				debugtrap(); //TODO!!! pop pushed values
-				return gsdk::SCRIPT_ERROR;
-			}
+			sq_resetobject(&sq_scope);
 		}
 
-		bool copyback{static_cast<bool>(flags & gsdk::ScriptExecuteFlags_t::SCRIPT_EXEC_COPYBACK)};
+		return true;
+	}
 
+	gsdk::ScriptStatus_t squirrel::finish_call(gsdk::ScriptVariant_t *args, std::size_t num_args, gsdk::ScriptVariant_t *ret_var, bool copyback) noexcept
+	{
 		SQRESULT callret{
 			copyback ?
-			sq_call_nopop(impl, static_cast<SQInteger>(1+num_args_siz), ret_var ? SQTrue : SQFalse, SQTrue)
+			sq_call_nopop(impl, static_cast<SQInteger>(1+num_args), ret_var ? SQTrue : SQFalse, SQTrue)
 			:
-			sq_call(impl, static_cast<SQInteger>(1+num_args_siz), ret_var ? SQTrue : SQFalse, SQTrue)
+			sq_call(impl, static_cast<SQInteger>(1+num_args), ret_var ? SQTrue : SQFalse, SQTrue)
 		};
 
 		bool failed{false};
@@ -2980,23 +4693,213 @@ namespace vmod::vm
 			}
 
 			if(copyback) {
-				for(std::size_t i{1}; i <= num_args_siz; ++i) {
-					if(!get(-static_cast<SQInteger>(i), args[num_args_siz-i])) {
+				for(std::size_t i{1}; i <= num_args; ++i) {
+					if(!get(-static_cast<SQInteger>(i), args[num_args-i])) {
 						debugtrap(); //TODO!!! pop pushed values
 					}
 				}
 
-				sq_pop(impl, num_args);
+				sq_pop(impl, static_cast<SQInteger>(num_args));
+			}
+		}
+
+		//a call the watchdog unwound returns normally with a meaningless value
+		if(watchdog_tripped) {
+			failed = true;
+		}
+
+		return failed ? gsdk::SCRIPT_ERROR : gsdk::SCRIPT_DONE;
+	}
+
+	gsdk::ScriptStatus_t squirrel::call_prepared(const HSQOBJECT &func, const HSQOBJECT &scope, gsdk::ScriptVariant_t *args, std::size_t num_args, gsdk::ScriptVariant_t *ret_var, bool copyback) noexcept
+	{
+		scope_watchdog swd{*this};
+
+		sq_pushobject(impl, func);
+
+		if(!sq_isnull(scope)) {
+			sq_pushobject(impl, scope);
+		} else {
+			sq_pushroottable(impl);
+		}
+
+		//pushing copies everything so owned args can go right away, with copyback get frees them instead
+		for(std::size_t i{0}; i < num_args; ++i) {
+			if(!push(args[i])) {
+				debugtrap(); //TODO!!! pop pushed values
+				return gsdk::SCRIPT_ERROR;
+			}
+
+			if(!copyback && args[i].should_free()) {
+				args[i].free();
 			}
 		}
 
+		gsdk::ScriptStatus_t status{finish_call(args, num_args, ret_var, copyback)};
+
 		sq_pop(impl, 1);
 
-		for(auto &arg : to_free) {
-			arg->free();
+		return status;
+	}
+
+	std::size_t squirrel::call_prepared_batch(const HSQOBJECT &func, const HSQOBJECT &scope, gsdk::ScriptVariant_t *args, std::size_t num_args, std::size_t num_sets, gsdk::ScriptVariant_t *rets, gsdk::ScriptStatus_t *statuses) noexcept
+	{
+		SQInteger top{sq_gettop(impl)};
+
+		std::size_t succeeded{0};
+
+		//sq_call only pops the environment and the args so the closure stays put between calls
+		sq_pushobject(impl, func);
+
+		for(std::size_t i{0}; i < num_sets; ++i) {
+			gsdk::ScriptVariant_t *set_args{args + (i * num_args)};
+
+			scope_watchdog swd{*this};
+
+			if(!sq_isnull(scope)) {
+				sq_pushobject(impl, scope);
+			} else {
+				sq_pushroottable(impl);
+			}
+
+			bool pushed{true};
+
+			for(std::size_t j{0}; j < num_args; ++j) {
+				if(!push(set_args[j])) {
+					//the ones that never made it onto the stack are still owned here
+					for(std::size_t k{j}; k < num_args; ++k) {
+						if(set_args[k].should_free()) {
+							set_args[k].free();
+						}
+					}
+
+					pushed = false;
+					break;
+				}
+
+				if(set_args[j].should_free()) {
+					set_args[j].free();
+				}
+			}
+
+			gsdk::ScriptStatus_t status{gsdk::SCRIPT_ERROR};
+
+			if(pushed) {
+				status = finish_call(set_args, num_args, rets ? &rets[i] : nullptr, false);
+			} else {
+				//drops the environment and whatever args were pushed, the closure stays for the next set
+				sq_settop(impl, top+1);
+			}
+
+			if(status != gsdk::SCRIPT_ERROR) {
+				++succeeded;
+			}
+
+			if(statuses) {
+				statuses[i] = status;
+			}
 		}
 
-		if(failed) {
+		sq_settop(impl, top);
+
+		return succeeded;
+	}
+
+	namespace detail
+	{
+		//pushed as a fresh instance, copying the stack slot would hand every listener the same one
+		static inline bool is_value_instance(const gsdk::ScriptVariant_t &var) noexcept
+		{
+			switch(var.m_type) {
+			case gsdk::FIELD_QANGLE:
+			case gsdk::FIELD_POSITION_VECTOR:
+			case gsdk::FIELD_VECTOR:
+			return true;
+			default:
+			return false;
+			}
+		}
+	}
+
+	bool squirrel::begin_fanout(const gsdk::ScriptVariant_t *args, std::size_t num_args, SQInteger &base) noexcept
+	{
+		SQInteger top{sq_gettop(impl)};
+		base = top+1;
+
+		for(std::size_t i{0}; i < num_args; ++i) {
+			if(detail::is_value_instance(args[i])) {
+				//only keeps the slots lined up, call_fanout pushes its own
+				sq_pushnull(impl);
+				continue;
+			}
+
+			if(!push(args[i])) {
+				sq_settop(impl, top);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	gsdk::ScriptStatus_t squirrel::call_fanout(const HSQOBJECT &func, const HSQOBJECT &scope, SQInteger base, const gsdk::ScriptVariant_t *args, std::size_t num_args, gsdk::ScriptVariant_t *ret_var) noexcept
+	{
+		scope_watchdog swd{*this};
+
+		SQInteger top{sq_gettop(impl)};
+
+		sq_pushobject(impl, func);
+
+		if(!sq_isnull(scope)) {
+			sq_pushobject(impl, scope);
+		} else {
+			sq_pushroottable(impl);
+		}
+
+		//plain stack copies, only value instances get converted again
+		for(std::size_t i{0}; i < num_args; ++i) {
+			if(detail::is_value_instance(args[i])) {
+				if(!push(args[i])) {
+					sq_settop(impl, top);
+					return gsdk::SCRIPT_ERROR;
+				}
+			} else {
+				sq_push(impl, base + static_cast<SQInteger>(i));
+			}
+		}
+
+		gsdk::ScriptStatus_t status{finish_call(nullptr, num_args, ret_var, false)};
+
+		sq_pop(impl, 1);
+
+		return status;
+	}
+
+	void squirrel::end_fanout(SQInteger base) noexcept
+	{
+		sq_settop(impl, base-1);
+	}
+
+	gsdk::ScriptStatus_t squirrel::ExecuteFunction_impl(gsdk::HSCRIPT obj, gsdk::ScriptVariant_t *args, int num_args, gsdk::ScriptVariant_t *ret_var, gsdk::HSCRIPT scope, gsdk::ScriptExecuteFlags_t flags)
+	{
+		std::size_t num_args_siz{static_cast<std::size_t>(num_args)};
+
+		HSQOBJECT sq_func;
+		HSQOBJECT sq_scope;
+
+		//TODO!!! CDirector::PostRunScript gives invalid function find out why
+		if(!prepare_call(obj, scope, sq_func, sq_scope)) {
+			for(std::size_t i{0}; i < num_args_siz; ++i) {
+				args[i].free();
+			}
+			return gsdk::SCRIPT_ERROR;
+		}
+
+		bool copyback{static_cast<bool>(flags & gsdk::ScriptExecuteFlags_t::SCRIPT_EXEC_COPYBACK)};
+
+		gsdk::ScriptStatus_t status{call_prepared(sq_func, sq_scope, args, num_args_siz, ret_var, copyback)};
+
+		if(status == gsdk::SCRIPT_ERROR) {
 			return gsdk::SCRIPT_ERROR;
 		} else if(flags & gsdk::ScriptExecuteFlags_t::SCRIPT_EXEC_WAIT) {
 			return gsdk::SCRIPT_DONE;
@@ -3005,9 +4908,53 @@ namespace vmod::vm
 		}
 	}
 
+	namespace detail
+	{
+		//most bindings take a handful of args so keep them on the stack
+		class call_args_t final
+		{
+		public:
+			static constexpr std::size_t inline_capacity{8};
+
+			inline call_args_t(std::size_t num) noexcept
+				: size_{num}
+			{
+				if(num > inline_capacity) {
+					heap.reset(new gsdk::ScriptVariant_t[num]);
+					ptr = heap.get();
+				} else {
+					ptr = inline_args;
+				}
+			}
+
+			inline gsdk::ScriptVariant_t &operator[](std::size_t i) noexcept
+			{ return ptr[i]; }
+
+			inline gsdk::ScriptVariant_t *data() noexcept
+			{ return size_ > 0 ? ptr : nullptr; }
+
+			inline std::size_t size() const noexcept
+			{ return size_; }
+
+		private:
+			gsdk::ScriptVariant_t inline_args[inline_capacity];
+			std::unique_ptr<gsdk::ScriptVariant_t[]> heap;
+			gsdk::ScriptVariant_t *ptr;
+			std::size_t size_;
+
+		private:
+			call_args_t() = delete;
+			call_args_t(const call_args_t &) = delete;
+			call_args_t &operator=(const call_args_t &) = delete;
+			call_args_t(call_args_t &&) = delete;
+			call_args_t &operator=(call_args_t &&) = delete;
+		};
+	}
+
 	SQInteger squirrel::static_func_call(HSQUIRRELVM vm)
 	{
 		squirrel *actual_vm{static_cast<squirrel *>(sq_getforeignptr(vm))};
+		scope_native_vm snv{*actual_vm, vm};
 
 		SQInteger top{sq_gettop(vm)};
 		if(top < 2) {
@@ -3015,54 +4962,45 @@ namespace vmod::vm
 		}
 
 		SQUserPointer userptr{nullptr};
-		if(SQ_FAILED(sq_getuserpointer(vm, -1, &userptr))) {
+		if(SQ_FAILED(sq_getuserdata(vm, -1, &userptr, nullptr))) {
 			return sq_throwerror(vm, _SC("failed to get userptr"));
 		}
 
-		gsdk::ScriptFunctionBinding_t *info{static_cast<gsdk::ScriptFunctionBinding_t *>(userptr)};
+		const native_binding_t *binding{static_cast<const native_binding_t *>(userptr)};
 
-		std::size_t num_required_params{info->m_desc.m_Parameters.size()};
 		std::size_t num_params{static_cast<std::size_t>(top-2)};
-		if(info->va_or_last_optional()) {
-			if(num_required_params > 0) {
-				auto param_start{info->m_desc.m_Parameters.begin()};
-				auto param_it{info->m_desc.m_Parameters.end()-1};
-				while(param_it != param_start) {
-					if(!param_it->can_be_optional()) {
-						break;
-					}
-					--num_required_params;
-					--param_it;
-				}
-			}
-
-			if(num_params < num_required_params) {
-				return sqstd_throwerrorf(vm, _SC("wrong number of parameters expected at least %zu got %i"), num_required_params, top);
+		if(binding->variadic) {
+			if(num_params < binding->num_required_params) {
+				return sqstd_throwerrorf(vm, _SC("wrong number of parameters expected at least %zu got %i"), binding->num_required_params, top);
 			}
 		} else {
-			if(num_params != num_required_params) {
-				return sqstd_throwerrorf(vm, _SC("wrong number of parameters expected %zu got %i"), num_required_params, top);
+			if(num_params != binding->num_required_params) {
+				return sqstd_throwerrorf(vm, _SC("wrong number of parameters expected %zu got %i"), binding->num_required_params, top);
 			}
 		}
 
-		std::vector<gsdk::ScriptVariant_t> args;
+		if(binding->direct && actual_vm->direct_bindings) {
+			SQInteger res{actual_vm->direct_func_call_impl(vm, binding, nullptr)};
+			if(res != vscript::function_desc::direct_fallback) {
+				return res;
+			}
+		}
 
-		if(num_params > 0) {
-			args.resize(num_params);
+		detail::call_args_t args{num_params};
 
-			for(std::size_t i{0}; i < num_params; ++i) {
-				if(!actual_vm->get(static_cast<SQInteger>(2+i), args[i])) {
-					return sqstd_throwerrorf(vm, _SC("failed to get arg %zu"), i);
-				}
+		for(std::size_t i{0}; i < num_params; ++i) {
+			if(!actual_vm->get(static_cast<SQInteger>(2+i), args[i], true)) {
+				return sqstd_throwerrorf(vm, _SC("failed to get arg %zu"), i);
 			}
 		}
 
-		return actual_vm->func_call_impl(info, nullptr, args);
+		return actual_vm->func_call_impl(binding->info, nullptr, args.data(), args.size());
 	}
 
 	SQInteger squirrel::member_func_call(HSQUIRRELVM vm)
 	{
 		squirrel *actual_vm{static_cast<squirrel *>(sq_getforeignptr(vm))};
+		scope_native_vm snv{*actual_vm, vm};
 
 		SQInteger top{sq_gettop(vm)};
 		if(top < 3) {
@@ -3075,12 +5013,12 @@ namespace vmod::vm
 		}
 
 		SQUserPointer userptr2{nullptr};
-		if(SQ_FAILED(sq_getuserpointer(vm, -2, &userptr2))) {
+		if(SQ_FAILED(sq_getuserdata(vm, -2, &userptr2, nullptr))) {
 			return sq_throwerror(vm, _SC("failed to get userptr"));
 		}
 
 		gsdk::ScriptClassDesc_t *classinfo{static_cast<gsdk::ScriptClassDesc_t *>(userptr1)};
-		gsdk::ScriptFunctionBinding_t *funcinfo{static_cast<gsdk::ScriptFunctionBinding_t *>(userptr2)};
+		const native_binding_t *binding{static_cast<const native_binding_t *>(userptr2)};
 
 		SQUserPointer userptr3{nullptr};
 		if(SQ_FAILED(sq_getinstanceup(vm, 1, &userptr3, classinfo))) {
@@ -3095,67 +5033,76 @@ namespace vmod::vm
 			obj = classinfo->pHelper->GetProxied(obj);
 		}
 
-		std::size_t num_required_params{funcinfo->m_desc.m_Parameters.size()};
 		std::size_t num_params{static_cast<std::size_t>(top-3)};
-		if(funcinfo->va_or_last_optional()) {
-			if(num_required_params > 0) {
-				auto param_start{funcinfo->m_desc.m_Parameters.begin()};
-				auto param_it{funcinfo->m_desc.m_Parameters.end()-1};
-				while(param_it != param_start) {
-					if(!param_it->can_be_optional()) {
-						break;
-					}
-					--num_required_params;
-					--param_it;
-				}
-			}
-
-			if(num_params < num_required_params) {
-				return sqstd_throwerrorf(vm, _SC("wrong number of parameters expected at least %zu got %i"), num_required_params, top);
+		if(binding->variadic) {
+			if(num_params < binding->num_required_params) {
+				return sqstd_throwerrorf(vm, _SC("wrong number of parameters expected at least %zu got %i"), binding->num_required_params, top);
 			}
 		} else {
-			if(num_params != num_required_params) {
-				return sqstd_throwerrorf(vm, _SC("wrong number of parameters expected %zu got %i"), num_required_params, top);
+			if(num_params != binding->num_required_params) {
+				return sqstd_throwerrorf(vm, _SC("wrong number of parameters expected %zu got %i"), binding->num_required_params, top);
 			}
 		}
 
-		std::vector<gsdk::ScriptVariant_t> args;
+		if(binding->direct && actual_vm->direct_bindings) {
+			SQInteger res{actual_vm->direct_func_call_impl(vm, binding, obj)};
+			if(res != vscript::function_desc::direct_fallback) {
+				return res;
+			}
+		}
 
-		if(num_params > 0) {
-			args.resize(num_params);
+		detail::call_args_t args{num_params};
 
-			for(std::size_t i{0}; i < num_params; ++i) {
-				if(!actual_vm->get(static_cast<SQInteger>(2+i), args[i])) {
-					return sqstd_throwerrorf(vm, _SC("failed to get arg %zu"), i);
-				}
+		for(std::size_t i{0}; i < num_params; ++i) {
+			if(!actual_vm->get(static_cast<SQInteger>(2+i), args[i], true)) {
+				return sqstd_throwerrorf(vm, _SC("failed to get arg %zu"), i);
 			}
 		}
 
-		return actual_vm->func_call_impl(funcinfo, obj, args);
+		return actual_vm->func_call_impl(binding->info, obj, args.data(), args.size());
 	}
 
-	SQInteger squirrel::func_call_impl(const gsdk::ScriptFunctionBinding_t *info, void *obj, std::vector<gsdk::ScriptVariant_t> &args) noexcept
+	SQInteger squirrel::throw_last_exception(HSQUIRRELVM vm) noexcept
 	{
-		bool is_ret_void{info->m_desc.m_ReturnType == gsdk::FIELD_VOID};
+		sq_pushobject(vm, last_exception);
 
-		gsdk::ScriptVariant_t ret_var{};
-		bool success{info->m_pfnBinding(info->m_pFunction, obj, args.empty() ? nullptr : args.data(), static_cast<int>(args.size()), is_ret_void ? nullptr : &ret_var)};
+		SQRESULT res{sq_throwobject(vm)};
+
+		sq_release(vm, &last_exception);
+		got_last_exception = false;
+
+		sq_resetobject(&last_exception);
+
+		return res;
+	}
 
-		for(auto &arg : args) {
-			arg.free();
+	SQInteger squirrel::direct_func_call_impl(HSQUIRRELVM vm, const native_binding_t *binding, void *obj) noexcept
+	{
+		SQInteger res{binding->direct(vm, binding->info, obj, 2)};
+		if(res == vscript::function_desc::direct_fallback) {
+			return res;
 		}
 
 		if(got_last_exception) {
-			sq_pushobject(impl, last_exception);
+			return throw_last_exception(vm);
+		}
+
+		return res;
+	}
 
-			SQRESULT res{sq_throwobject(impl)};
+	SQInteger squirrel::func_call_impl(const gsdk::ScriptFunctionBinding_t *info, void *obj, gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept
+	{
+		bool is_ret_void{info->m_desc.m_ReturnType == gsdk::FIELD_VOID};
 
-			sq_release(impl, &last_exception);
-			got_last_exception = false;
+		gsdk::ScriptVariant_t ret_var{};
+		bool success{info->m_pfnBinding(info->m_pFunction, obj, args, static_cast<int>(num_args), is_ret_void ? nullptr : &ret_var)};
 
-			sq_resetobject(&last_exception);
+		for(std::size_t i{0}; i < num_args; ++i) {
+			args[i].free();
+		}
 
-			return res;
+		if(got_last_exception) {
+			return throw_last_exception(impl);
 		} else if(!success) {
 			return sq_throwerror(impl, _SC("binding function failed"));
 		}
@@ -3314,13 +5261,38 @@ namespace vmod::vm
 		bool is_static_member{classinfo && !(info->m_flags & gsdk::SF_MEMBER_FUNC)};
 		bool is_static{!classinfo || is_static_member};
 
+		//trailing optional params, the first one is always required
+		std::size_t num_optional_params{0};
+		if(!info->m_desc.m_Parameters.empty()) {
+			auto param_start{info->m_desc.m_Parameters.begin()};
+			auto param_it{info->m_desc.m_Parameters.end()-1};
+			while(param_it != param_start) {
+				if(!param_it->can_be_optional()) {
+					break;
+				}
+				++num_optional_params;
+				--param_it;
+			}
+		}
+
+		std::size_t num_params{static_cast<std::size_t>(info->m_desc.m_Parameters.size())};
+
 		sq_pushstring(impl, name_str.data(), static_cast<SQInteger>(name_str.length()));
 		if(!is_static) {
 			sq_pushuserpointer(impl, const_cast<gsdk::ScriptClassDesc_t *>(classinfo));
-			sq_pushuserpointer(impl, const_cast<gsdk::ScriptFunctionBinding_t *>(info));
+		}
+
+		native_binding_t *binding{static_cast<native_binding_t *>(sq_newuserdata(impl, sizeof(native_binding_t)))};
+		new (binding) native_binding_t{info, num_params - num_optional_params, num_optional_params, info->va_or_last_optional(), nullptr};
+
+		//va and optional params need the variant path to fill in missing args
+		if(!binding->variadic && num_optional_params == 0) {
+			binding->direct = vscript::function_desc::find_direct(info);
+		}
+
+		if(!is_static) {
 			sq_newclosure(impl, member_func_call, 2);
 		} else {
-			sq_pushuserpointer(impl, const_cast<gsdk::ScriptFunctionBinding_t *>(info));
 			sq_newclosure(impl, static_func_call, 1);
 		}
 
@@ -3366,22 +5338,9 @@ namespace vmod::vm
 				}
 			}
 		}
-
-		SQInteger nparamscheck{1+static_cast<SQInteger>(info->m_desc.m_Parameters.size())};
-		bool has_optionals{false};
-		if(!info->m_desc.m_Parameters.empty()) {
-			auto param_start{info->m_desc.m_Parameters.begin()};
-			auto param_it{info->m_desc.m_Parameters.end()-1};
-			while(param_it != param_start) {
-				if(!param_it->can_be_optional()) {
-					break;
-				}
-				--nparamscheck;
-				has_optionals = true;
-				--param_it;
-			}
-		}
-		if((info->m_flags & gsdk::SF_VA_FUNC) || has_optionals) {
+
+		SQInteger nparamscheck{1+static_cast<SQInteger>(num_params - num_optional_params)};
+		if((info->m_flags & gsdk::SF_VA_FUNC) || num_optional_params > 0) {
 			nparamscheck = -nparamscheck;
 		}
 
@@ -3706,204 +5665,525 @@ namespace vmod::vm
 			return true;
 		}
 
-		sq_pushroottable(impl);
+		sq_pushroottable(impl);
+
+		bool success{register_class(info, std::move(classname_str), nullptr)};
+		if(!success) {
+			error("vmod vm: failed to register '%s'\n"sv, classname_str.c_str());
+		}
+
+		sq_pop(impl, 1);
+
+		return success;
+	}
+
+	bool squirrel::RegisterClass(gsdk::ScriptClassDesc_t *info)
+	{
+		return RegisterClass_nonvirtual(info);
+	}
+
+	gsdk::HSCRIPT squirrel::RegisterInstance_impl_nonvirtual(gsdk::ScriptClassDesc_t *info, void *ptr) noexcept
+	{
+		std::string classname_str{info->m_pszScriptName};
+
+		auto class_it{registered_classes.find(classname_str)};
+		if(class_it == registered_classes.end()) {
+			if(!squirrel::RegisterClass_nonvirtual(info)) {
+				return gsdk::INVALID_HSCRIPT;
+			}
+
+			class_it = last_registered_class;
+		}
+
+		sq_pushobject(impl, class_it->second->obj);
+
+		if(SQ_FAILED(sq_createinstance(impl, -1))) {
+			sq_pop(impl, 1);
+			return gsdk::INVALID_HSCRIPT;
+		}
+
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(impl, -1, &userptr, info))) {
+			sq_pop(impl, 2);
+			return gsdk::INVALID_HSCRIPT;
+		}
+
+		instance_info_t *instinfo{static_cast<instance_info_t *>(userptr)};
+
+		new (instinfo) instance_info_t{info, ptr};
+
+		if(info->m_pfnDestruct) {
+			sq_setreleasehook(impl, -1, instance_release_external);
+		} else {
+			sq_setreleasehook(impl, -1, instance_release_generic);
+		}
+
+		HSQOBJECT *copy{handles.allocate()};
+		sq_resetobject(copy);
+
+		if(SQ_FAILED(sq_getstackobj(impl, -1, copy))) {
+			sq_release(impl, copy);
+			handles.deallocate(copy);
+			copy = vs_cast(gsdk::INVALID_HSCRIPT);
+		} else {
+			sq_addref(impl, copy);
+		}
+
+		sq_pop(impl, 2);
+
+		return vs_cast(copy);
+	}
+
+	gsdk::HSCRIPT squirrel::RegisterInstance_impl(gsdk::ScriptClassDesc_t *info, void *ptr)
+	{
+		return RegisterInstance_impl_nonvirtual(info, ptr);
+	}
+
+	void squirrel::SetInstanceUniqeId(gsdk::HSCRIPT obj, const char *id)
+	{
+		sq_pushobject(impl, *vs_cast(obj));
+
+		SQUserPointer userptr{nullptr};
+		if(SQ_SUCCEEDED(sq_getinstanceup(impl, -1, &userptr, nullptr))) {
+			static_cast<instance_info_t *>(userptr)->id = id;
+		}
+
+		sq_pop(impl, 1);
+	}
+
+	void squirrel::RemoveInstance(gsdk::HSCRIPT obj)
+	{
+		if(!impl) {
+			release_handle(vs_cast(obj));
+			return;
+		}
+
+		sq_pushobject(impl, *vs_cast(obj));
+
+		SQUserPointer userptr{nullptr};
+		if(SQ_SUCCEEDED(sq_getinstanceup(impl, -1, &userptr, nullptr))) {
+			static_cast<instance_info_t *>(userptr)->ptr = nullptr;
+		}
+
+		sq_pop(impl, 1);
+
+		sq_release(impl, vs_cast(obj));
+		handles.deallocate(vs_cast(obj));
+	}
+
+	void *squirrel::GetInstanceValue_impl(gsdk::HSCRIPT obj, gsdk::ScriptClassDesc_t *classinfo)
+	{
+		//TODO!!! investigate DoEntFire
+		if(obj == gsdk::INVALID_HSCRIPT) {
+			return nullptr;
+		}
+
+		sq_pushobject(impl, *vs_cast(obj));
+
+		SQUserPointer userptr{nullptr};
+		if(SQ_FAILED(sq_getinstanceup(impl, -1, &userptr, classinfo ? classinfo : nullptr))) {
+			sq_pop(impl, 1);
+			return nullptr;
+		}
+
+		instance_info_t *info{static_cast<instance_info_t *>(userptr)};
+
+		if(classinfo) {
+			auto class_it{registered_classes.find(classinfo->m_pszScriptName)};
+			if(class_it == registered_classes.end()) {
+				sq_pop(impl, 1);
+				return nullptr;
+			}
+
+			sq_pushobject(impl, class_it->second->obj);
+
+			if(sq_instanceof(impl) != SQTrue) {
+				sq_pop(impl, 1);
+
+				bool found{false};
+
+				auto it{info->classinfo};
+				while(it) {
+					if(it == classinfo) {
+						found = true;
+						break;
+					}
+
+					it = it->m_pBaseDesc;
+				}
+
+				if(!found) {
+					sq_pop(impl, 1);
+					return nullptr;
+				}
+			}
+		}
+
+		void *ptr{info->ptr};
+
+		sq_pop(impl, 1);
+
+		return ptr;
+	}
+
+	bool squirrel::GenerateUniqueKey(const char *root, char *buff, int len)
+	{
+		std::size_t len_siz{static_cast<std::size_t>(len)};
+
+		std::size_t root_len{std::strlen(root)};
+		if(len_siz <= root_len) {
+			return false;
+		}
+
+		std::size_t total_len{root_len + std::numeric_limits<std::size_t>::digits10 + 2};
+		if(len_siz < total_len) {
+			return false;
+		}
+
+	#ifndef __clang__
+		#pragma GCC diagnostic push
+		#pragma GCC diagnostic ignored "-Wformat-truncation="
+	#endif
+		if(std::snprintf(buff, len_siz, "%s_%zu", root, unique_ids) < 0) {
+			return false;
+		}
+	#ifndef __clang__
+		#pragma GCC diagnostic pop
+	#endif
+
+		++unique_ids;
+		return true;
+	}
+
+	void squirrel::push_key(const char *name) noexcept
+	{
+		if(!name) {
+			sq_pushnull(impl);
+			return;
+		}
+
+		std::uintptr_t name_addr{reinterpret_cast<std::uintptr_t>(name)};
+		key_slot_t &slot{key_slots[(name_addr ^ (name_addr >> 9)) & (num_key_slots-1)]};
+
+		//one pass over the name instead of strlen, hash and compare
+		if(slot.name == name && std::strcmp(name, slot.entry->first.c_str()) == 0) {
+			++key_stats.pointer_hits;
+			sq_pushobject(impl, slot.entry->second);
+			return;
+		}
+
+		std::string_view name_str{name};
+
+		auto it{key_cache.find(name_str)};
+		if(it != key_cache.end()) {
+			++key_stats.content_hits;
+			slot.name = name;
+			slot.entry = &*it;
+			sq_pushobject(impl, it->second);
+			return;
+		}
+
+		++key_stats.misses;
+
+		sq_pushstring(impl, name_str.data(), static_cast<SQInteger>(name_str.length()));
+
+		//dont let generated names grow the cache without bound
+		if(key_cache.size() >= max_cached_keys) {
+			return;
+		}
+
+		HSQOBJECT key;
+		sq_resetobject(&key);
+		if(SQ_SUCCEEDED(sq_getstackobj(impl, -1, &key))) {
+			sq_addref(impl, &key);
+			auto new_it{key_cache.emplace(std::string{name_str}, key).first};
+			slot.name = name;
+			slot.entry = &*new_it;
+		}
+	}
+
+	bool squirrel::ValueExists(gsdk::HSCRIPT scope, const char *name)
+	{
+		if(scope) {
+			sq_pushobject(impl, *vs_cast(scope));
+		} else {
+			sq_pushroottable(impl);
+		}
+
+		push_key(name);
+
+		bool got{SQ_SUCCEEDED(sq_get(impl, -2))};
+		if(got) {
+			sq_pop(impl, 1);
+		}
+
+		sq_pop(impl, 1);
+
+		return got;
+	}
+
+	bool squirrel::SetValue_nonvirtual(gsdk::HSCRIPT obj, const char *name, const char *value) noexcept
+	{
+		if(obj) {
+			sq_pushobject(impl, *vs_cast(obj));
+		} else {
+			sq_pushroottable(impl);
+		}
+
+		push_key(name);
+
+		if(value) {
+			sq_pushstring(impl, value, -1);
+		} else {
+			sq_pushnull(impl);
+		}
+
+		bool success{SQ_SUCCEEDED(sq_newslot(impl, -3, SQFalse))};
+
+		sq_pop(impl, 1);
+
+		return success;
+	}
+
+	bool squirrel::SetValue(gsdk::HSCRIPT obj, const char *name, const char *value)
+	{
+		return SetValue_nonvirtual(obj, name, value);
+	}
+
+	bool squirrel::SetValue_impl_nonvirtual(gsdk::HSCRIPT obj, const char *name, gsdk::ScriptVariant_t &value) noexcept
+	{
+		if(obj) {
+			sq_pushobject(impl, *vs_cast(obj));
+		} else {
+			sq_pushroottable(impl);
+		}
 
-		bool success{register_class(info, std::move(classname_str), nullptr)};
-		if(!success) {
-			error("vmod vm: failed to register '%s'\n"sv, classname_str.c_str());
+		push_key(name);
+		if(!push(value)) {
+			sq_pop(impl, 2);
+			value.free();
+			return false;
 		}
 
+		bool success{SQ_SUCCEEDED(sq_newslot(impl, -3, SQFalse))};
+
 		sq_pop(impl, 1);
 
+		value.free();
 		return success;
 	}
 
-	bool squirrel::RegisterClass(gsdk::ScriptClassDesc_t *info)
+	bool squirrel::SetValue_impl(gsdk::HSCRIPT obj, const char *name, gsdk::ScriptVariant_t &value)
 	{
-		return RegisterClass_nonvirtual(info);
+		return SetValue_impl_nonvirtual(obj, name, value);
 	}
 
-	gsdk::HSCRIPT squirrel::RegisterInstance_impl_nonvirtual(gsdk::ScriptClassDesc_t *info, void *ptr) noexcept
+	bool squirrel::SetValue_impl(gsdk::HSCRIPT obj, int idx, gsdk::ScriptVariant_t &value)
 	{
-		std::string classname_str{info->m_pszScriptName};
-
-		auto class_it{registered_classes.find(classname_str)};
-		if(class_it == registered_classes.end()) {
-			if(!squirrel::RegisterClass_nonvirtual(info)) {
-				return gsdk::INVALID_HSCRIPT;
-			}
-
-			class_it = last_registered_class;
-		}
-
-		sq_pushobject(impl, class_it->second->obj);
-
-		if(SQ_FAILED(sq_createinstance(impl, -1))) {
-			sq_pop(impl, 1);
-			return gsdk::INVALID_HSCRIPT;
+		if(obj) {
+			sq_pushobject(impl, *vs_cast(obj));
+		} else {
+			sq_pushroottable(impl);
 		}
 
-		SQUserPointer userptr{nullptr};
-		if(SQ_FAILED(sq_getinstanceup(impl, -1, &userptr, info))) {
+		sq_pushinteger(impl, idx);
+		if(!push(value)) {
 			sq_pop(impl, 2);
-			return gsdk::INVALID_HSCRIPT;
+			value.free();
+			return false;
 		}
 
-		instance_info_t *instinfo{static_cast<instance_info_t *>(userptr)};
+		bool success{SQ_SUCCEEDED(sq_newslot(impl, -3, SQFalse))};
 
-		new (instinfo) instance_info_t{info, ptr};
+		sq_pop(impl, 1);
 
-		if(info->m_pfnDestruct) {
-			sq_setreleasehook(impl, -1, instance_release_external);
-		} else {
-			sq_setreleasehook(impl, -1, instance_release_generic);
-		}
+		value.free();
+		return success;
+	}
 
-		HSQOBJECT *copy{new HSQOBJECT};
-		sq_resetobject(copy);
+	void squirrel::get_obj(gsdk::ScriptVariant_t &value) noexcept
+	{
+		value.reset();
 
+		HSQOBJECT *copy{handles.allocate()};
+		sq_resetobject(copy);
 		if(SQ_FAILED(sq_getstackobj(impl, -1, copy))) {
 			sq_release(impl, copy);
-			delete copy;
-			copy = vs_cast(gsdk::INVALID_HSCRIPT);
+			handles.deallocate(copy);
+			value.m_type = gsdk::FIELD_TYPEUNKNOWN;
+			value.m_object = gsdk::INVALID_HSCRIPT;
 		} else {
 			sq_addref(impl, copy);
+
+			switch(sq_type(*copy)) {
+			case OT_INSTANCE:
+			value.m_type = gsdk::FIELD_HSCRIPT_NEW_INSTANCE;
+			break;
+			case OT_NATIVECLOSURE:
+			case OT_CLOSURE:
+			value.m_type = gsdk::FIELD_FUNCTION;
+			break;
+			case OT_ARRAY:
+			value.m_type = gsdk::FIELD_CUSTOM;
+			break;
+			case OT_TABLE:
+			value.m_type = gsdk::FIELD_EMBEDDED;
+			break;
+			default:
+			value.m_type = gsdk::FIELD_HSCRIPT;
+			break;
+			}
+
+			value.m_object = vs_cast(copy);
+			value.m_flags |= gsdk::SV_FREE;
 		}
 
-		sq_pop(impl, 2);
+		sq_pop(impl, 1);
+	}
 
-		return vs_cast(copy);
+	void squirrel::CreateTable_impl(gsdk::ScriptVariant_t &value)
+	{
+		sq_newtable(impl);
+
+		get_obj(value);
+
+	#if GSDK_ENGINE == GSDK_ENGINE_L4D2
+		//TODO!!! having free causes crashes on CVScriptGameEventListener 
+		value.m_flags &= ~gsdk::SV_FREE;
+	#endif
 	}
 
-	gsdk::HSCRIPT squirrel::RegisterInstance_impl(gsdk::ScriptClassDesc_t *info, void *ptr)
+	void squirrel::CreateArray_impl_nonvirtual(gsdk::ScriptVariant_t &value) noexcept
 	{
-		return RegisterInstance_impl_nonvirtual(info, ptr);
+		sq_newarray(impl, 0);
+
+		get_obj(value);
 	}
 
-	void squirrel::SetInstanceUniqeId(gsdk::HSCRIPT obj, const char *id)
+	void squirrel::CreateArray_impl(gsdk::ScriptVariant_t &value)
 	{
-		sq_pushobject(impl, *vs_cast(obj));
+		CreateArray_impl_nonvirtual(value);
+	}
 
-		SQUserPointer userptr{nullptr};
-		if(SQ_SUCCEEDED(sq_getinstanceup(impl, -1, &userptr, nullptr))) {
-			static_cast<instance_info_t *>(userptr)->id = id;
+	bool squirrel::IsTable_nonvirtual(gsdk::HSCRIPT obj) noexcept
+	{
+		return sq_istable(*vs_cast(obj));
+	}
+
+	bool squirrel::IsTable(gsdk::HSCRIPT obj)
+	{
+		return IsTable_nonvirtual(obj);
+	}
+
+	int squirrel::GetNumTableEntries(gsdk::HSCRIPT obj) const
+	{
+		if(obj) {
+			sq_pushobject(impl, *vs_cast(obj));
+		} else {
+			sq_pushroottable(impl);
 		}
 
+		SQInteger size{sq_getsize(impl, -1)};
+
 		sq_pop(impl, 1);
+
+		return static_cast<int>(size);
 	}
 
-	void squirrel::RemoveInstance(gsdk::HSCRIPT obj)
+	int squirrel::GetArrayCount_nonvirtual(gsdk::HSCRIPT obj) noexcept
 	{
 		sq_pushobject(impl, *vs_cast(obj));
 
-		SQUserPointer userptr{nullptr};
-		if(SQ_SUCCEEDED(sq_getinstanceup(impl, -1, &userptr, nullptr))) {
-			static_cast<instance_info_t *>(userptr)->ptr = nullptr;
-		}
+		SQInteger size{sq_getsize(impl, -1)};
 
 		sq_pop(impl, 1);
 
-		sq_release(impl, vs_cast(obj));
-		delete vs_cast(obj);
+		return static_cast<int>(size);
 	}
 
-	void *squirrel::GetInstanceValue_impl(gsdk::HSCRIPT obj, gsdk::ScriptClassDesc_t *classinfo)
+	int squirrel::GetKeyValue(gsdk::HSCRIPT obj, int it, gsdk::ScriptVariant_t *key, gsdk::ScriptVariant_t *value)
 	{
-		//TODO!!! investigate DoEntFire
-		if(obj == gsdk::INVALID_HSCRIPT) {
-			return nullptr;
+		if(obj) {
+			sq_pushobject(impl, *vs_cast(obj));
+		} else {
+			sq_pushroottable(impl);
 		}
 
-		sq_pushobject(impl, *vs_cast(obj));
-
-		SQUserPointer userptr{nullptr};
-		if(SQ_FAILED(sq_getinstanceup(impl, -1, &userptr, classinfo ? classinfo : nullptr))) {
-			sq_pop(impl, 1);
-			return nullptr;
+		if(it == -1) {
+			sq_pushnull(impl);
+		} else {
+			sq_pushinteger(impl, it);
 		}
 
-		instance_info_t *info{static_cast<instance_info_t *>(userptr)};
+		SQInteger next_it{-1};
 
-		if(classinfo) {
-			auto class_it{registered_classes.find(classinfo->m_pszScriptName)};
-			if(class_it == registered_classes.end()) {
-				sq_pop(impl, 1);
-				return nullptr;
+		if(SQ_SUCCEEDED(sq_next(impl, -2))) {
+			if(key) {
+				(void)get(-2, *key);
 			}
 
-			sq_pushobject(impl, class_it->second->obj);
-
-			if(sq_instanceof(impl) != SQTrue) {
-				sq_pop(impl, 1);
-
-				bool found{false};
-
-				auto it{info->classinfo};
-				while(it) {
-					if(it == classinfo) {
-						found = true;
-						break;
-					}
+			if(value) {
+				(void)get(-1, *value);
+			}
 
-					it = it->m_pBaseDesc;
-				}
+			sq_pop(impl, 2);
 
-				if(!found) {
-					sq_pop(impl, 1);
-					return nullptr;
-				}
-			}
+			(void)sq_getinteger(impl, -1, &next_it);
 		}
 
-		void *ptr{info->ptr};
-
-		sq_pop(impl, 1);
+		sq_pop(impl, 2);
 
-		return ptr;
+		return static_cast<int>(next_it);
 	}
 
-	bool squirrel::GenerateUniqueKey(const char *root, char *buff, int len)
+	int squirrel::GetKeyValue2(gsdk::HSCRIPT obj, int it, gsdk::ScriptVariant_t *key, gsdk::ScriptVariant_t *value)
 	{
-		std::size_t len_siz{static_cast<std::size_t>(len)};
+		return squirrel::GetKeyValue(obj, it, key, value);
+	}
 
-		std::size_t root_len{std::strlen(root)};
-		if(len_siz <= root_len) {
-			return false;
+	bool squirrel::GetValue_impl(gsdk::HSCRIPT obj, const char *name, gsdk::ScriptVariant_t *value)
+	{
+		if(obj) {
+			sq_pushobject(impl, *vs_cast(obj));
+		} else {
+			sq_pushroottable(impl);
 		}
 
-		std::size_t total_len{root_len + std::numeric_limits<std::size_t>::digits10 + 2};
-		if(len_siz < total_len) {
-			return false;
-		}
+		push_key(name);
 
-	#ifndef __clang__
-		#pragma GCC diagnostic push
-		#pragma GCC diagnostic ignored "-Wformat-truncation="
-	#endif
-		if(std::snprintf(buff, len_siz, "%s_%zu", root, unique_ids) < 0) {
-			return false;
+		bool got{SQ_SUCCEEDED(sq_get(impl, -2))};
+
+		if(got) {
+			got = get(-1, *value);
+
+			sq_pop(impl, 1);
+		} else {
+			value->reset();
 		}
-	#ifndef __clang__
-		#pragma GCC diagnostic pop
-	#endif
 
-		++unique_ids;
-		return true;
+		sq_pop(impl, 1);
+
+		return got;
 	}
 
-	bool squirrel::ValueExists(gsdk::HSCRIPT scope, const char *name)
+	bool squirrel::GetValue_impl(gsdk::HSCRIPT obj, int idx, gsdk::ScriptVariant_t *value)
 	{
-		if(scope) {
-			sq_pushobject(impl, *vs_cast(scope));
+		if(obj) {
+			sq_pushobject(impl, *vs_cast(obj));
 		} else {
 			sq_pushroottable(impl);
 		}
 
-		sq_pushstring(impl, name, -1);
+		sq_pushinteger(impl, idx);
 
 		bool got{SQ_SUCCEEDED(sq_get(impl, -2))};
+
 		if(got) {
+			got = get(-1, *value);
+
 			sq_pop(impl, 1);
+		} else {
+			value->reset();
 		}
 
 		sq_pop(impl, 1);
@@ -3911,7 +6191,12 @@ namespace vmod::vm
 		return got;
 	}
 
-	bool squirrel::SetValue_nonvirtual(gsdk::HSCRIPT obj, const char *name, const char *value) noexcept
+	bool squirrel::GetScalarValue(gsdk::HSCRIPT obj, gsdk::ScriptVariant_t *value)
+	{
+		return get(*vs_cast(obj), *value, true);
+	}
+
+	bool squirrel::ClearValue(gsdk::HSCRIPT obj, const char *name)
 	{
 		if(obj) {
 			sq_pushobject(impl, *vs_cast(obj));
@@ -3919,330 +6204,802 @@ namespace vmod::vm
 			sq_pushroottable(impl);
 		}
 
-		sq_pushstring(impl, name, -1);
-
-		if(value) {
-			sq_pushstring(impl, value, -1);
-		} else {
-			sq_pushnull(impl);
-		}
+		push_key(name);
 
-		bool success{SQ_SUCCEEDED(sq_newslot(impl, -3, SQFalse))};
+		bool removed{SQ_SUCCEEDED(sq_deleteslot(impl, -2, SQFalse))};
 
 		sq_pop(impl, 1);
 
-		return success;
+		return removed;
 	}
 
-	bool squirrel::SetValue(gsdk::HSCRIPT obj, const char *name, const char *value)
+	bool squirrel::IsArray_nonvirtual(gsdk::HSCRIPT obj) noexcept
 	{
-		return SetValue_nonvirtual(obj, name, value);
+		return sq_isarray(*vs_cast(obj));
 	}
 
-	bool squirrel::SetValue_impl_nonvirtual(gsdk::HSCRIPT obj, const char *name, gsdk::ScriptVariant_t &value) noexcept
+	bool squirrel::IsArray(gsdk::HSCRIPT obj)
 	{
-		if(obj) {
-			sq_pushobject(impl, *vs_cast(obj));
-		} else {
-			sq_pushroottable(impl);
-		}
+		return IsArray_nonvirtual(obj);
+	}
+
+	int squirrel::GetArrayCount(gsdk::HSCRIPT obj)
+	{
+		return GetArrayCount_nonvirtual(obj);
+	}
+
+	void squirrel::ArrayAddToTail(gsdk::HSCRIPT obj, const gsdk::ScriptVariant_t &value)
+	{
+		sq_pushobject(impl, *vs_cast(obj));
 
-		sq_pushstring(impl, name, -1);
 		if(!push(value)) {
-			sq_pop(impl, 2);
-			value.free();
-			return false;
+			sq_pop(impl, 1);
+			return;
 		}
 
-		bool success{SQ_SUCCEEDED(sq_newslot(impl, -3, SQFalse))};
+		(void)sq_arrayappend(impl, -2);
 
 		sq_pop(impl, 1);
+	}
 
-		value.free();
-		return success;
+	namespace detail
+	{
+		static constexpr std::uint32_t state_magic{0x51534d56};
+		static constexpr std::uint32_t state_version{1};
+
+		//recursion guard, anything nested deeper is dropped from the snapshot
+		static constexpr std::size_t state_max_depth{256};
+
+		enum class state_tag : unsigned char
+		{
+			end,
+			null,
+			integer,
+			floating,
+			boolean,
+			string,
+			ref,
+			skip,
+			table,
+			array,
+			closure,
+			script_class,
+			native_class,
+			script_instance,
+			native_instance,
+			vector,
+			qangle
+		};
+
+		static inline bool put_tag(gsdk::CUtlBuffer &buffer, state_tag tag) noexcept
+		{ return buffer.put(static_cast<unsigned char>(tag)); }
+
+		static inline bool put_string(gsdk::CUtlBuffer &buffer, std::string_view str) noexcept
+		{ return buffer.put(static_cast<std::uint32_t>(str.length())) && buffer.put(str.data(), str.length()); }
+
+		static inline bool get_string(gsdk::CUtlBuffer &buffer, std::string &str) noexcept
+		{
+			std::uint32_t len{0};
+			if(!buffer.get(len) || len > buffer.get_bytes_remaining()) {
+				return false;
+			}
+
+			str.resize(len);
+			return buffer.get(str.data(), len);
+		}
 	}
 
-	bool squirrel::SetValue_impl(gsdk::HSCRIPT obj, const char *name, gsdk::ScriptVariant_t &value)
+	std::unordered_map<const gsdk::ScriptClassDesc_t *, squirrel::state_hooks_t> squirrel::state_hooks;
+
+	struct squirrel::state_writer_t final
 	{
-		return SetValue_impl_nonvirtual(obj, name, value);
+		gsdk::CUtlBuffer &buffer;
+		std::unordered_map<const void *, std::uint32_t> ids;
+		std::uint32_t next_id{0};
+		std::size_t depth{0};
+	};
+
+	struct squirrel::state_reader_t final
+	{
+		gsdk::CUtlBuffer &buffer;
+		std::vector<HSQOBJECT> objects;
+		std::size_t depth{0};
+	};
+
+	void squirrel::register_state_hooks(const gsdk::ScriptClassDesc_t *info, state_hooks_t hooks) noexcept
+	{
+		state_hooks.insert_or_assign(info, hooks);
 	}
 
-	bool squirrel::SetValue_impl(gsdk::HSCRIPT obj, int idx, gsdk::ScriptVariant_t &value)
+	bool squirrel::write_state_entries(state_writer_t &writer) noexcept
 	{
-		if(obj) {
-			sq_pushobject(impl, *vs_cast(obj));
-		} else {
-			sq_pushroottable(impl);
-		}
+		sq_pushnull(impl);
+
+		while(SQ_SUCCEEDED(sq_next(impl, -2))) {
+			sq_push(impl, -2);
+			bool written{write_state_value(writer)};
+			sq_pop(impl, 1);
+
+			if(written) {
+				written = write_state_value(writer);
+			}
 
-		sq_pushinteger(impl, idx);
-		if(!push(value)) {
 			sq_pop(impl, 2);
-			value.free();
-			return false;
-		}
 
-		bool success{SQ_SUCCEEDED(sq_newslot(impl, -3, SQFalse))};
+			if(!written) {
+				sq_pop(impl, 1);
+				return false;
+			}
+		}
 
 		sq_pop(impl, 1);
 
-		value.free();
-		return success;
+		return detail::put_tag(writer.buffer, detail::state_tag::end);
 	}
 
-	void squirrel::get_obj(gsdk::ScriptVariant_t &value) noexcept
+	bool squirrel::write_state_value(state_writer_t &writer) noexcept
 	{
-		value.reset();
+		using namespace std::literals::string_view_literals;
+		using detail::state_tag;
+		using detail::put_tag;
 
-		HSQOBJECT *copy{new HSQOBJECT};
-		sq_resetobject(copy);
-		if(SQ_FAILED(sq_getstackobj(impl, -1, copy))) {
-			sq_release(impl, copy);
-			delete copy;
-			value.m_type = gsdk::FIELD_TYPEUNKNOWN;
-			value.m_object = gsdk::INVALID_HSCRIPT;
-		} else {
-			sq_addref(impl, copy);
+		gsdk::CUtlBuffer &buffer{writer.buffer};
 
-			switch(sq_type(*copy)) {
-			case OT_INSTANCE:
-			value.m_type = gsdk::FIELD_HSCRIPT_NEW_INSTANCE;
-			break;
-			case OT_NATIVECLOSURE:
-			case OT_CLOSURE:
-			value.m_type = gsdk::FIELD_FUNCTION;
-			break;
-			case OT_ARRAY:
-			value.m_type = gsdk::FIELD_CUSTOM;
-			break;
+		HSQOBJECT obj;
+		sq_resetobject(&obj);
+		if(SQ_FAILED(sq_getstackobj(impl, -1, &obj))) {
+			return false;
+		}
+
+		switch(sq_type(obj)) {
+			case OT_NULL:
+			return put_tag(buffer, state_tag::null);
+			case OT_INTEGER: {
+				SQInteger value{0};
+				(void)sq_getinteger(impl, -1, &value);
+				return put_tag(buffer, state_tag::integer) && buffer.put(static_cast<std::int64_t>(value));
+			}
+			case OT_FLOAT: {
+				SQFloat value{0};
+				(void)sq_getfloat(impl, -1, &value);
+				return put_tag(buffer, state_tag::floating) && buffer.put(static_cast<double>(value));
+			}
+			case OT_BOOL: {
+				SQBool value{SQFalse};
+				(void)sq_getbool(impl, -1, &value);
+				return put_tag(buffer, state_tag::boolean) && buffer.put(static_cast<unsigned char>(value ? 1 : 0));
+			}
+			case OT_STRING: {
+				const SQChar *str{nullptr};
+				(void)sq_getstring(impl, -1, &str);
+				std::size_t len{static_cast<std::size_t>(sq_getsize(impl, -1))};
+				return put_tag(buffer, state_tag::string) && detail::put_string(buffer, std::string_view{str, len});
+			}
 			case OT_TABLE:
-			value.m_type = gsdk::FIELD_EMBEDDED;
+			case OT_ARRAY:
+			case OT_CLOSURE:
+			case OT_CLASS:
+			case OT_INSTANCE:
 			break;
 			default:
-			value.m_type = gsdk::FIELD_HSCRIPT;
-			break;
+			return put_tag(buffer, state_tag::skip);
+		}
+
+		const void *key{obj._unVal.pRefCounted};
+
+		auto id_it{writer.ids.find(key)};
+		if(id_it != writer.ids.end()) {
+			return put_tag(buffer, state_tag::ref) && buffer.put(id_it->second);
+		}
+
+		if(writer.depth >= detail::state_max_depth || SQ_FAILED(sq_reservestack(impl, 8))) {
+			return put_tag(buffer, state_tag::skip);
+		}
+
+		struct scope_depth final
+		{
+			inline scope_depth(std::size_t &depth_) noexcept
+				: depth{depth_}
+			{ ++depth; }
+			inline ~scope_depth() noexcept
+			{ --depth; }
+
+			std::size_t &depth;
+		};
+
+		scope_depth sd{writer.depth};
+
+		switch(sq_type(obj)) {
+			case OT_TABLE: {
+				if(!put_tag(buffer, state_tag::table)) {
+					return false;
+				}
+
+				writer.ids.emplace(key, writer.next_id++);
+
+				if(!write_state_entries(writer)) {
+					return false;
+				}
+
+				if(SQ_FAILED(sq_getdelegate(impl, -1))) {
+					sq_pushnull(impl);
+				}
+
+				bool written{write_state_value(writer)};
+				sq_pop(impl, 1);
+				return written;
+			}
+			case OT_ARRAY: {
+				std::size_t size{static_cast<std::size_t>(sq_getsize(impl, -1))};
+
+				if(!put_tag(buffer, state_tag::array) || !buffer.put(static_cast<std::uint32_t>(size))) {
+					return false;
+				}
+
+				writer.ids.emplace(key, writer.next_id++);
+
+				for(std::size_t i{0}; i < size; ++i) {
+					sq_pushinteger(impl, static_cast<SQInteger>(i));
+					if(SQ_FAILED(sq_get(impl, -2))) {
+						sq_pushnull(impl);
+					}
+
+					bool written{write_state_value(writer)};
+					sq_pop(impl, 1);
+
+					if(!written) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+			case OT_CLOSURE: {
+				//free variables live outside the closure and cant be written with it
+				if(obj._unVal.pClosure->_function->_noutervalues > 0) {
+					return put_tag(buffer, state_tag::skip);
+				}
+
+				std::vector<unsigned char> bytecode;
+				if(SQ_FAILED(sq_writeclosure(impl, detail::bytecode_write, &bytecode))) {
+					return put_tag(buffer, state_tag::skip);
+				}
+
+				if(!put_tag(buffer, state_tag::closure) || !buffer.put(static_cast<std::uint32_t>(bytecode.size())) || !buffer.put(bytecode.data(), bytecode.size())) {
+					return false;
+				}
+
+				writer.ids.emplace(key, writer.next_id++);
+
+				return true;
+			}
+			case OT_CLASS: {
+				SQUserPointer typetag{nullptr};
+				(void)sq_gettypetag(impl, -1, &typetag);
+
+				if(typetag) {
+					std::string_view name;
+					if(typetag == typeid_ptr<gsdk::Vector>()) {
+						name = "Vector"sv;
+					} else if(typetag == typeid_ptr<gsdk::QAngle>()) {
+						name = "QAngle"sv;
+					} else {
+						name = static_cast<const gsdk::ScriptClassDesc_t *>(typetag)->m_pszScriptName;
+					}
+
+					return put_tag(buffer, state_tag::native_class) && detail::put_string(buffer, name);
+				}
+
+				if(!put_tag(buffer, state_tag::script_class)) {
+					return false;
+				}
+
+				if(SQ_FAILED(sq_getbase(impl, -1))) {
+					sq_pushnull(impl);
+				}
+
+				bool written{write_state_value(writer)};
+				sq_pop(impl, 1);
+
+				if(!written) {
+					return false;
+				}
+
+				writer.ids.emplace(key, writer.next_id++);
+
+				return write_state_entries(writer);
 			}
+			case OT_INSTANCE: {
+				SQUserPointer typetag{nullptr};
+				(void)sq_gettypetag(impl, -1, &typetag);
+
+				if(typetag == typeid_ptr<gsdk::Vector>() || typetag == typeid_ptr<gsdk::QAngle>()) {
+					SQUserPointer userptr{nullptr};
+					if(SQ_FAILED(sq_getinstanceup(impl, -1, &userptr, typetag))) {
+						return put_tag(buffer, state_tag::skip);
+					}
+
+					bool is_vector{typetag == typeid_ptr<gsdk::Vector>()};
+
+					float xyz[3];
+					if(is_vector) {
+						const gsdk::Vector &vec{*static_cast<const gsdk::Vector *>(userptr)};
+						xyz[0] = vec.x;
+						xyz[1] = vec.y;
+						xyz[2] = vec.z;
+					} else {
+						const gsdk::QAngle &ang{*static_cast<const gsdk::QAngle *>(userptr)};
+						xyz[0] = ang.x;
+						xyz[1] = ang.y;
+						xyz[2] = ang.z;
+					}
+
+					if(!put_tag(buffer, is_vector ? state_tag::vector : state_tag::qangle) || !buffer.put(xyz)) {
+						return false;
+					}
+
+					writer.ids.emplace(key, writer.next_id++);
+
+					return true;
+				} else if(typetag) {
+					const gsdk::ScriptClassDesc_t *info{static_cast<const gsdk::ScriptClassDesc_t *>(typetag)};
+
+					auto hooks_it{state_hooks.find(info)};
+					if(hooks_it == state_hooks.end()) {
+						return put_tag(buffer, state_tag::skip);
+					}
+
+					SQUserPointer userptr{nullptr};
+					if(SQ_FAILED(sq_getinstanceup(impl, -1, &userptr, nullptr)) || !userptr) {
+						return put_tag(buffer, state_tag::skip);
+					}
+
+					int tag_pos{buffer.m_Put};
+
+					if(!put_tag(buffer, state_tag::native_instance) || !detail::put_string(buffer, info->m_pszScriptName)) {
+						return false;
+					}
+
+					int size_pos{buffer.m_Put};
+					if(!buffer.put(std::uint32_t{0})) {
+						return false;
+					}
+
+					//hooks write straight into the buffer, on failure everything they wrote is dropped
+					if(!hooks_it->second.write(static_cast<const instance_info_t *>(userptr)->ptr, buffer) || !buffer.is_valid()) {
+						buffer.m_Put = tag_pos;
+						buffer.m_nMaxPut = tag_pos;
+						buffer.m_Error &= ~gsdk::CUtlBuffer::PUT_OVERFLOW;
+						return put_tag(buffer, state_tag::skip);
+					}
+
+					std::uint32_t size{static_cast<std::uint32_t>(buffer.m_Put - size_pos - static_cast<int>(sizeof(std::uint32_t)))};
+					std::memcpy(buffer.m_Memory.data() + size_pos, &size, sizeof(std::uint32_t));
+
+					writer.ids.emplace(key, writer.next_id++);
+
+					return true;
+				}
+
+				if(!put_tag(buffer, state_tag::script_instance)) {
+					return false;
+				}
+
+				if(SQ_FAILED(sq_getclass(impl, -1))) {
+					sq_pushnull(impl);
+				}
+
+				bool written{write_state_value(writer)};
+				sq_pop(impl, 1);
 
-			value.m_object = vs_cast(copy);
-			value.m_flags |= gsdk::SV_FREE;
-		}
+				if(!written) {
+					return false;
+				}
 
-		sq_pop(impl, 1);
+				writer.ids.emplace(key, writer.next_id++);
+
+				return write_state_entries(writer);
+			}
+			default:
+			return put_tag(buffer, state_tag::skip);
+		}
 	}
 
-	void squirrel::CreateTable_impl(gsdk::ScriptVariant_t &value)
+	squirrel::state_read_t squirrel::read_state_entries(state_reader_t &reader) noexcept
 	{
-		sq_newtable(impl);
+		//the target object is on top, keys the object refuses are dropped
+		while(true) {
+			SQInteger top{sq_gettop(impl)};
 
-		get_obj(value);
+			state_read_t key_res{read_state_value(reader)};
+			if(key_res == state_read_t::end) {
+				return state_read_t::value;
+			} else if(key_res == state_read_t::failed) {
+				return state_read_t::failed;
+			}
 
-	#if GSDK_ENGINE == GSDK_ENGINE_L4D2
-		//TODO!!! having free causes crashes on CVScriptGameEventListener 
-		value.m_flags &= ~gsdk::SV_FREE;
-	#endif
-	}
+			state_read_t value_res{read_state_value(reader)};
+			if(value_res == state_read_t::failed || value_res == state_read_t::end) {
+				sq_settop(impl, top);
+				return state_read_t::failed;
+			}
 
-	void squirrel::CreateArray_impl_nonvirtual(gsdk::ScriptVariant_t &value) noexcept
-	{
-		sq_newarray(impl, 0);
+			if(key_res == state_read_t::value && value_res == state_read_t::value) {
+				if(sq_gettype(impl, top) == OT_INSTANCE) {
+					(void)sq_set(impl, top);
+				} else {
+					(void)sq_newslot(impl, top, SQFalse);
+				}
+			}
 
-		get_obj(value);
+			sq_settop(impl, top);
+		}
 	}
 
-	void squirrel::CreateArray_impl(gsdk::ScriptVariant_t &value)
+	squirrel::state_read_t squirrel::read_state_value(state_reader_t &reader) noexcept
 	{
-		CreateArray_impl_nonvirtual(value);
-	}
+		using namespace std::literals::string_view_literals;
+		using detail::state_tag;
 
-	bool squirrel::IsTable_nonvirtual(gsdk::HSCRIPT obj) noexcept
-	{
-		return sq_istable(*vs_cast(obj));
-	}
+		gsdk::CUtlBuffer &buffer{reader.buffer};
 
-	bool squirrel::IsTable(gsdk::HSCRIPT obj)
-	{
-		return IsTable_nonvirtual(obj);
-	}
+		unsigned char tag_value{0};
+		if(!buffer.get(tag_value)) {
+			return state_read_t::failed;
+		}
 
-	int squirrel::GetNumTableEntries(gsdk::HSCRIPT obj) const
-	{
-		if(obj) {
-			sq_pushobject(impl, *vs_cast(obj));
-		} else {
-			sq_pushroottable(impl);
+		auto push_object{
+			[this,&reader]() noexcept -> void {
+				HSQOBJECT obj;
+				sq_resetobject(&obj);
+				(void)sq_getstackobj(impl, -1, &obj);
+				sq_addref(impl, &obj);
+				reader.objects.emplace_back(obj);
+			}
+		};
+
+		switch(static_cast<state_tag>(tag_value)) {
+			case state_tag::end:
+			return state_read_t::end;
+			case state_tag::skip:
+			return state_read_t::skipped;
+			case state_tag::null: {
+				sq_pushnull(impl);
+				return state_read_t::value;
+			}
+			case state_tag::integer: {
+				std::int64_t value{0};
+				if(!buffer.get(value)) {
+					return state_read_t::failed;
+				}
+				sq_pushinteger(impl, static_cast<SQInteger>(value));
+				return state_read_t::value;
+			}
+			case state_tag::floating: {
+				double value{0.0};
+				if(!buffer.get(value)) {
+					return state_read_t::failed;
+				}
+				sq_pushfloat(impl, static_cast<SQFloat>(value));
+				return state_read_t::value;
+			}
+			case state_tag::boolean: {
+				unsigned char value{0};
+				if(!buffer.get(value)) {
+					return state_read_t::failed;
+				}
+				sq_pushbool(impl, value ? SQTrue : SQFalse);
+				return state_read_t::value;
+			}
+			case state_tag::string: {
+				std::string str;
+				if(!detail::get_string(buffer, str)) {
+					return state_read_t::failed;
+				}
+				sq_pushstring(impl, str.c_str(), static_cast<SQInteger>(str.length()));
+				return state_read_t::value;
+			}
+			case state_tag::ref: {
+				std::uint32_t id{0};
+				if(!buffer.get(id) || id >= reader.objects.size()) {
+					return state_read_t::failed;
+				}
+				sq_pushobject(impl, reader.objects[id]);
+				return state_read_t::value;
+			}
+			default:
+			break;
 		}
 
-		SQInteger size{sq_getsize(impl, -1)};
+		if(reader.depth >= detail::state_max_depth || SQ_FAILED(sq_reservestack(impl, 8))) {
+			return state_read_t::failed;
+		}
 
-		sq_pop(impl, 1);
+		++reader.depth;
 
-		return static_cast<int>(size);
-	}
+		state_read_t res{state_read_t::value};
 
-	int squirrel::GetArrayCount_nonvirtual(gsdk::HSCRIPT obj) noexcept
-	{
-		sq_pushobject(impl, *vs_cast(obj));
+		switch(static_cast<state_tag>(tag_value)) {
+			case state_tag::table: {
+				sq_newtable(impl);
+				push_object();
 
-		SQInteger size{sq_getsize(impl, -1)};
+				res = read_state_entries(reader);
+				if(res != state_read_t::value) {
+					break;
+				}
 
-		sq_pop(impl, 1);
+				res = read_state_value(reader);
+				if(res == state_read_t::value) {
+					if(sq_gettype(impl, -1) == OT_TABLE) {
+						(void)sq_setdelegate(impl, -2);
+					} else {
+						sq_pop(impl, 1);
+					}
+				} else if(res == state_read_t::skipped) {
+					res = state_read_t::value;
+				} else {
+					res = state_read_t::failed;
+				}
+			} break;
+			case state_tag::array: {
+				std::uint32_t size{0};
+				if(!buffer.get(size)) {
+					res = state_read_t::failed;
+					break;
+				}
 
-		return static_cast<int>(size);
-	}
+				sq_newarray(impl, 0);
+				push_object();
 
-	int squirrel::GetKeyValue(gsdk::HSCRIPT obj, int it, gsdk::ScriptVariant_t *key, gsdk::ScriptVariant_t *value)
-	{
-		if(obj) {
-			sq_pushobject(impl, *vs_cast(obj));
-		} else {
-			sq_pushroottable(impl);
-		}
+				for(std::uint32_t i{0}; i < size; ++i) {
+					state_read_t elem_res{read_state_value(reader)};
+					if(elem_res == state_read_t::skipped) {
+						sq_pushnull(impl);
+					} else if(elem_res != state_read_t::value) {
+						res = state_read_t::failed;
+						break;
+					}
 
-		if(it == -1) {
-			sq_pushnull(impl);
-		} else {
-			sq_pushinteger(impl, it);
-		}
+					(void)sq_arrayappend(impl, -2);
+				}
+			} break;
+			case state_tag::closure: {
+				std::uint32_t size{0};
+				if(!buffer.get(size) || size > buffer.get_bytes_remaining()) {
+					res = state_read_t::failed;
+					break;
+				}
 
-		SQInteger next_it{-1};
+				detail::bytecode_reader_t bytecode_reader{buffer.m_Memory.data() + buffer.m_Get, size, 0};
+				buffer.m_Get += static_cast<int>(size);
 
-		if(SQ_SUCCEEDED(sq_next(impl, -2))) {
-			if(key) {
-				(void)get(-2, *key);
-			}
+				//a placeholder keeps ids in sync with the writer
+				if(SQ_FAILED(sq_readclosure(impl, detail::bytecode_read, &bytecode_reader))) {
+					sq_pushnull(impl);
+				}
 
-			if(value) {
-				(void)get(-1, *value);
-			}
+				push_object();
+			} break;
+			case state_tag::native_class: {
+				std::string name;
+				if(!detail::get_string(buffer, name)) {
+					res = state_read_t::failed;
+					break;
+				}
 
-			sq_pop(impl, 2);
+				if(name == "Vector"sv && vector_registered) {
+					sq_pushobject(impl, vector_class);
+				} else if(name == "QAngle"sv && qangle_registered) {
+					sq_pushobject(impl, qangle_class);
+				} else {
+					auto class_it{registered_classes.find(name)};
+					if(class_it != registered_classes.end()) {
+						sq_pushobject(impl, class_it->second->obj);
+					} else {
+						res = state_read_t::skipped;
+					}
+				}
+			} break;
+			case state_tag::script_class: {
+				state_read_t base_res{read_state_value(reader)};
+				if(base_res == state_read_t::failed || base_res == state_read_t::end) {
+					res = state_read_t::failed;
+					break;
+				}
 
-			(void)sq_getinteger(impl, -1, &next_it);
-		}
+				bool has_base{base_res == state_read_t::value && sq_gettype(impl, -1) == OT_CLASS};
+				if(base_res == state_read_t::value && !has_base) {
+					sq_pop(impl, 1);
+				}
 
-		sq_pop(impl, 2);
+				if(SQ_FAILED(sq_newclass(impl, has_base ? SQTrue : SQFalse))) {
+					sq_pushnull(impl);
+				}
 
-		return static_cast<int>(next_it);
-	}
+				push_object();
 
-	int squirrel::GetKeyValue2(gsdk::HSCRIPT obj, int it, gsdk::ScriptVariant_t *key, gsdk::ScriptVariant_t *value)
-	{
-		return squirrel::GetKeyValue(obj, it, key, value);
-	}
+				res = read_state_entries(reader);
+			} break;
+			case state_tag::script_instance: {
+				state_read_t class_res{read_state_value(reader)};
+				if(class_res == state_read_t::failed || class_res == state_read_t::end) {
+					res = state_read_t::failed;
+					break;
+				}
 
-	bool squirrel::GetValue_impl(gsdk::HSCRIPT obj, const char *name, gsdk::ScriptVariant_t *value)
-	{
-		if(obj) {
-			sq_pushobject(impl, *vs_cast(obj));
-		} else {
-			sq_pushroottable(impl);
-		}
+				if(class_res == state_read_t::value) {
+					if(sq_gettype(impl, -1) == OT_CLASS && SQ_SUCCEEDED(sq_createinstance(impl, -1))) {
+						sq_remove(impl, -2);
+					} else {
+						sq_pop(impl, 1);
+						sq_pushnull(impl);
+					}
+				} else {
+					sq_pushnull(impl);
+				}
 
-		sq_pushstring(impl, name, -1);
+				push_object();
 
-		bool got{SQ_SUCCEEDED(sq_get(impl, -2))};
+				res = read_state_entries(reader);
+			} break;
+			case state_tag::vector:
+			case state_tag::qangle: {
+				float xyz[3];
+				if(!buffer.get(xyz)) {
+					res = state_read_t::failed;
+					break;
+				}
 
-		if(got) {
-			got = get(-1, *value);
+				bool created{false};
+				if(static_cast<state_tag>(tag_value) == state_tag::vector) {
+					created = vector_registered && create_vector3d<gsdk::Vector>(impl, xyz[0], xyz[1], xyz[2]);
+				} else {
+					created = qangle_registered && create_vector3d<gsdk::QAngle>(impl, xyz[0], xyz[1], xyz[2]);
+				}
 
-			sq_pop(impl, 1);
-		} else {
-			value->reset();
+				if(!created) {
+					sq_pushnull(impl);
+				}
+
+				push_object();
+			} break;
+			case state_tag::native_instance: {
+				std::string name;
+				std::uint32_t size{0};
+				if(!detail::get_string(buffer, name) || !buffer.get(size) || size > buffer.get_bytes_remaining()) {
+					res = state_read_t::failed;
+					break;
+				}
+
+				int end_pos{buffer.m_Get + static_cast<int>(size)};
+
+				void *ptr{nullptr};
+
+				auto class_it{registered_classes.find(name)};
+				const gsdk::ScriptClassDesc_t *info{(class_it != registered_classes.end()) ? class_it->second->ptr : nullptr};
+				if(info) {
+					auto hooks_it{state_hooks.find(info)};
+					if(hooks_it != state_hooks.end()) {
+						ptr = hooks_it->second.read(buffer);
+					}
+				}
+
+				buffer.m_Get = end_pos;
+				buffer.m_Error &= ~gsdk::CUtlBuffer::GET_OVERFLOW;
+
+				gsdk::HSCRIPT instance{ptr ? RegisterInstance_impl_nonvirtual(const_cast<gsdk::ScriptClassDesc_t *>(info), ptr) : gsdk::INVALID_HSCRIPT};
+				if(instance && instance != gsdk::INVALID_HSCRIPT) {
+					sq_pushobject(impl, *vs_cast(instance));
+					sq_release(impl, vs_cast(instance));
+					handles.deallocate(vs_cast(instance));
+				} else {
+					sq_pushnull(impl);
+				}
+
+				push_object();
+			} break;
+			default:
+			res = state_read_t::failed;
+			break;
 		}
 
-		sq_pop(impl, 1);
+		--reader.depth;
 
-		return got;
+		return res;
 	}
 
-	bool squirrel::GetValue_impl(gsdk::HSCRIPT obj, int idx, gsdk::ScriptVariant_t *value)
+	bool squirrel::write_state(gsdk::CUtlBuffer &buffer) noexcept
 	{
-		if(obj) {
-			sq_pushobject(impl, *vs_cast(obj));
-		} else {
-			sq_pushroottable(impl);
+		int begin{buffer.m_Put};
+
+		if(!buffer.put(detail::state_magic) || !buffer.put(detail::state_version)) {
+			buffer.m_Put = begin;
+			buffer.m_nMaxPut = begin;
+			return false;
 		}
 
-		sq_pushinteger(impl, idx);
+		SQInteger top{sq_gettop(impl)};
 
-		bool got{SQ_SUCCEEDED(sq_get(impl, -2))};
+		state_writer_t writer{buffer, {}, 0, 0};
 
-		if(got) {
-			got = get(-1, *value);
+		sq_pushroottable(impl);
 
-			sq_pop(impl, 1);
-		} else {
-			value->reset();
-		}
+		HSQOBJECT root;
+		sq_resetobject(&root);
+		(void)sq_getstackobj(impl, -1, &root);
 
-		sq_pop(impl, 1);
+		//the root table is merged into the reading vm instead of being recreated
+		writer.ids.emplace(root._unVal.pRefCounted, writer.next_id++);
 
-		return got;
-	}
+		bool success{write_state_entries(writer)};
 
-	bool squirrel::GetScalarValue(gsdk::HSCRIPT obj, gsdk::ScriptVariant_t *value)
-	{
-		return get(*vs_cast(obj), *value, true);
+		sq_settop(impl, top);
+
+		if(!success || !buffer.is_valid()) {
+			buffer.m_Put = begin;
+			buffer.m_nMaxPut = begin;
+			return false;
+		}
+
+		return true;
 	}
 
-	bool squirrel::ClearValue(gsdk::HSCRIPT obj, const char *name)
+	bool squirrel::read_state(gsdk::CUtlBuffer &buffer) noexcept
 	{
-		if(obj) {
-			sq_pushobject(impl, *vs_cast(obj));
-		} else {
-			sq_pushroottable(impl);
+		std::uint32_t magic{0};
+		std::uint32_t version{0};
+		if(!buffer.get(magic) || !buffer.get(version) || magic != detail::state_magic || version != detail::state_version) {
+			return false;
 		}
 
-		sq_pushstring(impl, name, -1);
+		SQInteger top{sq_gettop(impl)};
 
-		bool removed{SQ_SUCCEEDED(sq_deleteslot(impl, -2, SQFalse))};
+		state_reader_t reader{buffer, {}, 0};
 
-		sq_pop(impl, 1);
+		sq_pushroottable(impl);
 
-		return removed;
-	}
+		HSQOBJECT root;
+		sq_resetobject(&root);
+		(void)sq_getstackobj(impl, -1, &root);
+		sq_addref(impl, &root);
+		reader.objects.emplace_back(root);
 
-	bool squirrel::IsArray_nonvirtual(gsdk::HSCRIPT obj) noexcept
-	{
-		return sq_isarray(*vs_cast(obj));
-	}
+		bool success{read_state_entries(reader) == state_read_t::value};
 
-	bool squirrel::IsArray(gsdk::HSCRIPT obj)
-	{
-		return IsArray_nonvirtual(obj);
-	}
+		sq_settop(impl, top);
 
-	int squirrel::GetArrayCount(gsdk::HSCRIPT obj)
-	{
-		return GetArrayCount_nonvirtual(obj);
+		for(HSQOBJECT &obj : reader.objects) {
+			sq_release(impl, &obj);
+		}
+
+		return success;
 	}
 
-	void squirrel::ArrayAddToTail(gsdk::HSCRIPT obj, const gsdk::ScriptVariant_t &value)
+	void squirrel::WriteState(gsdk::CUtlBuffer *buffer)
 	{
-		sq_pushobject(impl, *vs_cast(obj));
+		using namespace std::literals::string_view_literals;
 
-		if(!push(value)) {
-			sq_pop(impl, 1);
+		if(!buffer) {
 			return;
 		}
 
-		(void)sq_arrayappend(impl, -2);
-
-		sq_pop(impl, 1);
+		if(!write_state(*buffer)) {
+			warning("vmod vm: failed to write state\n"sv);
+		}
 	}
 
-	void squirrel::WriteState(gsdk::CUtlBuffer *)
+	void squirrel::ReadState(gsdk::CUtlBuffer *buffer)
 	{
-		//TODO!!!
-
-		debugtrap();
-	}
+		using namespace std::literals::string_view_literals;
 
-	void squirrel::ReadState(gsdk::CUtlBuffer *)
-	{
-		//TODO!!!
+		if(!buffer) {
+			return;
+		}
 
-		debugtrap();
+		if(!read_state(*buffer)) {
+			warning("vmod vm: failed to read state\n"sv);
+		}
 	}
 
 	void squirrel::CollectGarbage(const char *name, bool unk)
@@ -4251,12 +7008,12 @@ namespace vmod::vm
 			//TODO!!! FindCircularReferences
 		}
 
-		sq_collectgarbage(impl);
+		collect_garbage(true);
 	}
 
 	void squirrel::RemoveOrphanInstances()
 	{
-		sq_collectgarbage(impl);
+		collect_garbage(true);
 
 		//TODO!!! check ptr value of all instance_info_t
 	}
@@ -4343,6 +7100,7 @@ namespace vmod::vm
 	SQInteger squirrel::metamethod_get_call(HSQUIRRELVM vm)
 	{
 		squirrel *actual_vm{static_cast<squirrel *>(sq_getforeignptr(vm))};
+		scope_native_vm snv{*actual_vm, vm};
 
 		SQInteger top{sq_gettop(vm)};
 		if(top != 3) {
@@ -2,10 +2,19 @@
 
 #include "../../gsdk/config.hpp"
 #include "../../vscript/vscript.hpp"
+#include "../../vscript/function_desc.hpp"
 #include "../../gsdk/tier0/dbg.hpp"
 #include <unordered_map>
+#include <array>
 #include <memory>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "../vm_shared.hpp"
 
 #ifdef __VMOD_USING_QUIRREL
@@ -39,12 +48,106 @@
 namespace vmod
 {
 	class main;
+	class plugin;
 }
 
 namespace vmod::vm
 {
 	static_assert(sizeof(SQObjectType) == sizeof(int));
 
+	//fixed size slabs threaded with a free list, all slabs are released at once
+	template <typename T, std::size_t N = 256>
+	class handle_pool final
+	{
+	public:
+		handle_pool() noexcept = default;
+		inline ~handle_pool() noexcept
+		{ release(); }
+
+		T *allocate() noexcept
+		{
+			if(!free_list) {
+				grow();
+			}
+
+			node_t *node{free_list};
+			free_list = node->next;
+			++live;
+			retired = false;
+
+			return new (node->storage) T;
+		}
+
+		void deallocate(T *ptr) noexcept
+		{
+			ptr->~T();
+
+			node_t *node{reinterpret_cast<node_t *>(ptr)};
+			node->next = free_list;
+			free_list = node;
+			--live;
+
+			if(retired && live == 0) {
+				release();
+			}
+		}
+
+		void release() noexcept
+		{
+			slabs.clear();
+			free_list = nullptr;
+			live = 0;
+			retired = false;
+		}
+
+		//handles still held elsewhere keep the slabs alive, the last deallocate releases them
+		void retire() noexcept
+		{
+			if(live == 0) {
+				release();
+			} else {
+				retired = true;
+			}
+		}
+
+		inline std::size_t live_count() const noexcept
+		{ return live; }
+		inline std::size_t capacity() const noexcept
+		{ return slabs.size() * N; }
+
+	private:
+		union node_t
+		{
+			node_t *next;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		void grow() noexcept
+		{
+			std::unique_ptr<node_t[]> slab{new node_t[N]};
+
+			for(std::size_t i{0}; i < N-1; ++i) {
+				slab[i].next = &slab[i+1];
+			}
+			slab[N-1].next = free_list;
+
+			free_list = &slab[0];
+
+			slabs.emplace_back(std::move(slab));
+		}
+
+		std::vector<std::unique_ptr<node_t[]>> slabs;
+		node_t *free_list{nullptr};
+		std::size_t live{0};
+		bool retired{false};
+
+	private:
+		handle_pool(const handle_pool &) = delete;
+		handle_pool &operator=(const handle_pool &) = delete;
+		handle_pool(handle_pool &&) = delete;
+		handle_pool &operator=(handle_pool &&) = delete;
+	};
+
 	#pragma GCC diagnostic push
 	#pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
 	class squirrel final : public IScriptVM
@@ -127,6 +230,135 @@ namespace vmod::vm
 
 		gsdk::ScriptHandleWrapper_t CompileScript_strict(const char *, const char * = nullptr) noexcept;
 
+		//compiles from source only when no bytecode for the same source is cached in cache_dir
+		gsdk::HSCRIPT CompileScript_cached(const char *code, std::size_t len, const char *name, const std::filesystem::path &cache_dir) noexcept;
+
+		struct bytecode_stats_t final
+		{
+			std::size_t hits{0};
+			std::size_t misses{0};
+		};
+
+		inline const bytecode_stats_t &bytecode_cache_stats() const noexcept
+		{ return bytecode_stats; }
+		inline void reset_bytecode_cache_stats() noexcept
+		{ bytecode_stats = {}; }
+
+		struct key_stats_t final
+		{
+			std::size_t pointer_hits{0};
+			std::size_t content_hits{0};
+			std::size_t misses{0};
+		};
+
+		inline const key_stats_t &key_cache_stats() const noexcept
+		{ return key_stats; }
+
+		//sources are compiled on a private vm in the worker thread, only the bytecode crosses back
+		//returns the job id or zero when the worker is not running
+		std::size_t compile_async(std::string &&code, std::string &&name, const std::filesystem::path &cache_dir) noexcept;
+		//main thread only, the closure is loaded into this vm once the job finished
+		async_compile_status take_compiled(std::size_t id, gsdk::HSCRIPT &script) noexcept;
+		void cancel_compile(std::size_t id) noexcept;
+
+		//native instances are only carried across state snapshots through these, without them they restore as null
+		struct state_hooks_t final
+		{
+			bool(*write)(const void *ptr, gsdk::CUtlBuffer &buffer) noexcept;
+			void *(*read)(gsdk::CUtlBuffer &buffer) noexcept;
+		};
+
+		static void register_state_hooks(const gsdk::ScriptClassDesc_t *info, state_hooks_t hooks) noexcept;
+
+		bool write_state(gsdk::CUtlBuffer &buffer) noexcept;
+		bool read_state(gsdk::CUtlBuffer &buffer) noexcept;
+
+		struct gc_stats_t final
+		{
+			std::size_t collections{0};
+			std::size_t forced{0};
+			std::size_t deferred{0};
+			std::size_t objects_freed{0};
+			std::size_t last_freed{0};
+			std::chrono::nanoseconds total_time{0};
+			std::chrono::nanoseconds last_time{0};
+			std::chrono::nanoseconds max_time{0};
+		};
+
+		//a zero budget leaves collection to the engine and scripts, which is the default
+		inline void set_gc_budget(std::chrono::microseconds budget, float interval) noexcept
+		{
+			gc_budget = budget;
+			gc_interval = interval;
+		}
+
+		inline const gc_stats_t &gc_stats() const noexcept
+		{ return gc_stats_; }
+		//zero while there is nothing to base it on
+		std::chrono::nanoseconds gc_estimate() const noexcept;
+
+		//bytes handed out by the squirrel allocator, zero when the build can't count them
+		static std::size_t heap_size() noexcept;
+
+		std::size_t collect_garbage(bool forced = false) noexcept;
+
+		//samples the script call stack from the debug hook, the hook is only installed while running
+		bool start_profiling(std::chrono::microseconds interval) noexcept;
+		void stop_profiling() noexcept;
+		inline bool profiling() const noexcept
+		{ return profiling_; }
+
+		bool write_profile_collapsed(const std::filesystem::path &path) const noexcept;
+		void print_profile_top(std::size_t num) const noexcept;
+
+		//outermost ExecuteFunction calls running longer than budget are unwound, zero disables it
+		void set_watchdog(std::chrono::milliseconds budget) noexcept;
+		inline std::chrono::milliseconds watchdog() const noexcept
+		{ return watchdog_budget; }
+		inline std::size_t watchdog_aborts() const noexcept
+		{ return watchdog_aborts_; }
+
+		//resolves the handles once, the objects are only valid while the handles are
+		bool prepare_call(gsdk::HSCRIPT func, gsdk::HSCRIPT scope, HSQOBJECT &sq_func, HSQOBJECT &sq_scope) const noexcept;
+		//the ExecuteFunction path without handle lookups, null scope means the root table
+		gsdk::ScriptStatus_t call_prepared(const HSQOBJECT &func, const HSQOBJECT &scope, gsdk::ScriptVariant_t *args, std::size_t num_args, gsdk::ScriptVariant_t *ret_var, bool copyback) noexcept;
+
+		//one closure over num_sets argument sets laid out back to back, the closure is pushed once
+		//rets and statuses can be null otherwise they hold num_sets entries, returns how many calls succeeded
+		std::size_t call_prepared_batch(const HSQOBJECT &func, const HSQOBJECT &scope, gsdk::ScriptVariant_t *args, std::size_t num_args, std::size_t num_sets, gsdk::ScriptVariant_t *rets, gsdk::ScriptStatus_t *statuses) noexcept;
+
+		//many closures over the same arguments, they are converted once and stay on the stack until end_fanout
+		//vectors and angles are the exception, every call gets its own instance so one listener can't change what the next sees
+		//the arguments are never consumed so owned values must outlive the fanout
+		bool begin_fanout(const gsdk::ScriptVariant_t *args, std::size_t num_args, SQInteger &base) noexcept;
+		gsdk::ScriptStatus_t call_fanout(const HSQOBJECT &func, const HSQOBJECT &scope, SQInteger base, const gsdk::ScriptVariant_t *args, std::size_t num_args, gsdk::ScriptVariant_t *ret_var) noexcept;
+		void end_fanout(SQInteger base) noexcept;
+
+		//coroutines started by Async sleep in wait queues, a tick only touches the ones that are due
+		void run_coroutines(float curtime) noexcept;
+		//drops every coroutine the plugin started, including ones started by its coroutines
+		void cancel_coroutines(const plugin *owner) noexcept;
+		inline std::size_t coroutine_count() const noexcept
+		{ return coroutines.size(); }
+
+		//a Future for native code to hand to scripts, returns its id or zero on failure
+		std::size_t create_future(gsdk::ScriptVariant_t &var) noexcept;
+		//waiters are resumed on the next run_coroutines
+		bool resolve_future(std::size_t id, const gsdk::ScriptVariant_t &value) noexcept;
+
+		//bindings with plain scalar/string signatures skip the variant boxing, only off for benchmarking
+		inline void set_direct_bindings(bool value) noexcept
+		{ direct_bindings = value; }
+		inline bool direct_bindings_enabled() const noexcept
+		{ return direct_bindings; }
+		//times a script loop calling a trivial getter through both paths
+		bool benchmark_bindings(std::size_t iterations) noexcept;
+
+		inline std::size_t live_handles() const noexcept
+		{ return handles.live_count(); }
+		inline std::size_t handle_capacity() const noexcept
+		{ return handles.capacity(); }
+
 		HSQOBJECT vector_class;
 		HSQOBJECT qangle_class;
 
@@ -151,14 +383,90 @@ namespace vmod::vm
 		static SQInteger instance_str(HSQUIRRELVM vm);
 
 		static SQInteger instance_valid(HSQUIRRELVM vm);
+
+		static squirrel *hook_owner;
+		static void debug_hook(HSQUIRRELVM vm, SQInteger type, const SQChar *source, SQInteger line, const SQChar *func);
+		void update_debug_hook() noexcept;
+
+		struct profile_t final
+		{
+			std::chrono::microseconds interval;
+			std::chrono::steady_clock::time_point next_sample;
+			std::size_t samples{0};
+
+			//collapsed root;...;leaf stacks and leaf frames with their line
+			std::unordered_map<std::string, std::size_t> stacks;
+			std::unordered_map<std::string, std::size_t> lines;
+
+			std::string stack_buffer;
+		};
+
+		void take_profile_sample(HSQUIRRELVM vm) noexcept;
+
+		void watchdog_trip(HSQUIRRELVM vm, const SQChar *source, SQInteger line, const SQChar *func) noexcept;
+
+		struct coroutine_t final
+		{
+			HSQOBJECT thread;
+			HSQUIRRELVM vm;
+			plugin *owner;
+			std::size_t future;
+			bool scheduled;
+			bool running;
+			bool cancelled;
+		};
+
+		struct future_t final
+		{
+			HSQOBJECT value;
+			bool resolved;
+			std::vector<std::size_t> waiters;
+		};
+
+		struct future_ud_t final
+		{
+			squirrel *vm;
+			std::size_t id;
+		};
+
+		void resume_coroutine(std::size_t id) noexcept;
+		void apply_debug_hook(HSQUIRRELVM thread) const noexcept;
+		void settle_coroutine(std::size_t id, bool failed) noexcept;
+		void wait_coroutine_ticks(std::size_t id, std::size_t ticks) noexcept;
+		bool resolve_future(std::size_t id, const HSQOBJECT &value) noexcept;
+
+		static SQInteger coroutine_async(HSQUIRRELVM vm);
+		static SQInteger coroutine_wait_ticks(HSQUIRRELVM vm);
+		static SQInteger coroutine_wait_until(HSQUIRRELVM vm);
+		static SQInteger coroutine_wait_future(HSQUIRRELVM vm);
+
+		static SQInteger future_ctor(HSQUIRRELVM vm);
+		static SQInteger future_resolve(HSQUIRRELVM vm);
+		static SQInteger future_is_resolved(HSQUIRRELVM vm);
+		static SQInteger future_value(HSQUIRRELVM vm);
+		static SQInteger future_release(SQUserPointer userptr, SQInteger size);
+
 		static SQInteger instance_release_generic(SQUserPointer userptr, SQInteger size);
 		static SQInteger instance_release_external(SQUserPointer userptr, SQInteger size);
 
-		SQInteger func_call_impl(const gsdk::ScriptFunctionBinding_t *info, void *obj, std::vector<gsdk::ScriptVariant_t> &args) noexcept;
+		//closure free variable of bindings, computed once in register_func
+		struct native_binding_t final
+		{
+			const gsdk::ScriptFunctionBinding_t *info;
+			std::size_t num_required_params;
+			std::size_t num_optional_params;
+			bool variadic;
+			vscript::function_desc::direct_binding_t direct;
+		};
+
+		SQInteger func_call_impl(const gsdk::ScriptFunctionBinding_t *info, void *obj, gsdk::ScriptVariant_t *args, std::size_t num_args) noexcept;
+		SQInteger direct_func_call_impl(HSQUIRRELVM vm, const native_binding_t *binding, void *obj) noexcept;
+		SQInteger throw_last_exception(HSQUIRRELVM vm) noexcept;
 
 		bool push(const gsdk::ScriptVariant_t &var) noexcept;
 		bool get(HSQOBJECT obj, gsdk::ScriptVariant_t &var, bool scalar=false) noexcept;
-		bool get(SQInteger idx, gsdk::ScriptVariant_t &var) noexcept;
+		//borrowed vectors point into the instance on the stack and are only valid while it stays there
+		bool get(SQInteger idx, gsdk::ScriptVariant_t &var, bool borrow=false) noexcept;
 
 		static bool typemask_for_type(std::string &typemask, gsdk::ScriptDataType_t type) noexcept;
 
@@ -168,6 +476,70 @@ namespace vmod::vm
 
 		gsdk::HSCRIPT compile_script() noexcept;
 
+		std::uint64_t const_table_hash() noexcept;
+
+		//safe after Shutdown, handles can be held past the vm
+		void release_handle(HSQOBJECT *obj) noexcept;
+
+		//compile time constants are resolved by the compiler so the worker needs a copy of the const table
+		struct compile_const_t final
+		{
+			std::string name;
+			SQObjectType type{OT_NULL};
+			SQInteger int_value{0};
+			SQFloat float_value{0};
+			std::string str_value;
+			std::vector<compile_const_t> members;
+		};
+
+		struct compile_job_t final
+		{
+			std::size_t id{0};
+			std::string code;
+			std::string name;
+			std::filesystem::path cache_dir;
+			std::filesystem::path cache_path;
+			std::vector<compile_const_t> consts;
+			std::vector<unsigned char> bytecode;
+			std::string errors;
+			//debug_vm can change after the worker starts, each job carries the value it was keyed with
+			bool debug_info{false};
+			bool from_cache{false};
+			bool failed{false};
+		};
+
+		void snapshot_consts(std::vector<compile_const_t> &consts) noexcept;
+
+		bool start_compile_worker() noexcept;
+		void stop_compile_worker() noexcept;
+		void compile_worker() noexcept;
+		static void run_compile_job(HSQUIRRELVM vm, compile_job_t &job) noexcept;
+
+		static void compile_print_func(HSQUIRRELVM vm, const SQChar *fmt, ...) __attribute__((__format__(__printf__, 2, 3)));
+	#ifdef __VMOD_USING_QUIRREL
+		static void compile_worker_err_func(HSQUIRRELVM vm, const SQChar *desc, const SQChar *src, SQInteger line, SQInteger column, const SQChar *extra);
+	#endif
+
+		void push_key(const char *name) noexcept;
+
+		struct state_writer_t;
+		struct state_reader_t;
+
+		enum class state_read_t : unsigned char
+		{
+			failed,
+			value,
+			skipped,
+			end
+		};
+
+		bool write_state_value(state_writer_t &writer) noexcept;
+		bool write_state_entries(state_writer_t &writer) noexcept;
+		state_read_t read_state_value(state_reader_t &reader) noexcept;
+		state_read_t read_state_entries(state_reader_t &reader) noexcept;
+
+		static std::unordered_map<const gsdk::ScriptClassDesc_t *, state_hooks_t> state_hooks;
+
 		void get_obj(gsdk::ScriptVariant_t &value) noexcept;
 
 		bool debug_vm{false};
@@ -177,6 +549,61 @@ namespace vmod::vm
 
 		HSQUIRRELVM impl{nullptr};
 
+		handle_pool<HSQOBJECT> handles;
+
+		bytecode_stats_t bytecode_stats;
+
+		std::chrono::microseconds gc_budget{0};
+		float gc_interval{5.0f};
+		float gc_elapsed{0.0f};
+		std::chrono::nanoseconds gc_estimate_{0};
+		double gc_ns_per_byte{0.0};
+		std::chrono::steady_clock::time_point gc_last_frame;
+		std::size_t gc_on_time_frames{0};
+		gc_stats_t gc_stats_;
+
+		std::unique_ptr<profile_t> profile;
+		bool profiling_{false};
+
+		std::chrono::milliseconds watchdog_budget{0};
+		std::chrono::steady_clock::time_point watchdog_deadline;
+		std::size_t watchdog_depth{0};
+		bool watchdog_tripped{false};
+		std::size_t watchdog_aborts_{0};
+
+		struct scope_watchdog;
+
+		//natives run on whichever thread called them, coroutines included
+		struct scope_native_vm;
+
+		//expects the closure, the environment and num_args values pushed, leaves the closure on the stack
+		gsdk::ScriptStatus_t finish_call(gsdk::ScriptVariant_t *args, std::size_t num_args, gsdk::ScriptVariant_t *ret_var, bool copyback) noexcept;
+
+		bool direct_bindings{true};
+
+		std::unordered_map<std::size_t, coroutine_t> coroutines;
+		std::size_t coroutine_ids{0};
+		std::size_t running_coroutine{0};
+		std::size_t coroutine_tick{0};
+		float coroutine_time{0.0f};
+		std::vector<std::pair<std::size_t, std::size_t>> tick_waits;
+		std::vector<std::pair<float, std::size_t>> time_waits;
+		std::vector<std::size_t> ready_coroutines;
+		std::vector<std::size_t> ready_coroutines_swap;
+
+		std::unordered_map<std::size_t, future_t> futures;
+		std::size_t future_ids{0};
+
+		HSQUIRRELVM compile_vm{nullptr};
+		std::jthread compile_thread;
+		std::mutex compile_mx;
+		std::condition_variable compile_cv;
+		bool compile_stop{false};
+		std::deque<std::unique_ptr<compile_job_t>> compile_queue;
+		std::unordered_map<std::size_t, std::unique_ptr<compile_job_t>> compile_done;
+		std::size_t compile_running{0};
+		std::size_t compile_ids{0};
+
 	#ifdef __VMOD_USING_QUIRREL
 		std::unique_ptr<SqModules> modules;
 	#endif
@@ -187,6 +614,9 @@ namespace vmod::vm
 
 		bool qangle_registered{false};
 
+		HSQOBJECT future_class;
+		bool future_registered{false};
+
 		HSQOBJECT create_scope_func;
 		bool got_create_scope{false};
 
@@ -202,6 +632,43 @@ namespace vmod::vm
 		HSQOBJECT last_exception;
 		bool got_last_exception{false};
 
+		struct key_hash final
+		{
+			using is_transparent = void;
+
+			inline std::size_t operator()(std::string_view str) const noexcept
+			{ return std::hash<std::string_view>{}(str); }
+		};
+
+		struct key_equal final
+		{
+			using is_transparent = void;
+
+			inline bool operator()(std::string_view lhs, std::string_view rhs) const noexcept
+			{ return lhs == rhs; }
+		};
+
+		//interned slot names pinned with a ref so lookups skip sq_pushstring
+		static constexpr std::size_t max_cached_keys{4096};
+
+		using key_cache_t = std::unordered_map<std::string, HSQOBJECT, key_hash, key_equal>;
+
+		key_cache_t key_cache;
+
+		//callers mostly pass the same literal every time, so the pointer is tried before hashing the contents
+		//names can also come from reused buffers, a slot only hits when its contents still match
+		struct key_slot_t final
+		{
+			const char *name{nullptr};
+			key_cache_t::const_pointer entry{nullptr};
+		};
+
+		static constexpr std::size_t num_key_slots{256};
+
+		std::array<key_slot_t, num_key_slots> key_slots;
+
+		key_stats_t key_stats;
+
 		struct instance_info_t
 		{
 			instance_info_t(instance_info_t &&) noexcept = default;
@@ -18,6 +18,207 @@ namespace vmod
 		}
 	}
 
+	gsdk::ScriptHandleWrapper_t compile_cached_script(gsdk::IScriptVM *vm, const char *code, std::size_t len, const char *name, const std::filesystem::path &cache_dir) noexcept
+	{
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm->GetLanguage() == gsdk::SL_SQUIRREL) {
+			gsdk::ScriptHandleWrapper_t tmp{};
+			tmp.should_free_ = true;
+			tmp.object = static_cast<vm::squirrel *>(vm)->CompileScript_cached(code, len, name, cache_dir);
+			tmp.type = gsdk::HANDLETYPE_SCRIPT;
+
+			return tmp;
+		} else
+	#endif
+		{
+			return vm->CompileScript(code, name);
+		}
+	}
+
+	std::size_t compile_script_async(gsdk::IScriptVM *vm, std::string &&code, const char *name, const std::filesystem::path &cache_dir) noexcept
+	{
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm->GetLanguage() == gsdk::SL_SQUIRREL) {
+			return static_cast<vm::squirrel *>(vm)->compile_async(std::move(code), name, cache_dir);
+		}
+	#else
+		(void)vm;
+		(void)code;
+		(void)name;
+		(void)cache_dir;
+	#endif
+
+		return 0;
+	}
+
+	async_compile_status take_async_script(gsdk::IScriptVM *vm, std::size_t id, gsdk::ScriptHandleWrapper_t &script) noexcept
+	{
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm->GetLanguage() == gsdk::SL_SQUIRREL) {
+			gsdk::HSCRIPT object{gsdk::INVALID_HSCRIPT};
+			async_compile_status status{static_cast<vm::squirrel *>(vm)->take_compiled(id, object)};
+			if(status == async_compile_status::done) {
+				script.should_free_ = true;
+				script.object = object;
+				script.type = gsdk::HANDLETYPE_SCRIPT;
+			}
+
+			return status;
+		}
+	#else
+		(void)vm;
+		(void)id;
+		(void)script;
+	#endif
+
+		return async_compile_status::failed;
+	}
+
+	void cancel_async_script(gsdk::IScriptVM *vm, std::size_t id) noexcept
+	{
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm->GetLanguage() == gsdk::SL_SQUIRREL) {
+			static_cast<vm::squirrel *>(vm)->cancel_compile(id);
+		}
+	#else
+		(void)vm;
+		(void)id;
+	#endif
+	}
+
+	bool prepared_call::prepare(gsdk::IScriptVM *vm, gsdk::HSCRIPT func_, gsdk::HSCRIPT scope_) noexcept
+	{
+		reset();
+
+		if(!func_ || func_ == gsdk::INVALID_HSCRIPT) {
+			return false;
+		}
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		squirrel = (vm->GetLanguage() == gsdk::SL_SQUIRREL);
+		if(squirrel) {
+			if(!static_cast<vm::squirrel *>(vm)->prepare_call(func_, scope_, sq_func, sq_scope)) {
+				return false;
+			}
+		}
+	#else
+		(void)vm;
+	#endif
+
+		func = func_;
+		scope = scope_;
+		return true;
+	}
+
+	gsdk::ScriptStatus_t prepared_call::execute(gsdk::IScriptVM *vm, gsdk::ScriptVariant_t *args, std::size_t num_args, gsdk::ScriptVariant_t *ret, bool copyback) noexcept
+	{
+		if(!func) {
+			for(std::size_t i{0}; i < num_args; ++i) {
+				args[i].free();
+			}
+			return gsdk::SCRIPT_ERROR;
+		}
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(squirrel) {
+			return static_cast<vm::squirrel *>(vm)->call_prepared(sq_func, sq_scope, args, num_args, ret, copyback);
+		} else
+	#endif
+		{
+			unsigned char execflags{gsdk::SCRIPT_EXEC_WAIT};
+			if(copyback) {
+				execflags |= gsdk::SCRIPT_EXEC_COPYBACK;
+			}
+
+			return vm->ExecuteFunction(func, args, static_cast<int>(num_args), ret, scope, static_cast<gsdk::ScriptExecuteFlags_t>(execflags));
+		}
+	}
+
+	std::size_t prepared_call::execute_batch(gsdk::IScriptVM *vm, gsdk::ScriptVariant_t *args, std::size_t num_args, std::size_t num_sets, gsdk::ScriptVariant_t *rets, gsdk::ScriptStatus_t *statuses) noexcept
+	{
+		if(!func) {
+			for(std::size_t i{0}; i < (num_args * num_sets); ++i) {
+				args[i].free();
+			}
+			if(statuses) {
+				for(std::size_t i{0}; i < num_sets; ++i) {
+					statuses[i] = gsdk::SCRIPT_ERROR;
+				}
+			}
+			return 0;
+		}
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(squirrel) {
+			return static_cast<vm::squirrel *>(vm)->call_prepared_batch(sq_func, sq_scope, args, num_args, num_sets, rets, statuses);
+		} else
+	#endif
+		{
+			std::size_t succeeded{0};
+
+			for(std::size_t i{0}; i < num_sets; ++i) {
+				gsdk::ScriptStatus_t status{vm->ExecuteFunction(func, args + (i * num_args), static_cast<int>(num_args), rets ? &rets[i] : nullptr, scope, true)};
+				if(status != gsdk::SCRIPT_ERROR) {
+					++succeeded;
+				}
+				if(statuses) {
+					statuses[i] = status;
+				}
+			}
+
+			return succeeded;
+		}
+	}
+
+	fanout_call::fanout_call(gsdk::IScriptVM *vm_, gsdk::ScriptVariant_t *args_, std::size_t num_args_) noexcept
+		: vm{vm_}, args{args_}, num_args{num_args_}
+	{
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(vm->GetLanguage() == gsdk::SL_SQUIRREL) {
+			pushed = static_cast<vm::squirrel *>(vm)->begin_fanout(args, num_args, base);
+		}
+	#endif
+	}
+
+	fanout_call::~fanout_call() noexcept
+	{
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(pushed) {
+			static_cast<vm::squirrel *>(vm)->end_fanout(base);
+		}
+	#endif
+	}
+
+	gsdk::ScriptStatus_t fanout_call::execute(prepared_call &call, gsdk::ScriptVariant_t *ret) noexcept
+	{
+		if(!call.func) {
+			return gsdk::SCRIPT_ERROR;
+		}
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if(call.squirrel) {
+			//the squirrel path would consume owned args so a failed conversion fails every call
+			if(!pushed) {
+				return gsdk::SCRIPT_ERROR;
+			}
+
+			return static_cast<vm::squirrel *>(vm)->call_fanout(call.sq_func, call.sq_scope, base, args, num_args, ret);
+		} else
+	#endif
+		{
+			//ExecuteFunction frees owned args, every call gets borrowed copies so the next one still has them
+			if(num_args > 0 && !copies) {
+				copies.reset(new gsdk::ScriptVariant_t[num_args]);
+			}
+
+			for(std::size_t i{0}; i < num_args; ++i) {
+				copies[i] = args[i];
+			}
+
+			return vm->ExecuteFunction(call.func, copies.get(), static_cast<int>(num_args), ret, call.scope, true);
+		}
+	}
+
 	bool compile_internal_script(gsdk::IScriptVM *vm, std::filesystem::path path, const unsigned char *data, gsdk::HSCRIPT &object, bool &from_file) noexcept
 	{
 		using namespace std::literals::string_view_literals;
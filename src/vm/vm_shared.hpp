@@ -4,7 +4,9 @@
 #include "../vscript/vscript.hpp"
 #include "../vscript/variant.hpp"
 #include <filesystem>
+#include <string>
 #include <string_view>
+#include <memory>
 
 #if GSDK_ENGINE == GSDK_ENGINE_L4D2 || GSDK_ENGINE == GSDK_ENGINE_TF2
 	#define __VMOD_CUSTOM_VM_L4D2_TF2_OVERRIDE override
@@ -52,6 +54,90 @@ namespace vmod
 
 	extern bool compile_internal_script(gsdk::IScriptVM *vm, std::filesystem::path path, const unsigned char *data, gsdk::HSCRIPT &object, bool &from_file) noexcept;
 
+	extern gsdk::ScriptHandleWrapper_t compile_cached_script(gsdk::IScriptVM *vm, const char *code, std::size_t len, const char *name, const std::filesystem::path &cache_dir) noexcept;
+
+	enum class async_compile_status : unsigned char
+	{
+		pending,
+		done,
+		failed
+	};
+
+	//zero means the vm can't compile off the main thread and compile_cached_script should be used instead
+	extern std::size_t compile_script_async(gsdk::IScriptVM *vm, std::string &&code, const char *name, const std::filesystem::path &cache_dir) noexcept;
+	extern async_compile_status take_async_script(gsdk::IScriptVM *vm, std::size_t id, gsdk::ScriptHandleWrapper_t &script) noexcept;
+	extern void cancel_async_script(gsdk::IScriptVM *vm, std::size_t id) noexcept;
+
+	//a function and scope bound once for repeated calls from c++
+	//only valid while the handles it was prepared from are, reset it whenever they change
+	class prepared_call final
+	{
+	public:
+		prepared_call() noexcept = default;
+		prepared_call(const prepared_call &) noexcept = default;
+		prepared_call &operator=(const prepared_call &) noexcept = default;
+
+		bool prepare(gsdk::IScriptVM *vm, gsdk::HSCRIPT func_, gsdk::HSCRIPT scope_) noexcept;
+
+		inline void reset() noexcept
+		{
+			func = nullptr;
+			scope = nullptr;
+		}
+
+		inline bool prepared_for(gsdk::HSCRIPT func_, gsdk::HSCRIPT scope_) const noexcept
+		{ return (func && func == func_ && scope == scope_); }
+
+		//same ownership rules as ExecuteFunction, args marked SV_FREE are consumed unless copyback is set
+		gsdk::ScriptStatus_t execute(gsdk::IScriptVM *vm, gsdk::ScriptVariant_t *args, std::size_t num_args, gsdk::ScriptVariant_t *ret, bool copyback = false) noexcept;
+
+		//num_sets calls with argument sets laid out back to back, rets and statuses are optional
+		//returns how many calls succeeded
+		std::size_t execute_batch(gsdk::IScriptVM *vm, gsdk::ScriptVariant_t *args, std::size_t num_args, std::size_t num_sets, gsdk::ScriptVariant_t *rets, gsdk::ScriptStatus_t *statuses) noexcept;
+
+	private:
+		friend class fanout_call;
+
+		gsdk::HSCRIPT func{nullptr};
+		gsdk::HSCRIPT scope{nullptr};
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		bool squirrel{false};
+		HSQOBJECT sq_func;
+		HSQOBJECT sq_scope;
+	#endif
+	};
+
+	//calls many prepared functions with the same arguments, they are only converted once
+	//args are borrowed for the lifetime of the fanout and never consumed
+	class fanout_call final
+	{
+	public:
+		fanout_call(gsdk::IScriptVM *vm_, gsdk::ScriptVariant_t *args_, std::size_t num_args_) noexcept;
+		~fanout_call() noexcept;
+
+		gsdk::ScriptStatus_t execute(prepared_call &call, gsdk::ScriptVariant_t *ret) noexcept;
+
+	private:
+		gsdk::IScriptVM *vm;
+		gsdk::ScriptVariant_t *args;
+		std::size_t num_args;
+
+		std::unique_ptr<gsdk::ScriptVariant_t[]> copies;
+
+	#ifdef __VMOD_USING_CUSTOM_VM
+		bool pushed{false};
+		SQInteger base{0};
+	#endif
+
+	private:
+		fanout_call() = delete;
+		fanout_call(const fanout_call &) = delete;
+		fanout_call &operator=(const fanout_call &) = delete;
+		fanout_call(fanout_call &&) = delete;
+		fanout_call &operator=(fanout_call &&) = delete;
+	};
+
 	inline bool compile_internal_script(gsdk::IScriptVM *vm, std::filesystem::path path, const unsigned char *data, vscript::handle_wrapper &object, bool &from_file) noexcept
 	{
 		gsdk::ScriptHandleWrapper_t tmp{};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vscript.hpp"
+#include <unordered_map>
 
 namespace vmod::vscript
 {
@@ -33,6 +34,23 @@ namespace vmod::vscript
 			m_desc.m_pszDescription = description.data();
 		}
 
+	#ifdef __VMOD_USING_CUSTOM_VM
+		//reads args straight from the squirrel stack and pushes the return
+		//returns direct_fallback when an arg needs the variant conversions instead
+		using direct_binding_t = SQInteger(*)(HSQUIRRELVM vm, const gsdk::ScriptFunctionBinding_t *info, void *obj, SQInteger first_arg) noexcept;
+		static constexpr SQInteger direct_fallback{-2};
+
+		static inline direct_binding_t find_direct(const gsdk::ScriptFunctionBinding_t *info) noexcept
+		{
+			auto it{direct_bindings().find(info->m_pfnBinding)};
+			if(it == direct_bindings().end()) {
+				return nullptr;
+			}
+
+			return it->second;
+		}
+	#endif
+
 	private:
 		function_desc(function_desc &&other) noexcept = default;
 		function_desc &operator=(function_desc &&other) noexcept = default;
@@ -119,6 +137,30 @@ namespace vmod::vscript
 		static inline R call_va(R(*func)(Args..., ...), std::size_t num_args, gsdk::ScriptVariant_t *args, gsdk::ScriptVariant_t *args_va, std::size_t num_va) noexcept
 		{ return call_va_impl<R, Args...>(func, num_args, args, args_va, num_va, std::make_index_sequence<sizeof...(Args)>()); }
 
+	#ifdef __VMOD_USING_CUSTOM_VM
+		//keyed by m_pfnBinding, every signature shares one entry
+		static inline std::unordered_map<gsdk::ScriptBindingFunc_t, direct_binding_t> &direct_bindings() noexcept
+		{
+			static std::unordered_map<gsdk::ScriptBindingFunc_t, direct_binding_t> bindings;
+			return bindings;
+		}
+
+		template <typename R, typename C, typename ...Args>
+		static SQInteger direct_binding_member_singleton(HSQUIRRELVM vm, const gsdk::ScriptFunctionBinding_t *info, void *obj, SQInteger first_arg) noexcept;
+
+		template <typename R, typename C, typename ...Args>
+		static SQInteger direct_binding_member(HSQUIRRELVM vm, const gsdk::ScriptFunctionBinding_t *info, void *obj, SQInteger first_arg) noexcept;
+
+		template <typename R, typename ...Args>
+		static SQInteger direct_binding(HSQUIRRELVM vm, const gsdk::ScriptFunctionBinding_t *info, void *obj, SQInteger first_arg) noexcept;
+
+		template <typename R, typename C, typename ...Args, std::size_t ...I>
+		static SQInteger direct_call_member_impl(R(C::*func)(Args...), C *obj, HSQUIRRELVM vm, SQInteger first_arg, std::index_sequence<I...>) noexcept;
+
+		template <typename R, typename ...Args, std::size_t ...I>
+		static SQInteger direct_call_impl(R(*func)(Args...), HSQUIRRELVM vm, SQInteger first_arg, std::index_sequence<I...>) noexcept;
+	#endif
+
 	private:
 		function_desc(const function_desc &) = delete;
 		function_desc &operator=(const function_desc &) = delete;
@@ -423,6 +423,215 @@ namespace vmod::vscript
 		return true;
 	}
 
+#ifdef __VMOD_USING_CUSTOM_VM
+	namespace detail
+	{
+		template <typename T>
+		constexpr bool is_direct_integral_v{
+			std::is_integral_v<T> &&
+			!std::is_same_v<T, bool> &&
+			!std::is_same_v<T, char> &&
+			!std::is_same_v<T, signed char> &&
+			!std::is_same_v<T, unsigned char> &&
+			!std::is_same_v<T, char8_t> &&
+			!std::is_same_v<T, char16_t> &&
+			!std::is_same_v<T, char32_t> &&
+			!std::is_same_v<T, wchar_t>
+		};
+
+		//only plain scalars and strings, everything else keeps going through variants
+		template <typename T>
+		static constexpr bool is_direct_arg() noexcept
+		{
+			if constexpr(std::is_reference_v<T> && !std::is_const_v<std::remove_reference_t<T>>) {
+				return false;
+			} else {
+				using decayed_t = std::decay_t<T>;
+
+				return (
+					std::is_same_v<decayed_t, bool> ||
+					is_direct_integral_v<decayed_t> ||
+					std::is_floating_point_v<decayed_t> ||
+					std::is_same_v<decayed_t, std::string_view>
+				);
+			}
+		}
+
+		template <typename T>
+		static constexpr bool is_direct_ret() noexcept
+		{
+			using decayed_t = std::decay_t<T>;
+
+			return (
+				std::is_void_v<T> ||
+				std::is_same_v<decayed_t, bool> ||
+				is_direct_integral_v<decayed_t> ||
+				std::is_floating_point_v<decayed_t> ||
+				std::is_same_v<decayed_t, std::string_view> ||
+				std::is_same_v<decayed_t, std::string>
+			);
+		}
+
+		template <typename R, typename ...Args>
+		static constexpr bool is_direct_signature() noexcept
+		{ return is_direct_ret<R>() && (is_direct_arg<Args>() && ...); }
+
+		//strict on purpose, any conversion is left to the variant path
+		template <typename T>
+		static bool direct_get(HSQUIRRELVM vm, SQInteger idx, T &value) noexcept
+		{
+			if constexpr(std::is_same_v<T, bool>) {
+				if(sq_gettype(vm, idx) != OT_BOOL) {
+					return false;
+				}
+
+				SQBool tmp{SQFalse};
+				(void)sq_getbool(vm, idx, &tmp);
+				value = (tmp != SQFalse);
+				return true;
+			} else if constexpr(is_direct_integral_v<T>) {
+				if(sq_gettype(vm, idx) != OT_INTEGER) {
+					return false;
+				}
+
+				SQInteger tmp{0};
+				(void)sq_getinteger(vm, idx, &tmp);
+				value = static_cast<T>(tmp);
+				return true;
+			} else if constexpr(std::is_floating_point_v<T>) {
+				SQObjectType type{sq_gettype(vm, idx)};
+				if(type != OT_FLOAT && type != OT_INTEGER) {
+					return false;
+				}
+
+				SQFloat tmp{0.0f};
+				(void)sq_getfloat(vm, idx, &tmp);
+				value = static_cast<T>(tmp);
+				return true;
+			} else if constexpr(std::is_same_v<T, std::string_view>) {
+				if(sq_gettype(vm, idx) != OT_STRING) {
+					return false;
+				}
+
+				const SQChar *str{nullptr};
+				SQInteger len{0};
+				(void)sq_getstringandsize(vm, idx, &str, &len);
+				value = std::string_view{str, static_cast<std::size_t>(len)};
+				return true;
+			} else {
+				static_assert(false_t<T>::value);
+			}
+		}
+
+		template <typename T>
+		static void direct_push(HSQUIRRELVM vm, const T &value) noexcept
+		{
+			if constexpr(std::is_same_v<T, bool>) {
+				sq_pushbool(vm, value ? SQTrue : SQFalse);
+			} else if constexpr(is_direct_integral_v<T>) {
+				sq_pushinteger(vm, static_cast<SQInteger>(value));
+			} else if constexpr(std::is_floating_point_v<T>) {
+				sq_pushfloat(vm, static_cast<SQFloat>(value));
+			} else if constexpr(std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>) {
+				sq_pushstring(vm, value.data(), static_cast<SQInteger>(value.length()));
+			} else {
+				static_assert(false_t<T>::value);
+			}
+		}
+	}
+
+	template <typename R, typename C, typename ...Args, std::size_t ...I>
+	SQInteger function_desc::direct_call_member_impl(R(C::*func)(Args...), C *obj, HSQUIRRELVM vm, SQInteger first_arg, std::index_sequence<I...>) noexcept
+	{
+		[[maybe_unused]] std::tuple<std::decay_t<Args>...> values;
+
+		if constexpr(sizeof...(Args) > 0) {
+			if(!(detail::direct_get(vm, first_arg + static_cast<SQInteger>(I), std::get<I>(values)) && ...)) {
+				return direct_fallback;
+			}
+		}
+
+		if constexpr(std::is_void_v<R>) {
+			(obj->*func)(std::get<I>(values)...);
+			return 0;
+		} else {
+			detail::direct_push<std::decay_t<R>>(vm, (obj->*func)(std::get<I>(values)...));
+			return 1;
+		}
+	}
+
+	template <typename R, typename ...Args, std::size_t ...I>
+	SQInteger function_desc::direct_call_impl(R(*func)(Args...), HSQUIRRELVM vm, SQInteger first_arg, std::index_sequence<I...>) noexcept
+	{
+		[[maybe_unused]] std::tuple<std::decay_t<Args>...> values;
+
+		if constexpr(sizeof...(Args) > 0) {
+			if(!(detail::direct_get(vm, first_arg + static_cast<SQInteger>(I), std::get<I>(values)) && ...)) {
+				return direct_fallback;
+			}
+		}
+
+		if constexpr(std::is_void_v<R>) {
+			func(std::get<I>(values)...);
+			return 0;
+		} else {
+			detail::direct_push<std::decay_t<R>>(vm, func(std::get<I>(values)...));
+			return 1;
+		}
+	}
+
+	template <typename R, typename C, typename ...Args>
+	SQInteger function_desc::direct_binding_member_singleton(HSQUIRRELVM vm, const gsdk::ScriptFunctionBinding_t *info, void *obj_ptr, SQInteger first_arg) noexcept
+	{
+		if(!obj_ptr) {
+			if constexpr(class_is_singleton_v<C>) {
+				obj_ptr = &C::instance();
+			} else {
+				return direct_fallback;
+			}
+		}
+
+		return direct_binding_member<R, C, Args...>(vm, info, obj_ptr, first_arg);
+	}
+
+	template <typename R, typename C, typename ...Args>
+	SQInteger function_desc::direct_binding_member(HSQUIRRELVM vm, const gsdk::ScriptFunctionBinding_t *info, void *obj_ptr, SQInteger first_arg) noexcept
+	{
+		//let the variant path report the error
+		if(!obj_ptr) {
+			return direct_fallback;
+		}
+
+		#pragma GCC diagnostic push
+		#pragma GCC diagnostic ignored "-Wcast-function-type"
+	#if GSDK_ENGINE == GSDK_ENGINE_TF2
+		R(C::*func)(Args...){reinterpret_cast<R(C::*)(Args...)>(info->m_pFunction.mfp)};
+	#elif GSDK_CHECK_BRANCH_VER(GSDK_ENGINE_BRANCH_2010, >=, GSDK_ENGINE_BRANCH_2010_V0)
+		R(C::*func)(Args...){mfp_from_func(reinterpret_cast<R(__attribute__((__thiscall__)) *)(C *, Args...)>(info->m_pFunction.plain))};
+	#else
+		#error
+	#endif
+		#pragma GCC diagnostic pop
+
+		return direct_call_member_impl<R, C, Args...>(func, static_cast<C *>(obj_ptr), vm, first_arg, std::make_index_sequence<sizeof...(Args)>());
+	}
+
+	template <typename R, typename ...Args>
+	SQInteger function_desc::direct_binding(HSQUIRRELVM vm, const gsdk::ScriptFunctionBinding_t *info, void *obj_ptr, SQInteger first_arg) noexcept
+	{
+		if(obj_ptr) {
+			return direct_fallback;
+		}
+
+		#pragma GCC diagnostic push
+		#pragma GCC diagnostic ignored "-Wcast-function-type"
+		R(*func)(Args...){reinterpret_cast<R(*)(Args...)>(info->m_pFunction.func)};
+		#pragma GCC diagnostic pop
+
+		return direct_call_impl<R, Args...>(func, vm, first_arg, std::make_index_sequence<sizeof...(Args)>());
+	}
+#endif
+
 	template <typename R, typename C, typename ...Args>
 	void function_desc::initialize_member(R(C::*func)(Args...), std::string_view name, std::string_view script_name)
 	{
@@ -444,6 +653,11 @@ namespace vmod::vscript
 		m_pfnBinding = static_cast<gsdk::ScriptBindingFunc_t>(binding_member<R, C, Args...>);
 		m_flags = gsdk::SF_MEMBER_FUNC;
 		initialize_shared<R, Args...>(name, script_name, false);
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if constexpr(detail::is_direct_signature<R, Args...>()) {
+			direct_bindings().emplace(m_pfnBinding, static_cast<direct_binding_t>(direct_binding_member<R, C, Args...>));
+		}
+	#endif
 	}
 
 	template <typename R, typename C, typename ...Args>
@@ -479,6 +693,11 @@ namespace vmod::vscript
 		m_pfnBinding = static_cast<gsdk::ScriptBindingFunc_t>(binding<R, Args...>);
 		m_flags = 0;
 		initialize_shared<R, Args...>(name, script_name, false);
+	#ifdef __VMOD_USING_CUSTOM_VM
+		if constexpr(detail::is_direct_signature<R, Args...>()) {
+			direct_bindings().emplace(m_pfnBinding, static_cast<direct_binding_t>(direct_binding<R, Args...>));
+		}
+	#endif
 	}
 
 	template <typename R, typename ...Args>
@@ -71,6 +71,11 @@ namespace vmod::vscript
 				desc.m_pfnBinding = static_cast<gsdk::ScriptBindingFunc_t>(function_desc::binding_member_singleton_va<R, T, Args...>);
 			} else {
 				desc.m_pfnBinding = static_cast<gsdk::ScriptBindingFunc_t>(function_desc::binding_member_singleton<R, T, Args...>);
+			#ifdef __VMOD_USING_CUSTOM_VM
+				if constexpr(detail::is_direct_signature<R, Args...>()) {
+					function_desc::direct_bindings().emplace(desc.m_pfnBinding, static_cast<function_desc::direct_binding_t>(function_desc::direct_binding_member_singleton<R, T, Args...>));
+				}
+			#endif
 			}
 		}
 
@@ -5,3 +5,4 @@
 extern void *sq_vm_malloc(SQUnsignedInteger);
 extern void *sq_vm_realloc(void *, SQUnsignedInteger, SQUnsignedInteger);
 extern void sq_vm_free(void *, SQUnsignedInteger);
+extern SQUnsignedInteger sq_vm_allocated();
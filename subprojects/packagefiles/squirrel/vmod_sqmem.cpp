@@ -0,0 +1,34 @@
+#include <squirrel.h>
+#include <cstdlib>
+#include <atomic>
+
+//the default allocator plus a running total so vmod can report the vm heap
+//atomic because vmod compiles on a second vm in a worker thread
+static std::atomic<SQUnsignedInteger> vmod_allocated{0};
+
+void *sq_vm_malloc(SQUnsignedInteger size)
+{
+	vmod_allocated.fetch_add(size, std::memory_order_relaxed);
+	return std::malloc(size);
+}
+
+void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size)
+{
+	void *newp{std::realloc(p, size)};
+	if(newp || size == 0) {
+		vmod_allocated.fetch_add(size, std::memory_order_relaxed);
+		vmod_allocated.fetch_sub(oldsize, std::memory_order_relaxed);
+	}
+	return newp;
+}
+
+void sq_vm_free(void *p, SQUnsignedInteger size)
+{
+	vmod_allocated.fetch_sub(size, std::memory_order_relaxed);
+	std::free(p);
+}
+
+SQUnsignedInteger sq_vm_allocated()
+{
+	return vmod_allocated.load(std::memory_order_relaxed);
+}